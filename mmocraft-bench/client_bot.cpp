@@ -32,7 +32,7 @@ namespace bench
     ClientBot::ClientBot(io::IoService& io_service)
         : _id{ client_counter.fetch_add(1, std::memory_order_relaxed) }
         , _sock{ net::create_windows_socket(net::socket_protocol_id::tcp_rio_v4) }
-        , last_interactin_at{util::current_monotonic_tick()}
+        , last_interactin_at{util::coarse_monotonic_tick()}
     {
         // Create socket for client
         win::UniqueSocket sock{ _sock };
@@ -131,7 +131,7 @@ namespace bench
             return 0;
         }
 
-        last_interactin_at = util::current_monotonic_tick();
+        last_interactin_at = util::coarse_monotonic_tick();
         event->is_processing = false;
         return 0;
     }
@@ -148,7 +148,7 @@ namespace bench
 
     std::size_t ClientBot::handle_io_event(io::IoSendEvent*)
     {
-        last_interactin_at = util::current_monotonic_tick();
+        last_interactin_at = util::coarse_monotonic_tick();
         return 0;
     }
 
@@ -161,7 +161,7 @@ namespace bench
 
     std::size_t ClientBot::handle_io_event(io::IoRecvEvent* event)
     {
-        last_interactin_at = util::current_monotonic_tick();
+        last_interactin_at = util::coarse_monotonic_tick();
 
         auto data_begin = event->event_data()->begin();
         const auto data_end = event->event_data()->end();
@@ -57,7 +57,7 @@ namespace bench
 
         bool is_safe_delete() const
         {
-            return last_interactin_at + 5 * 1000 < util::current_monotonic_tick();
+            return last_interactin_at + 5 * 1000 < util::coarse_monotonic_tick();
         }
 
         /* IOEvent handlers */
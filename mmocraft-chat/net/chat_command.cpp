@@ -36,8 +36,8 @@ namespace net
         util::string_copy(_receiver_player_name, tokens[1]);
         auto message = tokens[2];
 
-        format_from_message(_sender_response, _sender_player_name, message);
-        format_to_message(_receiver_response, _receiver_player_name, message);
+        format_to_message(_sender_response, _receiver_player_name, message);
+        format_from_message(_receiver_response, _sender_player_name, message);
     }
 
     std::vector<const char*> ChatCommand::parse_tokens(char* command)
@@ -0,0 +1,34 @@
+#include "chat_router.h"
+
+namespace chat
+{
+namespace net
+{
+    void ChatRouter::login(std::string_view username, PlayerLocation location)
+    {
+        player_directory.insert_or_assign(username, std::move(location));
+    }
+
+    bool ChatRouter::logout(std::string_view username, ::net::ConnectionKey connection_key)
+    {
+        return player_directory.erase_if(username, [connection_key](const PlayerLocation& location) {
+            return location.connection_key == connection_key;
+        });
+    }
+
+    void ChatRouter::route(ChatCommand& chat_command, ::net::ConnectionKey sender_connection_key,
+                           const send_function& send, const reply_function& reply) const
+    {
+        if (chat_command.has_receiver_message()) {
+            if (auto receiver = player_directory.find(chat_command.receiver_name()))
+                send(receiver->game_server, receiver->connection_key, chat_command.receiver_response());
+            else
+                chat_command.set_error("Player is not online");
+        }
+
+        // the sender is replied to the requesting game server, even if its login isn't notified yet.
+        if (chat_command.has_sender_message())
+            reply(sender_connection_key, chat_command.sender_response());
+    }
+}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string_view>
+
+#include <net/udp_message.h>
+#include <util/sharded_hash_map.h>
+
+#include "chat_command.h"
+
+namespace chat
+{
+namespace net
+{
+    // where an online player is connected.
+    struct PlayerLocation
+    {
+        ::net::IPAddress game_server;
+        ::net::ConnectionKey connection_key;
+    };
+
+    // ChatRouter delivers chat command responses without database lookups.
+    // receivers are found in the player directory, maintained by login and logout messages of game servers. (thread-safe)
+    class ChatRouter
+    {
+    public:
+        // sends the message to the player of the connection through the game server.
+        using send_function = std::function<void(const ::net::IPAddress& game_server, ::net::ConnectionKey, const char* message)>;
+
+        // replies the message to the requesting game server.
+        using reply_function = std::function<void(::net::ConnectionKey, const char* message)>;
+
+        void login(std::string_view username, PlayerLocation);
+
+        // a stale logout doesn't remove the location of a newer login.
+        bool logout(std::string_view username, ::net::ConnectionKey);
+
+        std::optional<PlayerLocation> find(std::string_view username) const
+        {
+            return player_directory.find(username);
+        }
+
+        // sends the receiver message, and replies the sender message (or the error if the receiver is offline) to the requester.
+        void route(ChatCommand&, ::net::ConnectionKey sender_connection_key, const send_function&, const reply_function&) const;
+
+    private:
+        // username to location.
+        ::util::ShardedHashMap<PlayerLocation> player_directory;
+    };
+}
+}
@@ -15,13 +15,27 @@ namespace net
 {
     ChatServer::ChatServer()
         : server_core{ *this }
+        , common_chat_log{ database::CollectionPath::chat_message_common }
         , interval_tasks{ this }
+        , tick_loop{ tick_interval_ms }
     {
         interval_tasks.schedule(
             ::util::interval_task_tag_id::announce_server, 
             &ChatServer::announce_server, 
             ::util::MilliSecond(::config::task::announce_server_period)
         );
+
+        interval_tasks.schedule(
+            ::util::interval_task_tag_id::report_tick_statistics,
+            &ChatServer::report_tick_statistics,
+            ::util::MilliSecond(::config::task::report_tick_statistics_period)
+        );
+
+        interval_tasks.schedule(
+            ::util::interval_task_tag_id::flush_chat_log,
+            &ChatServer::flush_chat_log,
+            ::util::MilliSecond(::config::task::flush_common_chat_period)
+        );
     }
 
     bool ChatServer::handle_message(::net::MessageRequest& request)
@@ -30,6 +44,12 @@ namespace net
         case ::net::message_id::chat_command:
             handle_chat_command(request);
             return true;
+        case ::net::message_id::player_login:
+            handle_player_login(request);
+            return true;
+        case ::net::message_id::player_logout:
+            handle_player_logout(request);
+            return true;
         default:
             return false;
         }
@@ -41,40 +61,61 @@ namespace net
         if (not request.parse_message(msg))
             co_return;
 
-        if (msg.message()[0] != '/') { // if common chat just logging.
+        if (msg.message()[0] != '/') { // if common chat just logging. (in batches)
             database::collection::ChatMessage chat_msg;
             chat_msg.message = msg.message();
             chat_msg.sender_name = msg.sender_player_name();
 
-            co_await database::CouchbaseCore::insert_document(database::CollectionPath::chat_message_common, chat_msg);
+            common_chat_log.append(std::move(chat_msg));
             co_return;
         }
 
         net::ChatCommand chat_command;
         chat_command.execute(msg.sender_player_name(), msg.message());
 
-        if (chat_command.has_receiver_message()) {
-            
-        }
+        chat_router.route(chat_command, msg.sender_connection_key(),
+            [this](const ::net::IPAddress& game_server, ::net::ConnectionKey connection_key, const char* message) {
+                send_chat_message(game_server, connection_key, message);
+            },
+            [&request](::net::ConnectionKey connection_key, const char* message) {
+                protocol::ChatCommandResponse response_msg;
+                response_msg.set_receiver_connection_key(connection_key.raw());
+                response_msg.set_message(message);
+
+                request.set_message_id(::net::message_id::chat_command_response);
+                request.send_reply(response_msg);
+            });
+    }
 
-        /*
-        if (auto player = conn.associated_player()) {
-            packet.player_id = player->game_id(); // client always sends 0xff(SELF ID).
-
-            if (packet.message[0] == '/') { // if command message
-                game::PlayerCommand command(player);
-                command.execute(world, packet.message);
-
-                net::PacketChatMessage msg_packet(command.get_response());
-                conn.io()->send_packet(msg_packet);
-                ;
-            }
-            else {
-                deferred_chat_message_packet_task.push_packet(conn.connection_key(), packet);
-                return error::PACKET_HANDLE_DEFERRED;
-            }
-        }
-        */
+    void ChatServer::handle_player_login(::net::MessageRequest& request)
+    {
+        protocol::PlayerLoginRequest msg;
+        if (not request.parse_message(msg))
+            return;
+
+        chat_router.login(msg.username(), {
+            .game_server = { .ip = msg.game_server().ip(), .port = msg.game_server().port() },
+            .connection_key = msg.connection_key()
+        });
+    }
+
+    void ChatServer::handle_player_logout(::net::MessageRequest& request)
+    {
+        protocol::PlayerLogoutRequest msg;
+        if (not request.parse_message(msg))
+            return;
+
+        chat_router.logout(msg.username(), msg.connection_key());
+    }
+
+    void ChatServer::send_chat_message(const ::net::IPAddress& game_server, ::net::ConnectionKey connection_key, const char* message)
+    {
+        protocol::ChatCommandResponse response_msg;
+        response_msg.set_receiver_connection_key(connection_key.raw());
+        response_msg.set_message(message);
+
+        ::net::MessageRequest response(::net::message_id::chat_command_response, response_msg);
+        server_core.communicator().send_to(response, game_server);
     }
 
     bool ChatServer::initialize(const char* router_ip, int router_port)
@@ -89,7 +130,10 @@ namespace net
         auto& conf = chat::config::get_config();
         ::config::set_default_configuration(*conf.mutable_system());
 
-        logging::initialize_system(conf.log().log_dir(), conf.log().log_filename());
+        logging::initialize_system(conf.log().log_dir(), conf.log().log_filename(), conf.log().binary_format());
+
+        if (not database::CouchbaseCore::connect_server_with_login(conf.chat_database()))
+            return false;
 
         return true;
     }
@@ -118,16 +162,21 @@ namespace net
         auto& conf = chat::config::get_config();
         server_core.start_network_io_service(conf.server().ip(), conf.server().port(), conf.system().num_of_processors());
 
-        while (1) {
-            std::size_t start_tick = util::current_monotonic_tick();
+        tick_loop.add_phase("interval_tasks", interval_tasks_budget_us,
+            [this] { interval_tasks.process_tasks(); });
 
-            interval_tasks.process_tasks();
+        tick_loop.run();
+    }
 
-            std::size_t end_tick = util::current_monotonic_tick();
+    void ChatServer::report_tick_statistics()
+    {
+        tick_loop.log_statistics();
+        tick_loop.reset_statistics();
+    }
 
-            if (auto diff = end_tick - start_tick; diff < 300)
-                util::sleep_ms(std::max(300 - diff, std::size_t(100)));
-        }
+    void ChatServer::flush_chat_log()
+    {
+        common_chat_log.flush();
     }
 }
 }
\ No newline at end of file
@@ -6,10 +6,14 @@
 #include <net/server_communicator.h>
 
 #include <database/couchbase_core.h>
+#include <database/chat_log_writer.h>
 
 #include <util/double_buffering.h>
+#include <util/fixed_rate_loop.h>
 #include <util/interval_task.h>
 
+#include "chat_router.h"
+
 namespace chat
 {
     namespace net
@@ -20,22 +24,41 @@ namespace chat
             
             static constexpr protocol::server_type_id server_type = protocol::server_type_id::chat;
 
+            static constexpr std::size_t tick_interval_ms = 300;
+            static constexpr std::size_t interval_tasks_budget_us = 50 * 1000;
+
             ChatServer();
 
             virtual bool handle_message(::net::MessageRequest&) override;
 
             io::DetachedTask handle_chat_command(::net::MessageRequest&);
 
+            void handle_player_login(::net::MessageRequest&);
+
+            void handle_player_logout(::net::MessageRequest&);
+
             bool initialize(const char* router_ip, int router_port);
 
             void serve_forever(int argc, char* argv[]);
 
             void announce_server();
 
+            void report_tick_statistics();
+
+            void flush_chat_log();
+
         private:
+            void send_chat_message(const ::net::IPAddress& game_server, ::net::ConnectionKey, const char* message);
+
             ::net::UdpServer server_core;
 
+            ChatRouter chat_router;
+
+            database::ChatLogWriter common_chat_log;
+
             ::util::IntervalTaskScheduler<ChatServer> interval_tasks;
+
+            ::util::FixedRateLoop tick_loop;
         };
     }
 }
\ No newline at end of file
@@ -16,6 +16,7 @@ namespace net
     LoginServer::LoginServer()
         : server_core{ *this }
         , interval_tasks{ this }
+        , player_login_cache{ login_cache::player_login_capacity, login_cache::player_login_ttl }
     {
         interval_tasks.schedule(
             ::util::interval_task_tag_id::announce_server,
@@ -50,16 +51,18 @@ namespace net
             request.send_reply(packet_response);
         };
 
+        const auto& username = packet_msg.packet().username;
+
         { // Authenticate
-            auto [err, result] = co_await database::CouchbaseCore::get_document(database::CollectionPath::player_login, packet_msg.packet().username);
-            if (err.ec() == couchbase::errc::key_value::document_not_found) {
+            auto lookup = co_await find_player_login(std::string(username));
+            if (lookup.status == PlayerLoginLookup::not_found) {
                 packet_response.set_error_code(error::code::packet::player_not_exist);
                 co_return;
             }
-            else if (err)
+            else if (lookup.status != PlayerLoginLookup::found)
                 co_return;
 
-            auto player_login = result.content_as<database::collection::PlayerLogin>();
+            const auto& player_login = lookup.player_login;
             if (player_login.password != packet_msg.packet().password)
                 co_return;
 
@@ -69,7 +72,8 @@ namespace net
         }
         
         { // Update login session
-            auto [err, result] = co_await database::CouchbaseCore::get_document(::database::CollectionPath::player_login_session, packet_msg.packet().username);
+            // not cached, as other login servers may have written the session.
+            auto [err, result] = co_await database::CouchbaseCore::get_document(::database::CollectionPath::player_login_session, username);
             if (err && err.ec() != couchbase::errc::key_value::document_not_found)
                 co_return;
 
@@ -81,13 +85,38 @@ namespace net
 
             login_session.connection_key = packet_msg.connection_key().raw();
 
-            std::tie(err, std::ignore) = co_await database::CouchbaseCore::upsert_document(database::CollectionPath::player_login_session, packet_msg.packet().username, login_session);
+            std::tie(err, std::ignore) = co_await database::CouchbaseCore::upsert_document(database::CollectionPath::player_login_session, username, login_session);
             if (err) {
-                CONSOLE_LOG(error) << "Fail to update login session: " << packet_msg.packet().username;
+                CONSOLE_LOG(error) << "Fail to update login session: " << username;
             }
         }
     }
 
+    io::AsyncTask<PlayerLoginLookup> LoginServer::find_player_login(std::string username)
+    {
+        if (auto player_login = player_login_cache.get(username))
+            co_return PlayerLoginLookup{ .status = PlayerLoginLookup::found, .player_login = std::move(*player_login) };
+
+        if (auto shared_lookup = co_await player_login_flights.join(username))
+            co_return std::move(*shared_lookup);
+
+        // followers fail as well if the lookup throws. (e.g. a malformed document)
+        auto flight = player_login_flights.lead(username, PlayerLoginLookup{ .status = PlayerLoginLookup::failed });
+
+        PlayerLoginLookup lookup;
+        auto [err, result] = co_await database::CouchbaseCore::get_document(database::CollectionPath::player_login, username);
+        if (err.ec() == couchbase::errc::key_value::document_not_found)
+            lookup.status = PlayerLoginLookup::not_found;
+        else if (not err) {
+            lookup.status = PlayerLoginLookup::found;
+            lookup.player_login = result.content_as<database::collection::PlayerLogin>();
+            player_login_cache.put(username, lookup.player_login);
+        }
+
+        flight.complete(lookup);
+        co_return lookup;
+    }
+
     io::DetachedTask LoginServer::handle_player_logout_message(::net::MessageRequest& request)
     {
         protocol::PlayerLogoutRequest msg;
@@ -107,7 +136,7 @@ namespace net
             return false;
 
         auto& conf = login::config::get_config();
-        logging::initialize_system(conf.log().log_dir(), conf.log().log_filename());
+        logging::initialize_system(conf.log().log_dir(), conf.log().log_filename(), conf.log().binary_format());
     
         database::CouchbaseCore::connect_server_with_login(conf.session_database());
 
@@ -128,6 +157,7 @@ namespace net
         server_core.start_network_io_service(conf.server().ip(), conf.server().port(), 1);
 
         while (1) {
+            util::update_coarse_monotonic_tick();
             interval_tasks.process_tasks();
 
             util::sleep_ms(3000);
@@ -4,16 +4,37 @@
 
 #include <database/couchbase_core.h>
 
+#include <io/single_flight.h>
+
 #include <net/connection_key.h>
 #include <net/udp_server.h>
 #include <net/server_communicator.h>
 
 #include <util/interval_task.h>
+#include <util/lru_cache.h>
 
 namespace login
 {
     namespace net
     {
+        namespace login_cache {
+            constexpr std::size_t player_login_capacity     = 100'000;
+            constexpr std::size_t player_login_ttl          = 60 * 1000;    // 1 minute.
+        }
+
+        struct PlayerLoginLookup
+        {
+            enum Status
+            {
+                failed,
+                found,
+                not_found,
+            };
+
+            Status status = failed;
+            database::collection::PlayerLogin player_login;
+        };
+
         class LoginServer : public ::net::MessageHandler
         {
         public:
@@ -28,6 +49,9 @@ namespace login
 
             io::DetachedTask handle_player_logout_message(::net::MessageRequest&);
 
+            // looks up the cache first, and concurrent lookups of the same player share a database read.
+            io::AsyncTask<PlayerLoginLookup> find_player_login(std::string username);
+
             bool initialize(const char* router_ip, int port);
 
             void serve_forever(int argc, char* argv[]);
@@ -38,6 +62,9 @@ namespace login
             ::net::UdpServer server_core;
 
             ::util::IntervalTaskScheduler<LoginServer> interval_tasks;
+
+            ::util::ShardedLruCache<database::collection::PlayerLogin> player_login_cache;
+            io::SingleFlight<PlayerLoginLookup> player_login_flights;
         };
     }
 }
\ No newline at end of file
@@ -42,6 +42,7 @@ namespace
             g_game_server_config.mutable_player_database();
             g_game_server_config.mutable_world();
             g_game_server_config.mutable_log();
+            g_game_server_config.mutable_metrics();
             return;
         case protocol::server_type_id::router:
             g_route_server_config.mutable_server();
@@ -0,0 +1,99 @@
+#include "pch.h"
+
+#include <vector>
+
+#include "game/block_physics.h"
+
+namespace
+{
+    constexpr int map_width = 8;
+    constexpr int map_height = 8;
+    constexpr int map_length = 8;
+
+    std::size_t block_index_of(int x, int y, int z)
+    {
+        return std::size_t(x) + map_width * z + map_width * map_length * y;
+    }
+
+    // re-activates accepted changes as the world does when committing them.
+    std::size_t simulate_step(game::BlockPhysics& physics, std::vector<std::byte>& blocks, std::size_t max_updates = 1024)
+    {
+        std::vector<game::BlockChange> accepted;
+
+        auto num_of_updates = physics.simulate(blocks.data(), max_updates,
+            [&accepted](const std::vector<game::BlockChange>& changes) {
+                accepted.insert(accepted.end(), changes.begin(), changes.end());
+                return true;
+            });
+
+        for (const auto& change : accepted)
+            physics.activate(change.pos.x, change.pos.y, change.pos.z);
+
+        return num_of_updates;
+    }
+}
+
+TEST(block_physics, sand_falls_to_the_ground)
+{
+    game::BlockPhysics physics;
+    physics.reset(map_width, map_height, map_length);
+
+    std::vector<std::byte> blocks(map_width * map_height * map_length, std::byte(game::block_id::air));
+    blocks[block_index_of(2, 5, 2)] = std::byte(game::block_id::sand);
+    physics.activate(2, 5, 2);
+
+    while (physics.has_active_blocks())
+        simulate_step(physics, blocks);
+
+    EXPECT_EQ(game::BlockID(blocks[block_index_of(2, 5, 2)]), game::block_id::air);
+    EXPECT_EQ(game::BlockID(blocks[block_index_of(2, 0, 2)]), game::block_id::sand);
+}
+
+TEST(block_physics, water_hardens_lava)
+{
+    game::BlockPhysics physics;
+    physics.reset(map_width, map_height, map_length);
+
+    std::vector<std::byte> blocks(map_width * map_height * map_length, std::byte(game::block_id::stone));
+    blocks[block_index_of(3, 1, 3)] = std::byte(game::block_id::water);
+    blocks[block_index_of(4, 1, 3)] = std::byte(game::block_id::still_lava);
+    physics.activate(3, 1, 3);
+
+    simulate_step(physics, blocks);
+
+    EXPECT_EQ(game::BlockID(blocks[block_index_of(4, 1, 3)]), game::block_id::stone);
+}
+
+TEST(block_physics, work_is_capped_and_carried_over)
+{
+    game::BlockPhysics physics;
+    physics.reset(map_width, map_height, map_length);
+
+    std::vector<std::byte> blocks(map_width * map_height * map_length, std::byte(game::block_id::air));
+    physics.activate(4, 4, 4);
+    physics.activate(4, 4, 4); // duplicated activation is ignored.
+    EXPECT_EQ(physics.num_of_active_blocks(), 7);
+
+    EXPECT_EQ(simulate_step(physics, blocks, 5), 5);
+    EXPECT_EQ(physics.num_of_active_blocks(), 2);
+
+    EXPECT_EQ(simulate_step(physics, blocks, 5), 2);
+    EXPECT_FALSE(physics.has_active_blocks());
+}
+
+TEST(block_physics, rejected_changes_stay_active)
+{
+    game::BlockPhysics physics;
+    physics.reset(map_width, map_height, map_length);
+
+    std::vector<std::byte> blocks(map_width * map_height * map_length, std::byte(game::block_id::air));
+    blocks[block_index_of(1, 3, 1)] = std::byte(game::block_id::gravel);
+    physics.activate(1, 3, 1);
+
+    // the simulation stops at the rejected block without touching the block map.
+    auto reject = [](const std::vector<game::BlockChange>&) { return false; };
+    EXPECT_EQ(physics.simulate(blocks.data(), 1024, reject), 0);
+
+    EXPECT_TRUE(physics.has_active_blocks());
+    EXPECT_EQ(game::BlockID(blocks[block_index_of(1, 3, 1)]), game::block_id::gravel);
+}
@@ -0,0 +1,107 @@
+#include "pch.h"
+
+#include <vector>
+
+#include "game/block_region.h"
+#include "game/history_buffer.h"
+
+namespace
+{
+    void commit_changes(game::BlockRegionTable& table, std::initializer_list<util::Coordinate3D> positions)
+    {
+        game::BlockHistory block_history;
+        for (auto pos : positions)
+            block_history.add_record(pos, game::block_id::dirt);
+        block_history.snapshot();
+
+        table.commit(block_history);
+        block_history.clear_snapshot();
+    }
+}
+
+TEST(block_region, window_records_shared_in_view)
+{
+    game::BlockRegionTable table;
+    table.reset(512, 64, 512);
+
+    game::RegionSyncState sync_state;
+    table.mark_all_synced(sync_state);
+
+    commit_changes(table, { { 1, 2, 3 }, { 500, 2, 500 } });
+
+    auto center = table.region_index_of(0, 0);
+    EXPECT_TRUE(table.is_window_synced(center, sync_state));
+
+    std::vector<game::BlockHistoryRecord> records;
+    table.collect_window_records(center, records);
+    EXPECT_EQ(records.size(), 1);
+
+    table.mark_view_synced(center, sync_state);
+    EXPECT_TRUE(sync_state.has_dirty_region);
+}
+
+TEST(block_region, resync_missed_changes_when_region_in_view)
+{
+    game::BlockRegionTable table;
+    table.reset(512, 64, 512);
+
+    game::RegionSyncState sync_state;
+    table.mark_all_synced(sync_state);
+
+    auto near_center = table.region_index_of(0, 0);
+    auto far_center = table.region_index_of(500, 500);
+
+    commit_changes(table, { { 500, 2, 500 }, { 501, 2, 500 } });
+    table.mark_view_synced(near_center, sync_state);
+
+    commit_changes(table, { { 500, 2, 500 } });
+    table.mark_view_synced(near_center, sync_state);
+    EXPECT_TRUE(sync_state.has_dirty_region);
+
+    // the player moved to the changed region.
+    commit_changes(table, {});
+    EXPECT_FALSE(table.is_window_synced(far_center, sync_state));
+
+    std::vector<game::BlockHistoryRecord> records;
+    table.collect_unsynced_records(far_center, sync_state, records);
+    EXPECT_EQ(records.size(), 2);
+
+    table.mark_view_synced(far_center, sync_state);
+    EXPECT_FALSE(sync_state.has_dirty_region);
+}
+
+TEST(block_region, changes_synced_by_all_players_are_trimmed)
+{
+    game::BlockRegionTable table;
+    table.reset(512, 64, 512);
+
+    game::RegionSyncState near_player, far_player;
+    table.mark_all_synced(near_player);
+    table.mark_all_synced(far_player);
+
+    auto near_center = table.region_index_of(0, 0);
+    auto far_center = table.region_index_of(500, 500);
+
+    commit_changes(table, { { 1, 2, 3 }, { 500, 2, 500 } });
+    table.mark_view_synced(near_center, near_player);
+    table.mark_view_synced(far_center, far_player);
+
+    // each change is missed by one of the players.
+    table.trim_changes({ &near_player, &far_player });
+    EXPECT_EQ(table.num_of_changes(), 2);
+
+    table.mark_view_synced(far_center, near_player);
+    table.trim_changes({ &near_player, &far_player });
+    EXPECT_EQ(table.num_of_changes(), 1);
+
+    table.mark_view_synced(near_center, far_player);
+    table.trim_changes({ &near_player, &far_player });
+    EXPECT_EQ(table.num_of_changes(), 0);
+
+    // a player who joins later receives the whole level, so nothing is kept for it.
+    commit_changes(table, { { 1, 2, 3 } });
+    game::RegionSyncState new_player;
+    table.mark_all_synced(new_player);
+    table.trim_changes({ &new_player });
+    EXPECT_EQ(table.num_of_changes(), 0);
+}
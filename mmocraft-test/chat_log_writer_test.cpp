@@ -0,0 +1,104 @@
+#include "pch.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "database/chat_log_writer.h"
+#include "database/couchbase_core.h"
+#include "embedded_database.h"
+
+namespace
+{
+    using database::collection::ChatMessage;
+
+    void wait_for_inserts(const database::ChatLogWriter& writer)
+    {
+        ASSERT_TRUE(test::wait_until([&writer] { return writer.num_of_in_flight_batches() == 0; }));
+    }
+
+    ChatMessage make_message(int i)
+    {
+        return { .sender_name = "player", .message = "hello " + std::to_string(i) };
+    }
+
+    io::DetachedTask insert_message(ChatMessage message, std::atomic<std::size_t>& num_of_inserted)
+    {
+        co_await database::CouchbaseCore::insert_document(database::CollectionPath::chat_message_common, message);
+        num_of_inserted.fetch_add(1, std::memory_order_release);
+    }
+}
+
+TEST(chat_log_writer, full_batch_is_inserted_on_append)
+{
+    ASSERT_TRUE(test::connect_embedded_database());
+    database::ChatLogWriter writer{ database::CollectionPath::chat_message_common, { .max_batch_size = 4 } };
+
+    for (int i = 0; i < 10; i++)
+        EXPECT_TRUE(writer.append(make_message(i)));
+    wait_for_inserts(writer);
+
+    // two full batches are inserted, and the rest waits for the flush.
+    EXPECT_EQ(writer.num_of_pending_messages(), 2);
+    EXPECT_EQ(writer.flush(), 1);
+    wait_for_inserts(writer);
+
+    EXPECT_EQ(writer.num_of_pending_messages(), 0);
+    EXPECT_EQ(writer.flush(), 0);
+}
+
+TEST(chat_log_writer, messages_are_dropped_if_database_falls_behind)
+{
+    ASSERT_TRUE(test::connect_embedded_database());
+
+    // no inserts can be in flight, as if the database stopped responding.
+    database::ChatLogWriter writer{ database::CollectionPath::chat_message_common,
+        { .max_batch_size = 4, .max_in_flight_batches = 0, .max_pending_messages = 8 } };
+
+    for (int i = 0; i < 8; i++)
+        EXPECT_TRUE(writer.append(make_message(i)));
+    EXPECT_FALSE(writer.append(make_message(8)));
+
+    EXPECT_EQ(writer.flush(), 0);
+    EXPECT_EQ(writer.num_of_pending_messages(), 8);
+}
+
+// run with --gtest_also_run_disabled_tests --gtest_filter=*benchmark*
+TEST(chat_log_writer, DISABLED_benchmark_chat_logging)
+{
+    ASSERT_TRUE(test::connect_embedded_database());
+    constexpr int num_of_messages = 100'000;
+
+    {
+        std::atomic<std::size_t> num_of_inserted{ 0 };
+
+        auto start_at = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_of_messages; i++)
+            insert_message(make_message(i), num_of_inserted);
+        ASSERT_TRUE(test::wait_until([&num_of_inserted] {
+            return num_of_inserted.load(std::memory_order_acquire) == num_of_messages;
+        }, std::chrono::minutes(1)));
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_at;
+
+        std::cout << "insert per message: " << int(num_of_messages / elapsed.count()) << " messages/s, "
+                  << num_of_messages << " database ops\n";
+    }
+
+    {
+        database::ChatLogWriter writer{ database::CollectionPath::chat_message_common };
+        constexpr auto max_batch_size = database::ChatLogWriter::Options{}.max_batch_size;
+
+        auto start_at = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_of_messages; i++) {
+            while (not writer.append(make_message(i)))  // dropped by backpressure.
+                writer.flush();
+        }
+        while (writer.num_of_pending_messages() || writer.num_of_in_flight_batches())
+            writer.flush();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_at;
+
+        std::cout << "chat log writer: " << int(num_of_messages / elapsed.count()) << " messages/s, "
+                  << (num_of_messages + max_batch_size - 1) / max_batch_size << " database ops\n";
+    }
+}
@@ -0,0 +1,98 @@
+#include "pch.h"
+
+#include <string>
+#include <vector>
+
+#include "../mmocraft-chat/net/chat_router.h"
+
+namespace
+{
+    struct Delivery
+    {
+        std::string game_server;
+        net::ConnectionKey connection_key;
+        std::string message;
+    };
+
+    // records where the responses of a chat command go.
+    struct Deliveries
+    {
+        std::vector<Delivery> sent;
+        std::vector<Delivery> replied;
+
+        void route(const chat::net::ChatRouter& router, std::string_view sender, std::string_view command, net::ConnectionKey sender_key)
+        {
+            chat::net::ChatCommand chat_command;
+            chat_command.execute(sender, command);
+
+            router.route(chat_command, sender_key,
+                [this](const net::IPAddress& game_server, net::ConnectionKey connection_key, const char* message) {
+                    sent.push_back({ game_server.ip, connection_key, message });
+                },
+                [this](net::ConnectionKey connection_key, const char* message) {
+                    replied.push_back({ "", connection_key, message });
+                });
+        }
+    };
+}
+
+TEST(chat_router, direct_message_is_sent_to_receiver_location)
+{
+    chat::net::ChatRouter router;
+    router.login("alice", { .game_server = { .ip = "10.0.0.1", .port = 12345 }, .connection_key = 1 });
+    router.login("bob", { .game_server = { .ip = "10.0.0.2", .port = 12345 }, .connection_key = 2 });
+
+    Deliveries deliveries;
+    deliveries.route(router, "alice", "/dm bob hello", 1);
+
+    ASSERT_EQ(deliveries.sent.size(), 1);
+    EXPECT_EQ(deliveries.sent[0].game_server, "10.0.0.2");
+    EXPECT_EQ(deliveries.sent[0].connection_key, net::ConnectionKey(2));
+    EXPECT_NE(deliveries.sent[0].message.find("[from alice] hello"), std::string::npos);
+
+    ASSERT_EQ(deliveries.replied.size(), 1);
+    EXPECT_EQ(deliveries.replied[0].connection_key, net::ConnectionKey(1));
+    EXPECT_NE(deliveries.replied[0].message.find("[to bob] hello"), std::string::npos);
+}
+
+TEST(chat_router, offline_receiver_is_replied_with_error)
+{
+    chat::net::ChatRouter router;
+    router.login("bob", { .game_server = { .ip = "10.0.0.2", .port = 12345 }, .connection_key = 2 });
+    router.logout("bob", 2);
+
+    Deliveries deliveries;
+    deliveries.route(router, "alice", "/dm bob hello", 1);
+
+    EXPECT_TRUE(deliveries.sent.empty());
+    ASSERT_EQ(deliveries.replied.size(), 1);
+    EXPECT_EQ(deliveries.replied[0].connection_key, net::ConnectionKey(1));
+    EXPECT_NE(deliveries.replied[0].message.find("Player is not online"), std::string::npos);
+}
+
+TEST(chat_router, requester_is_replied_before_its_login_is_notified)
+{
+    chat::net::ChatRouter router;
+    router.login("bob", { .game_server = { .ip = "10.0.0.2", .port = 12345 }, .connection_key = 2 });
+
+    // alice is not in the directory yet.
+    Deliveries deliveries;
+    deliveries.route(router, "alice", "/dm bob hello", 7);
+
+    ASSERT_EQ(deliveries.replied.size(), 1);
+    EXPECT_EQ(deliveries.replied[0].connection_key, net::ConnectionKey(7));
+    EXPECT_EQ(deliveries.sent.size(), 1);
+}
+
+TEST(chat_router, stale_logout_keeps_newer_login)
+{
+    chat::net::ChatRouter router;
+    router.login("bob", { .game_server = { .ip = "10.0.0.2", .port = 12345 }, .connection_key = 2 });
+    router.login("bob", { .game_server = { .ip = "10.0.0.3", .port = 12345 }, .connection_key = 3 });
+
+    EXPECT_FALSE(router.logout("bob", 2));
+
+    auto location = router.find("bob");
+    ASSERT_TRUE(location.has_value());
+    EXPECT_EQ(location->game_server.ip, "10.0.0.3");
+}
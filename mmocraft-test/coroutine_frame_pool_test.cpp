@@ -0,0 +1,197 @@
+#include "pch.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "io/async_task.h"
+#include "io/coroutine_frame_pool.h"
+
+namespace
+{
+    // DatabaseStub resumes awaiting coroutines on its own thread, like database callbacks.
+    class DatabaseStub
+    {
+    public:
+        DatabaseStub()
+            : worker{ [this] { run(); } }
+        { }
+
+        ~DatabaseStub()
+        {
+            {
+                std::lock_guard<std::mutex> lock(queue_lock);
+                is_stopped = true;
+            }
+            queue_cv.notify_one();
+            worker.join();
+        }
+
+        auto query()
+        {
+            struct QueryAwaiter
+            {
+                DatabaseStub& database;
+
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+
+                void await_suspend(std::coroutine_handle<> coro)
+                {
+                    database.enqueue(coro);
+                }
+
+                int await_resume() const noexcept
+                {
+                    return 1;
+                }
+            };
+            return QueryAwaiter{ *this };
+        }
+
+    private:
+        void enqueue(std::coroutine_handle<> coro)
+        {
+            {
+                std::lock_guard<std::mutex> lock(queue_lock);
+                pending.push_back(coro);
+            }
+            queue_cv.notify_one();
+        }
+
+        void run()
+        {
+            std::vector<std::coroutine_handle<>> resumable;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(queue_lock);
+                    queue_cv.wait(lock, [this] { return is_stopped || not pending.empty(); });
+                    if (is_stopped && pending.empty())
+                        return;
+                    resumable.swap(pending);
+                }
+
+                for (auto coro : resumable)
+                    coro.resume();
+                resumable.clear();
+            }
+        }
+
+        std::mutex queue_lock;
+        std::condition_variable queue_cv;
+        std::vector<std::coroutine_handle<>> pending;
+        bool is_stopped = false;
+
+        std::thread worker;
+    };
+
+    io::AsyncTask<int> load_session(DatabaseStub& database)
+    {
+        co_return co_await database.query();
+    }
+
+    // same shape as LoginServer::handle_handshake_packet: authenticate, load and update the login session.
+    io::DetachedTask handle_handshake(DatabaseStub& database, std::atomic<std::size_t>& num_of_handshakes)
+    {
+        int result = co_await database.query();
+        result += co_await load_session(database);
+        result += co_await database.query();
+
+        if (result == 3)
+            num_of_handshakes.fetch_add(1, std::memory_order_release);
+    }
+}
+
+TEST(coroutine_frame_pool, freed_frame_is_reused_by_same_thread)
+{
+    auto frame = io::allocate_coroutine_frame(200);
+    io::free_coroutine_frame(frame, 200);
+
+    // same size class.
+    auto reused_frame = io::allocate_coroutine_frame(256);
+    EXPECT_EQ(reused_frame, frame);
+    io::free_coroutine_frame(reused_frame, 256);
+
+    // too large frames are not pooled.
+    auto large_frame = io::allocate_coroutine_frame(64 * 1024);
+    ASSERT_NE(large_frame, nullptr);
+    io::free_coroutine_frame(large_frame, 64 * 1024);
+}
+
+TEST(coroutine_frame_pool, frames_freed_by_other_threads_are_shared)
+{
+    constexpr std::size_t num_of_frames = 1000;
+    constexpr std::size_t frame_size = 1000;
+
+    std::vector<void*> frames;
+    std::thread([&frames] {
+        for (std::size_t i = 0; i < num_of_frames; i++)
+            frames.push_back(io::allocate_coroutine_frame(frame_size));
+    }).join();
+
+    // freeing thread keeps some frames, and hands over the rest (and all at exit) to the depot.
+    std::thread([&frames] {
+        for (auto frame : frames)
+            io::free_coroutine_frame(frame, frame_size);
+    }).join();
+
+    std::set<void*> freed_frames(frames.begin(), frames.end());
+    std::thread([&freed_frames] {
+        std::vector<void*> reused_frames;
+        for (std::size_t i = 0; i < num_of_frames; i++)
+            reused_frames.push_back(io::allocate_coroutine_frame(frame_size));
+
+        for (auto frame : reused_frames) {
+            EXPECT_TRUE(freed_frames.contains(frame));
+            io::free_coroutine_frame(frame, frame_size);
+        }
+    }).join();
+}
+
+TEST(coroutine_frame_pool, coroutines_complete_on_other_thread)
+{
+    std::atomic<std::size_t> num_of_handshakes{ 0 };
+    {
+        DatabaseStub database;
+        for (int i = 0; i < 1000; i++)
+            handle_handshake(database, num_of_handshakes);
+
+        while (num_of_handshakes.load(std::memory_order_acquire) != 1000)
+            std::this_thread::yield();
+    }
+    EXPECT_EQ(num_of_handshakes.load(), 1000);
+}
+
+// run with --gtest_also_run_disabled_tests --gtest_filter=*benchmark*
+TEST(coroutine_frame_pool, DISABLED_benchmark_handshakes_per_second)
+{
+    constexpr std::size_t num_of_handshakes = 500'000;
+
+    for (bool pooling : { false, true }) {
+        io::set_coroutine_frame_pooling(pooling);
+
+        std::atomic<std::size_t> num_of_completed{ 0 };
+        DatabaseStub database;
+
+        auto start_at = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < num_of_handshakes; i++)
+            handle_handshake(database, num_of_completed);
+
+        while (num_of_completed.load(std::memory_order_acquire) != num_of_handshakes)
+            std::this_thread::yield();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_at;
+
+        std::cout << (pooling ? "pooled frames: " : "global new: ")
+                  << std::size_t(num_of_handshakes / elapsed.count()) << " handshakes/s\n";
+    }
+
+    io::set_coroutine_frame_pooling(true);
+}
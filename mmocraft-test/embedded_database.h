@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+#include "database/couchbase_core.h"
+
+namespace test
+{
+    // connects the embedded backend in a temporary directory once per test binary.
+    // the backend is shared by all tests, so use distinct document ids in each test.
+    inline bool connect_embedded_database()
+    {
+        static const bool is_connected = [] {
+            auto dir = std::filesystem::temp_directory_path() / "mmocraft_test" / "embedded_database";
+            std::filesystem::remove_all(dir);
+
+            config::Configuration_Database conf;
+            conf.set_driver_name(database::CouchbaseCore::embedded_driver_name);
+            conf.set_server_address(dir.string());
+            return database::CouchbaseCore::connect_server_with_login(conf);
+        }();
+        return is_connected;
+    }
+
+    // waits until the predicate holds. (e.g. database operations completed on the backend thread)
+    template <typename Predicate>
+    bool wait_until(Predicate pred, std::chrono::milliseconds timeout = std::chrono::seconds(10))
+    {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (not pred()) {
+            if (std::chrono::steady_clock::now() >= deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+}
@@ -0,0 +1,244 @@
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#include "database/embedded_kv_store.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct Result
+    {
+        database::KvStatus status;
+        database::KvValue value;
+    };
+
+    // waits for the completion on the store thread.
+    template <typename Operation>
+    Result wait_for(Operation&& operation)
+    {
+        std::promise<Result> promise;
+        operation([&promise](database::KvStatus status, database::KvValue&& value) {
+            promise.set_value({ status, std::move(value) });
+        });
+        return promise.get_future().get();
+    }
+
+    database::KvValue to_value(std::string_view str)
+    {
+        auto bytes = reinterpret_cast<const std::byte*>(str.data());
+        return { .data = { bytes, bytes + str.size() }, .flags = 1 };
+    }
+
+    std::string to_string(const database::KvValue& value)
+    {
+        return { reinterpret_cast<const char*>(value.data.data()), value.data.size() };
+    }
+
+    Result get(database::EmbeddedKvStore& store, std::string key)
+    {
+        return wait_for([&](auto handler) { store.get(key, handler); });
+    }
+
+    Result upsert(database::EmbeddedKvStore& store, std::string key, std::string_view value)
+    {
+        return wait_for([&](auto handler) { store.upsert(key, to_value(value), handler); });
+    }
+
+    Result insert(database::EmbeddedKvStore& store, std::string key, std::string_view value)
+    {
+        return wait_for([&](auto handler) { store.insert(key, to_value(value), handler); });
+    }
+
+    Result remove(database::EmbeddedKvStore& store, std::string key)
+    {
+        return wait_for([&](auto handler) { store.remove(key, handler); });
+    }
+
+    fs::path make_store_dir(std::string_view name)
+    {
+        auto dir = fs::temp_directory_path() / "mmocraft_test" / name;
+        fs::remove_all(dir);
+        return dir;
+    }
+}
+
+TEST(embedded_kv_store, operations_have_couchbase_semantics)
+{
+    auto dir = make_store_dir("kv_operations");
+    database::EmbeddedKvStore store{ dir };
+    ASSERT_TRUE(store.is_open());
+
+    EXPECT_EQ(get(store, "user").status, database::KvStatus::not_found);
+    EXPECT_EQ(remove(store, "user").status, database::KvStatus::not_found);
+
+    auto first = insert(store, "user", "first");
+    EXPECT_EQ(first.status, database::KvStatus::success);
+    EXPECT_EQ(insert(store, "user", "second").status, database::KvStatus::already_exists);
+
+    auto second = upsert(store, "user", "second");
+    EXPECT_EQ(second.status, database::KvStatus::success);
+    EXPECT_LT(first.value.sequence, second.value.sequence);
+
+    auto result = get(store, "user");
+    EXPECT_EQ(result.status, database::KvStatus::success);
+    EXPECT_EQ(to_string(result.value), "second");
+    EXPECT_EQ(result.value.flags, 1);
+    EXPECT_EQ(result.value.sequence, second.value.sequence);
+
+    EXPECT_EQ(remove(store, "user").status, database::KvStatus::success);
+    EXPECT_EQ(get(store, "user").status, database::KvStatus::not_found);
+    EXPECT_EQ(insert(store, "user", "third").status, database::KvStatus::success);
+}
+
+TEST(embedded_kv_store, index_is_recovered_from_segments)
+{
+    auto dir = make_store_dir("kv_recovery");
+    {
+        database::EmbeddedKvStore store{ dir };
+        upsert(store, "a", "1");
+        upsert(store, "b", "2");
+        upsert(store, "a", "3");
+        remove(store, "b");
+
+        // completed without waiting. (written before closing)
+        store.upsert("c", to_value("4"), [](auto, auto&&) { });
+    }
+
+    database::EmbeddedKvStore store{ dir };
+    ASSERT_TRUE(store.is_open());
+    EXPECT_EQ(store.num_of_keys(), 2);
+    EXPECT_EQ(to_string(get(store, "a").value), "3");
+    EXPECT_EQ(get(store, "b").status, database::KvStatus::not_found);
+    EXPECT_EQ(to_string(get(store, "c").value), "4");
+
+    // sequences keep increasing.
+    EXPECT_GT(upsert(store, "d", "5").value.sequence, get(store, "c").value.sequence);
+}
+
+TEST(embedded_kv_store, torn_record_is_truncated)
+{
+    auto dir = make_store_dir("kv_torn_record");
+    {
+        database::EmbeddedKvStore store{ dir };
+        upsert(store, "a", "1");
+        upsert(store, "b", "2");
+    }
+
+    // a record header is partially written.
+    fs::path segment_path;
+    for (const auto& entry : fs::directory_iterator(dir))
+        segment_path = entry.path();
+    auto segment_size = fs::file_size(segment_path);
+    {
+        std::ofstream segment(segment_path, std::ios::binary | std::ios::app);
+        segment.write("torn", 4);
+    }
+
+    {
+        database::EmbeddedKvStore store{ dir };
+        ASSERT_TRUE(store.is_open());
+        EXPECT_EQ(fs::file_size(segment_path), segment_size);
+        EXPECT_EQ(to_string(get(store, "b").value), "2");
+        upsert(store, "c", "3");
+    }
+
+    database::EmbeddedKvStore store{ dir };
+    EXPECT_EQ(store.num_of_keys(), 3);
+    EXPECT_EQ(to_string(get(store, "c").value), "3");
+}
+
+TEST(embedded_kv_store, compaction_keeps_only_live_records)
+{
+    auto dir = make_store_dir("kv_compaction");
+    database::EmbeddedKvStore::Options options;
+    options.max_segment_size = 1024;
+    options.compaction_min_stale_bytes = std::size_t(-1);   // compacts manually.
+    {
+        database::EmbeddedKvStore store{ dir, options };
+        for (int version = 0; version < 50; version++)
+            for (int key = 0; key < 10; key++)
+                upsert(store, "key" + std::to_string(key), "version" + std::to_string(version));
+        remove(store, "key0");
+
+        EXPECT_GT(store.num_of_segments(), 2);
+        EXPECT_GT(store.stale_bytes(), 0);
+
+        ASSERT_TRUE(store.compact());
+        EXPECT_EQ(store.num_of_segments(), 2);  // compacted and new active segment.
+        EXPECT_EQ(store.stale_bytes(), 0);
+
+        EXPECT_EQ(to_string(get(store, "key9").value), "version49");
+        EXPECT_EQ(get(store, "key0").status, database::KvStatus::not_found);
+        upsert(store, "key1", "latest");
+    }
+
+    database::EmbeddedKvStore store{ dir, options };
+    EXPECT_EQ(store.num_of_keys(), 9);
+    EXPECT_EQ(to_string(get(store, "key1").value), "latest");
+    EXPECT_EQ(to_string(get(store, "key2").value), "version49");
+    EXPECT_EQ(get(store, "key0").status, database::KvStatus::not_found);
+}
+
+TEST(embedded_kv_store, removed_keys_are_dropped_by_compaction)
+{
+    auto dir = make_store_dir("kv_removed_keys");
+    database::EmbeddedKvStore::Options options;
+    options.max_segment_size = 1024;
+    options.compaction_min_stale_bytes = std::size_t(-1);   // compacts manually.
+
+    fs::path first_segment_path;
+    std::string first_segment;
+    {
+        database::EmbeddedKvStore store{ dir, options };
+        upsert(store, "removed", "value");
+        for (int i = 0; i < 50; i++)
+            upsert(store, "key" + std::to_string(i), "value");
+        remove(store, "removed");
+
+        // keep a copy of the segment which has the removed value.
+        first_segment_path = dir / "00000001.log";
+        std::ifstream segment(first_segment_path, std::ios::binary);
+        first_segment.assign(std::istreambuf_iterator<char>(segment), {});
+
+        ASSERT_TRUE(store.compact());
+        EXPECT_EQ(store.stale_bytes(), 0);
+    }
+
+    // as if the compaction crashed before deleting the input segments.
+    {
+        std::ofstream segment(first_segment_path, std::ios::binary);
+        segment.write(first_segment.data(), std::streamsize(first_segment.size()));
+    }
+
+    database::EmbeddedKvStore store{ dir, options };
+    ASSERT_TRUE(store.is_open());
+    EXPECT_FALSE(fs::exists(first_segment_path));
+    EXPECT_EQ(store.num_of_keys(), 50);
+    EXPECT_EQ(get(store, "removed").status, database::KvStatus::not_found);
+    EXPECT_EQ(to_string(get(store, "key0").value), "value");
+}
+
+TEST(embedded_kv_store, stale_segments_are_compacted_in_background)
+{
+    auto dir = make_store_dir("kv_background_compaction");
+    database::EmbeddedKvStore::Options options;
+    options.max_segment_size = 1024;
+    options.compaction_min_stale_bytes = 4096;
+
+    database::EmbeddedKvStore store{ dir, options };
+    for (int version = 0; version < 1000; version++)
+        upsert(store, "key", "version" + std::to_string(version));
+    store.wait_for_compaction();
+
+    // each segment holds ~20 records. after the compaction, stale records are under the threshold (~5 segments).
+    EXPECT_LT(store.num_of_segments(), 8);
+    EXPECT_LT(store.stale_bytes(), options.compaction_min_stale_bytes);
+    EXPECT_EQ(to_string(get(store, "key").value), "version999");
+}
@@ -0,0 +1,111 @@
+#include "pch.h"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "io/async_task.h"
+#include "io/executor.h"
+
+namespace
+{
+    // ManualExecutor queues resumptions and runs them on the thread which invokes run().
+    class ManualExecutor : public io::Executor
+    {
+    public:
+        bool post(io::ResumeEvent& event) override
+        {
+            if (reject_posts)
+                return false;
+
+            std::lock_guard<std::mutex> lock(events_lock);
+            events.push_back(&event);
+            return true;
+        }
+
+        std::size_t run()
+        {
+            set_current(this);
+
+            std::vector<io::ResumeEvent*> pending_events;
+            {
+                std::lock_guard<std::mutex> lock(events_lock);
+                pending_events.swap(events);
+            }
+            for (auto event : pending_events)
+                event->on_event_complete(nullptr, 0);
+
+            set_current(nullptr);
+            return pending_events.size();
+        }
+
+        // invoke the function as if it is an event of the executor.
+        template <typename Func>
+        void run_as_current(Func&& func)
+        {
+            set_current(this);
+            func();
+            set_current(nullptr);
+        }
+
+        bool reject_posts = false;
+
+    private:
+        std::mutex events_lock;
+        std::vector<io::ResumeEvent*> events;
+    };
+
+    io::DetachedTask switch_to(io::Executor& executor, std::thread::id& resumed_thread, bool& is_completed)
+    {
+        co_await io::resume_on(executor);
+        resumed_thread = std::this_thread::get_id();
+        is_completed = true;
+    }
+}
+
+TEST(executor, resume_on_continues_on_executor_thread)
+{
+    ManualExecutor executor;
+    std::thread::id resumed_thread;
+    bool is_completed = false;
+
+    switch_to(executor, resumed_thread, is_completed);
+    EXPECT_FALSE(is_completed);
+
+    std::thread::id executor_thread;
+    std::thread([&] {
+        executor_thread = std::this_thread::get_id();
+        EXPECT_EQ(executor.run(), 1);
+    }).join();
+
+    EXPECT_TRUE(is_completed);
+    EXPECT_EQ(resumed_thread, executor_thread);
+}
+
+TEST(executor, resume_on_current_executor_does_not_suspend)
+{
+    ManualExecutor executor;
+    std::thread::id resumed_thread;
+    bool is_completed = false;
+
+    executor.run_as_current([&] {
+        switch_to(executor, resumed_thread, is_completed);
+    });
+
+    EXPECT_TRUE(is_completed);
+    EXPECT_EQ(resumed_thread, std::this_thread::get_id());
+    EXPECT_EQ(executor.run(), 0);
+}
+
+TEST(executor, resume_on_continues_in_place_if_post_failed)
+{
+    ManualExecutor executor;
+    executor.reject_posts = true;
+
+    std::thread::id resumed_thread;
+    bool is_completed = false;
+    switch_to(executor, resumed_thread, is_completed);
+
+    EXPECT_TRUE(is_completed);
+    EXPECT_EQ(resumed_thread, std::this_thread::get_id());
+}
@@ -0,0 +1,56 @@
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "win/file_mapping.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr std::size_t file_size = 4 * win::FileMapping::dirty_chunk_size;
+
+    fs::path create_test_file()
+    {
+        auto file_path = fs::temp_directory_path() / "mmocraft_file_mapping_test.bin";
+        {
+            std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+        }
+        fs::resize_file(file_path, file_size);
+        return file_path;
+    }
+}
+
+TEST(file_mapping, flush_only_dirty_ranges)
+{
+    auto file_path = create_test_file();
+    {
+        win::FileMapping mapping;
+        ASSERT_TRUE(mapping.open(file_path.string(), { .prefetch = true }));
+        EXPECT_EQ(mapping.size(), file_size);
+
+        mapping.data()[0] = std::byte(1);
+        mapping.data()[100] = std::byte(2);
+        mapping.data()[3 * win::FileMapping::dirty_chunk_size + 5] = std::byte(3);
+
+        mapping.mark_dirty(0);
+        mapping.mark_dirty(100);
+        mapping.mark_dirty(3 * win::FileMapping::dirty_chunk_size + 5);
+
+        EXPECT_EQ(mapping.flush_dirty(), 2 * win::FileMapping::dirty_chunk_size);
+        EXPECT_EQ(mapping.flush_dirty(), 0);
+
+        // adjacent dirty chunks are written back at once.
+        mapping.mark_dirty(win::FileMapping::dirty_chunk_size - 1, 2);
+        EXPECT_EQ(mapping.flush_dirty(), 2 * win::FileMapping::dirty_chunk_size);
+    }
+
+    std::ifstream file(file_path, std::ios::binary);
+    char first_byte = 0;
+    file.read(&first_byte, 1);
+    EXPECT_EQ(first_byte, 1);
+
+    file.close();
+    fs::remove(file_path);
+}
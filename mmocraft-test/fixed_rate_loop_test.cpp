@@ -0,0 +1,122 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include "util/fixed_rate_loop.h"
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    // runs ticks on a manual clock. phases take time by advance(), and sleeping jumps to the deadline.
+    class ManualClockLoop : public util::FixedRateLoop
+    {
+    public:
+        using FixedRateLoop::FixedRateLoop;
+
+        void advance(clock::duration duration)
+        {
+            current += duration;
+        }
+
+        clock::duration elapsed() const
+        {
+            return current - clock::time_point{};
+        }
+
+    protected:
+        clock::time_point now() const override
+        {
+            return current;
+        }
+
+        void sleep_until(clock::time_point deadline) override
+        {
+            current = std::max(current, deadline);
+        }
+
+    private:
+        clock::time_point current{};
+    };
+
+    // the first tick takes first_tick_duration, and the loop stops after num_of_ticks.
+    void run_ticks(ManualClockLoop& loop, std::size_t num_of_ticks, std::chrono::milliseconds first_tick_duration)
+    {
+        std::size_t tick = 0;
+        loop.add_phase("work", 20 * 1000, [&] {
+            if (tick++ == 0)
+                loop.advance(first_tick_duration);
+            if (tick == num_of_ticks)
+                loop.stop();
+        });
+        loop.run();
+    }
+}
+
+TEST(fixed_rate_loop, phases_run_in_order_at_fixed_rate)
+{
+    ManualClockLoop loop{ 10 };
+
+    std::string order;
+    loop.add_phase("first", 0, [&order] { order += 'a'; });
+    loop.add_phase("second", 0, [&order, &loop] {
+        order += 'b';
+        if (order.size() == 10)
+            loop.stop();
+    });
+
+    loop.run();
+
+    EXPECT_EQ(order, "ababababab");
+    EXPECT_EQ(loop.num_of_ticks(), 5);
+    EXPECT_EQ(loop.num_of_overrun_ticks(), 0);
+    EXPECT_EQ(loop.phase_durations(0).count, 5);
+    EXPECT_EQ(loop.elapsed(), 50ms);   // sleeps until the next tick after stopped.
+}
+
+TEST(fixed_rate_loop, overrun_ticks_are_caught_up)
+{
+    ManualClockLoop loop{ 10 };
+
+    // lags 2 ticks behind at 35ms. the ticks due at 10, 20 and 30ms are run immediately.
+    run_ticks(loop, 6, 35ms);
+
+    EXPECT_EQ(loop.num_of_ticks(), 6);
+    EXPECT_EQ(loop.num_of_overrun_ticks(), 3);
+    EXPECT_EQ(loop.num_of_dropped_ticks(), 0);
+    EXPECT_EQ(loop.phase(0).num_of_overruns.load(), 1);  // only the first tick exceeds the budget.
+
+    // the schedule is kept, not shifted by the overrun.
+    EXPECT_EQ(loop.elapsed(), 60ms);
+}
+
+TEST(fixed_rate_loop, long_backlog_is_dropped)
+{
+    ManualClockLoop loop{ 10 };
+
+    run_ticks(loop, 2, 100ms);
+
+    EXPECT_EQ(loop.num_of_ticks(), 2);
+    EXPECT_EQ(loop.num_of_overrun_ticks(), 1);
+    EXPECT_EQ(loop.num_of_dropped_ticks(), 9);
+
+    // the schedule restarts from the end of the overrun tick.
+    EXPECT_EQ(loop.elapsed(), 110ms);
+}
+
+TEST(fixed_rate_loop, reset_statistics)
+{
+    ManualClockLoop loop{ 10 };
+    run_ticks(loop, 2, 100ms);
+
+    loop.reset_statistics();
+
+    EXPECT_EQ(loop.num_of_ticks(), 0);
+    EXPECT_EQ(loop.num_of_overrun_ticks(), 0);
+    EXPECT_EQ(loop.num_of_dropped_ticks(), 0);
+    EXPECT_EQ(loop.tick_durations().count, 0);
+    EXPECT_EQ(loop.phase_durations(0).count, 0);
+    EXPECT_EQ(loop.phase(0).num_of_overruns.load(), 0);
+}
@@ -1,6 +1,7 @@
 #include "pch.h"
 
 #include "game/history_buffer.h"
+#include "game/block_physics.h"
 
 TEST(history_buffer, block_history_working_properly)
 {
@@ -41,4 +42,24 @@ TEST(history_buffer, clear_snapshot_properly)
     block_history.clear_snapshot();
 
     EXPECT_EQ(block_history.size(), 0);
+}
+
+TEST(history_buffer, add_records_leaves_reserved_records)
+{
+    game::BlockHistory block_history;
+    constexpr std::size_t reserved_records = 16;
+
+    game::BlockChange change{ .pos = { 1, 2, 3 }, .block_id = game::block_id::water };
+    std::vector<game::BlockChange> changes(4, change);
+
+    std::size_t num_of_records = 0;
+    while (block_history.add_records(changes, reserved_records))
+        num_of_records += changes.size();
+
+    EXPECT_LE(num_of_records + reserved_records, game::BlockHistory::max_records);
+    EXPECT_GT(num_of_records + reserved_records + changes.size(), game::BlockHistory::max_records);
+
+    // the reserved room is still available to single records.
+    for (std::size_t i = 0; i < reserved_records; i++)
+        EXPECT_TRUE(block_history.add_record({ 4, 5, 6 }, game::block_id::dirt));
 }
\ No newline at end of file
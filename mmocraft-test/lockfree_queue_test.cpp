@@ -0,0 +1,198 @@
+#include "pch.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "util/intrusive_stack.h"
+#include "util/lockfree_stack.h"
+#include "util/mpsc_queue.h"
+
+namespace
+{
+    struct StackItem : util::IntrusiveStackNode
+    {
+        int producer = 0;
+        int sequence = 0;
+    };
+
+    struct QueueItem : util::MpscQueueNode
+    {
+        int producer = 0;
+        int sequence = 0;
+    };
+
+    constexpr int num_of_producers = 4;
+
+    template <typename Function>
+    void run_producers(Function&& produce)
+    {
+        std::vector<std::thread> producers;
+        for (int producer = 0; producer < num_of_producers; producer++)
+            producers.emplace_back(produce, producer);
+
+        for (auto& thread : producers)
+            thread.join();
+    }
+
+    template <typename Function>
+    void print_elapsed_per_op(const char* name, std::size_t num_of_ops, Function&& benchmark)
+    {
+        auto start_at = std::chrono::steady_clock::now();
+        benchmark();
+        auto elapsed = std::chrono::steady_clock::now() - start_at;
+
+        std::cout << name << ": "
+                  << std::chrono::duration<double, std::nano>(elapsed).count() / num_of_ops << " ns/op\n";
+    }
+}
+
+TEST(intrusive_stack, push_and_pop_in_lifo_order)
+{
+    util::IntrusiveStack<StackItem> stack;
+    StackItem items[3];
+
+    for (auto& item : items)
+        stack.push(&item);
+
+    EXPECT_EQ(stack.pop(), &items[2]);
+    EXPECT_EQ(stack.pop(), &items[1]);
+    EXPECT_EQ(stack.pop(), &items[0]);
+    EXPECT_EQ(stack.pop(), nullptr);
+    EXPECT_TRUE(stack.empty());
+}
+
+TEST(intrusive_stack, concurrent_push_and_pop_keep_all_nodes)
+{
+    constexpr int num_of_items = 10'000;
+    util::IntrusiveStack<StackItem> stack;
+    std::vector<StackItem> items(num_of_items);
+    for (auto& item : items)
+        stack.push(&item);
+
+    // every thread pops a node and pushes it back repeatedly, which provokes ABA without the tag.
+    run_producers([&stack](int) {
+        for (int i = 0; i < 100'000; i++) {
+            if (auto item = stack.pop())
+                stack.push(item);
+        }
+    });
+
+    int num_of_popped = 0;
+    for (auto item = stack.pop_all(); item; item = stack.next_of(item))
+        num_of_popped++;
+
+    EXPECT_EQ(num_of_popped, num_of_items);
+}
+
+TEST(mpsc_queue, pop_in_fifo_order)
+{
+    util::MpscQueue<QueueItem> queue;
+    QueueItem items[3];
+
+    EXPECT_TRUE(queue.empty());
+    for (auto& item : items)
+        queue.push(&item);
+
+    EXPECT_EQ(queue.pop(), &items[0]);
+    EXPECT_EQ(queue.pop(), &items[1]);
+    EXPECT_EQ(queue.pop(), &items[2]);
+    EXPECT_EQ(queue.pop(), nullptr);
+    EXPECT_TRUE(queue.empty());
+
+    queue.push(&items[1]);
+    EXPECT_EQ(queue.pop(), &items[1]);
+}
+
+TEST(mpsc_queue, concurrent_producers_keep_their_order)
+{
+    constexpr int num_of_items = 100'000;
+    util::MpscQueue<QueueItem> queue;
+    std::vector<std::vector<QueueItem>> items(num_of_producers, std::vector<QueueItem>(num_of_items));
+
+    std::thread consumer([&queue] {
+        int next_sequences[num_of_producers] = {};
+        for (int num_of_popped = 0; num_of_popped < num_of_producers * num_of_items;) {
+            auto item = queue.pop();
+            if (item == nullptr)
+                continue;
+
+            EXPECT_EQ(item->sequence, next_sequences[item->producer]++);
+            num_of_popped++;
+        }
+    });
+
+    run_producers([&queue, &items](int producer) {
+        for (int i = 0; i < num_of_items; i++) {
+            auto& item = items[producer][i];
+            item.producer = producer;
+            item.sequence = i;
+            queue.push(&item);
+        }
+    });
+
+    consumer.join();
+    EXPECT_TRUE(queue.empty());
+}
+
+// microbenchmarks: run with --gtest_also_run_disabled_tests --gtest_filter=*benchmark*
+TEST(lockfree_queue, DISABLED_benchmark_producers_to_single_consumer)
+{
+    constexpr int num_of_items = 1'000'000;
+    constexpr std::size_t num_of_ops = std::size_t(num_of_producers) * num_of_items;
+
+    print_elapsed_per_op("LockfreeStack", num_of_ops, [] {
+        util::LockfreeStack<int> stack;
+        std::atomic<bool> done{ false };
+
+        std::thread consumer([&] {
+            while (not done.load() || not stack.empty())
+                stack.pop();
+        });
+
+        run_producers([&stack](int) {
+            for (int i = 0; i < num_of_items; i++)
+                stack.push(i);
+        });
+
+        done.store(true);
+        consumer.join();
+    });
+
+    std::vector<std::vector<StackItem>> stack_items(num_of_producers, std::vector<StackItem>(num_of_items));
+    print_elapsed_per_op("IntrusiveStack", num_of_ops, [&stack_items] {
+        util::IntrusiveStack<StackItem> stack;
+        std::atomic<bool> done{ false };
+
+        std::thread consumer([&] {
+            while (not done.load() || not stack.empty())
+                stack.pop_all();
+        });
+
+        run_producers([&stack, &stack_items](int producer) {
+            for (auto& item : stack_items[producer])
+                stack.push(&item);
+        });
+
+        done.store(true);
+        consumer.join();
+    });
+
+    std::vector<std::vector<QueueItem>> queue_items(num_of_producers, std::vector<QueueItem>(num_of_items));
+    print_elapsed_per_op("MpscQueue", num_of_ops, [&queue_items] {
+        util::MpscQueue<QueueItem> queue;
+
+        std::thread consumer([&] {
+            for (std::size_t num_of_popped = 0; num_of_popped < num_of_ops;)
+                num_of_popped += queue.pop() != nullptr;
+        });
+
+        run_producers([&queue, &queue_items](int producer) {
+            for (auto& item : queue_items[producer])
+                queue.push(&item);
+        });
+
+        consumer.join();
+    });
+}
@@ -0,0 +1,91 @@
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "logging/logger.h"
+#include "logging/log_ring.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    std::vector<std::byte> make_record(std::size_t size, std::uint32_t line)
+    {
+        std::vector<std::byte> record(size);
+        logging::RecordHeader header{ .size = std::uint32_t(size), .level = logging::log_level::info, .line = line };
+        std::memcpy(record.data(), &header, sizeof(header));
+        return record;
+    }
+}
+
+TEST(log_ring, records_are_consumed_across_wrap_around)
+{
+    logging::LogRing ring(1024);
+
+    std::uint32_t next_write_line = 0, next_read_line = 0;
+    for (int round = 0; round < 100; round++) {
+        // variable sizes make records straddle the end of the ring.
+        while (ring.try_write(make_record(40 + next_write_line % 7 * 24, next_write_line).data(), 40 + next_write_line % 7 * 24))
+            next_write_line++;
+
+        ring.consume([&next_read_line](const logging::RecordHeader& header, const std::byte*) {
+            EXPECT_EQ(header.line, next_read_line);
+            EXPECT_EQ(header.size, 40 + next_read_line % 7 * 24);
+            next_read_line++;
+        });
+    }
+
+    EXPECT_EQ(next_read_line, next_write_line);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(logger, binary_log_is_decoded_to_text)
+{
+    auto log_dir = fs::temp_directory_path() / "mmocraft_logger_test";
+    logging::initialize_system(log_dir.string(), "test.log", true);
+
+    LOG(info) << "answer=" << 42 << ' ' << -1.5 << " name=" << std::string("steve") << ' ' << true;
+    LOG(error) << "error code " << 7u;
+    logging::shutdown_system();
+
+    std::ifstream general_log(log_dir / "test.log", std::ios::binary);
+    std::stringstream general_text;
+    ASSERT_TRUE(logging::decode_log_file(general_log, general_text));
+    EXPECT_NE(general_text.str().find("[Info]"), std::string::npos);
+    EXPECT_NE(general_text.str().find("logger_test.cpp("), std::string::npos);
+    EXPECT_NE(general_text.str().find("answer=42 -1.5 name=steve 1"), std::string::npos);
+
+    std::ifstream error_log(log_dir / "error_test.log", std::ios::binary);
+    std::stringstream error_text;
+    ASSERT_TRUE(logging::decode_log_file(error_log, error_text));
+    EXPECT_NE(error_text.str().find("[Error]"), std::string::npos);
+    EXPECT_NE(error_text.str().find("error code 7"), std::string::npos);
+
+    general_log.close();
+    error_log.close();
+    fs::remove_all(log_dir);
+}
+
+TEST(logger, file_name_is_decoded_after_console_log)
+{
+    auto log_dir = fs::temp_directory_path() / "mmocraft_logger_test";
+    logging::initialize_system(log_dir.string(), "test.log", true);
+
+    // the console record is formatted first, with the name of the same source file.
+    CONSOLE_LOG(info) << "console first";
+    LOG(info) << "file second";
+    logging::shutdown_system();
+
+    std::ifstream general_log(log_dir / "test.log", std::ios::binary);
+    std::stringstream general_text;
+    ASSERT_TRUE(logging::decode_log_file(general_log, general_text));
+    EXPECT_NE(general_text.str().find("logger_test.cpp("), std::string::npos);
+    EXPECT_NE(general_text.str().find("file second"), std::string::npos);
+    EXPECT_EQ(general_text.str().find("console first"), std::string::npos);
+
+    general_log.close();
+    fs::remove_all(log_dir);
+}
@@ -0,0 +1,67 @@
+#include "pch.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util/lru_cache.h"
+#include "util/time_util.h"
+
+TEST(lru_cache, least_recently_used_entry_is_evicted)
+{
+    util::ShardedLruCache<int> cache{ 2, 60 * 1000, 1 };
+
+    cache.put("a", 1);
+    cache.put("b", 2);
+    EXPECT_EQ(cache.get("a"), 1);  // "b" is the least recently used.
+
+    cache.put("c", 3);
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_FALSE(cache.get("b").has_value());
+    EXPECT_EQ(cache.get("a"), 1);
+    EXPECT_EQ(cache.get("c"), 3);
+
+    cache.put("a", 4);
+    EXPECT_EQ(cache.get("a"), 4);
+    EXPECT_TRUE(cache.erase("a"));
+    EXPECT_FALSE(cache.erase("a"));
+    EXPECT_FALSE(cache.get("a").has_value());
+}
+
+TEST(lru_cache, entry_expires_after_ttl)
+{
+    util::ShardedLruCache<std::string> cache{ 16, 50 };
+    util::update_coarse_monotonic_tick();
+
+    cache.put("player", "session");
+    EXPECT_EQ(cache.get("player"), "session");
+
+    util::sleep_ms(100);
+    util::update_coarse_monotonic_tick();
+    EXPECT_FALSE(cache.get("player").has_value());
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(lru_cache, shards_are_accessed_concurrently)
+{
+    constexpr int num_of_threads = 4;
+    constexpr int num_of_keys = 1000;
+
+    util::ShardedLruCache<int> cache{ num_of_threads * num_of_keys * 2, 60 * 1000 };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_of_threads; t++) {
+        threads.emplace_back([&cache, t] {
+            for (int i = 0; i < num_of_keys; i++) {
+                auto key = std::to_string(t) + ':' + std::to_string(i);
+                cache.put(key, i);
+                EXPECT_EQ(cache.get(key), i);
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_LE(cache.size(), std::size_t(num_of_threads * num_of_keys));
+    EXPECT_EQ(cache.get("3:999"), 999);
+}
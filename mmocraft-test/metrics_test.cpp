@@ -0,0 +1,113 @@
+#include "pch.h"
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics/metrics.h"
+
+TEST(metrics, histogram_bucket_bounds_contain_values)
+{
+    using metrics::Histogram;
+
+    for (std::uint64_t value : { 0ull, 1ull, 7ull, 8ull, 9ull, 15ull, 16ull, 100ull, 1000ull, 123456ull, (1ull << 39) + 5 }) {
+        auto index = Histogram::bucket_index(value);
+        ASSERT_LT(index, Histogram::num_of_buckets);
+        EXPECT_LE(value, Histogram::bucket_upper_bound(index));
+        if (index > 0)
+            EXPECT_GT(value, Histogram::bucket_upper_bound(index - 1));
+    }
+
+    // relative error is bounded by the number of sub buckets.
+    auto index = Histogram::bucket_index(1000);
+    EXPECT_LE(Histogram::bucket_upper_bound(index) - 1000, 1000 / Histogram::num_of_sub_buckets);
+
+    // too large values are counted in the last bucket.
+    EXPECT_EQ(Histogram::bucket_index(~0ull), Histogram::num_of_buckets - 1);
+}
+
+TEST(metrics, histogram_percentile)
+{
+    metrics::Histogram histogram;
+    for (std::uint64_t value = 1; value <= 1000; value++)
+        histogram.record(value);
+
+    auto snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count, 1000);
+    EXPECT_EQ(snapshot.sum, 1000 * 1001 / 2);
+
+    auto p50 = snapshot.percentile(50);
+    EXPECT_GE(p50, 500);
+    EXPECT_LE(p50, 500 + 500 / metrics::Histogram::num_of_sub_buckets);
+    EXPECT_GE(snapshot.percentile(100), 1000);
+    EXPECT_EQ(snapshot.count_less_or_equal(7), 7);
+}
+
+TEST(metrics, counter_sums_all_threads)
+{
+    metrics::Counter counter;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++)
+        threads.emplace_back([&counter] {
+            for (int j = 0; j < 10000; j++)
+                counter.add();
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(counter.value(), 80000);
+}
+
+TEST(metrics, registry_exports_prometheus_text)
+{
+    metrics::Registry registry;
+
+    auto& counter = registry.counter("test_requests_total{task=\"a\"}", "Requests.");
+    EXPECT_EQ(&counter, &registry.counter("test_requests_total{task=\"a\"}", "Requests."));
+    counter.add(3);
+    registry.counter("test_requests_total{task=\"b\"}", "Requests.").add(4);
+    registry.gauge("test_players", "Players.").set(-2);
+    registry.histogram("test_latency_us", "Latency.").record(5);
+
+    auto text = registry.export_text();
+
+    EXPECT_NE(text.find("# TYPE test_requests_total counter\n"), std::string::npos);
+    EXPECT_EQ(text.find("# TYPE test_requests_total", text.find("# TYPE test_requests_total") + 1), std::string::npos);
+    EXPECT_NE(text.find("test_requests_total{task=\"a\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("test_requests_total{task=\"b\"} 4\n"), std::string::npos);
+    EXPECT_NE(text.find("test_players -2\n"), std::string::npos);
+
+    EXPECT_NE(text.find("# TYPE test_latency_us histogram\n"), std::string::npos);
+    EXPECT_NE(text.find("test_latency_us_bucket{le=\"3\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("test_latency_us_bucket{le=\"7\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_latency_us_bucket{le=\"+Inf\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_latency_us_sum 5\n"), std::string::npos);
+    EXPECT_NE(text.find("test_latency_us_count 1\n"), std::string::npos);
+}
+
+TEST(metrics, registry_rejects_another_type)
+{
+    metrics::Registry registry;
+    registry.counter("test_events", "Events.");
+
+    EXPECT_THROW(registry.gauge("test_events", "Events."), std::invalid_argument);
+    EXPECT_THROW(registry.histogram("test_events", "Events."), std::invalid_argument);
+}
+
+TEST(metrics, histogram_snapshot_difference)
+{
+    metrics::Histogram histogram;
+    histogram.record(3);
+    auto earlier = histogram.snapshot();
+
+    histogram.record(1000);
+    histogram.record(1000);
+    auto diff = histogram.snapshot() - earlier;
+
+    EXPECT_EQ(diff.count, 2);
+    EXPECT_EQ(diff.sum, 2000);
+    EXPECT_EQ(diff.mean(), 1000);
+    EXPECT_EQ(diff.count_less_or_equal(7), 0);
+}
@@ -1,4 +1,9 @@
 #include "pch.h"
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <thread>
 #include <vector>
 
 #include "win/object_pool.h"
@@ -123,4 +128,228 @@ TEST(object_pool, free_object_by_pointer) {
 	// check if objects deleted properly.
 	auto obj4 = object_pool.new_object_raw(1, 'a');
 	EXPECT_TRUE(object_pool.free_object(obj4));
-}
\ No newline at end of file
+}
+
+TEST(object_pool, concurrent_new_and_free_100k) {
+	const int max_capacity = 100'000;
+	const int num_of_threads = 8;
+	const int num_of_rounds = 20;
+	const int objects_per_thread = max_capacity / num_of_threads;
+
+	win::ObjectPool<Foo> object_pool(max_capacity);
+
+	std::vector<std::vector<Foo*>> allocated_objects(num_of_threads);
+	std::barrier round_barrier(num_of_threads);
+	std::atomic<int> num_of_failures{ 0 };
+
+	auto worker = [&](int thread_id) {
+		for (int round = 0; round < num_of_rounds; round++) {
+			auto& objects = allocated_objects[thread_id];
+			for (int i = 0; i < objects_per_thread; i++) {
+				auto obj = object_pool.new_object_raw(thread_id, 'a');
+				if (obj == nullptr)
+					num_of_failures++;
+				else
+					objects.push_back(obj);
+			}
+
+			round_barrier.arrive_and_wait();
+
+			// free objects allocated by the neighbor thread.
+			auto& neighbor_objects = allocated_objects[(thread_id + 1) % num_of_threads];
+			for (auto obj : neighbor_objects) {
+				if (obj->a != (thread_id + 1) % num_of_threads || not object_pool.free_object(obj))
+					num_of_failures++;
+			}
+
+			round_barrier.arrive_and_wait();
+			neighbor_objects.clear();
+			round_barrier.arrive_and_wait();
+		}
+	};
+
+	auto started_at = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < num_of_threads; i++)
+		threads.emplace_back(worker, i);
+	for (auto& thread : threads)
+		thread.join();
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started_at);
+	RecordProperty("elapsed_ms", int(elapsed.count()));
+
+	EXPECT_EQ(num_of_failures, 0);
+	EXPECT_EQ(object_pool.capacity(), max_capacity);
+
+	// all objects are returned to the pool.
+	std::vector<Foo*> objects;
+	for (int i = 0; i < max_capacity; i++)
+		objects.push_back(object_pool.new_object_raw(i, 'a'));
+
+	EXPECT_EQ(std::count(objects.begin(), objects.end(), nullptr), 0);
+	EXPECT_EQ(object_pool.new_object_raw(0, 'a'), nullptr);
+}
+
+TEST(object_pool, remote_free_returns_to_owner_cache) {
+	const int max_capacity = 64;
+	win::ObjectPool<Foo> object_pool(max_capacity, true);
+
+	std::vector<Foo*> objects;
+	while (auto obj = object_pool.new_object_raw(0, 'a'))
+		objects.push_back(obj);
+	EXPECT_EQ(objects.size(), max_capacity);
+
+	// objects freed by another thread go back to the remote-free list of this thread.
+	std::thread([&] {
+		for (auto obj : objects)
+			EXPECT_TRUE(object_pool.free_object(obj));
+	}).join();
+
+	for (std::size_t i = 0; i < objects.size(); i++)
+		EXPECT_NE(object_pool.new_object_raw(0, 'a'), nullptr);
+	EXPECT_EQ(object_pool.new_object_raw(0, 'a'), nullptr);
+}
+
+TEST(object_pool, steal_remote_frees_of_other_thread) {
+	const int max_capacity = 64;
+	win::ObjectPool<Foo> object_pool(max_capacity, true);
+
+	std::vector<Foo*> objects;
+	while (auto obj = object_pool.new_object_raw(0, 'a'))
+		objects.push_back(obj);
+
+	// the objects are freed to the remote-free list of this thread.
+	std::thread([&] {
+		for (auto obj : objects)
+			EXPECT_TRUE(object_pool.free_object(obj));
+	}).join();
+
+	// the pool is exhausted, but another thread can take them.
+	std::thread([&] {
+		for (std::size_t i = 0; i < objects.size(); i++)
+			EXPECT_NE(object_pool.new_object_raw(0, 'a'), nullptr);
+	}).join();
+}
+
+TEST(object_pool, max_capacity_with_objects_in_magazines) {
+	const int max_capacity = 1000;
+	const int num_of_threads = 16;
+	win::ObjectPool<Foo> object_pool(max_capacity, true);
+
+	// each thread leaves objects in its magazine.
+	std::barrier cached_barrier(num_of_threads + 1), done_barrier(num_of_threads + 1);
+	std::vector<std::thread> threads;
+	for (int i = 0; i < num_of_threads; i++) {
+		threads.emplace_back([&] {
+			object_pool.free_object(object_pool.new_object_raw(0, 'a'));
+			cached_barrier.arrive_and_wait();
+			done_barrier.arrive_and_wait();
+		});
+	}
+	cached_barrier.arrive_and_wait();
+
+	// objects in the magazines of other threads are drained, but no more than max_capacity.
+	std::vector<Foo*> objects;
+	for (int i = 0; i < max_capacity; i++)
+		objects.push_back(object_pool.new_object_raw(i, 'a'));
+	EXPECT_EQ(std::count(objects.begin(), objects.end(), nullptr), 0);
+	EXPECT_EQ(object_pool.new_object_raw(0, 'a'), nullptr);
+
+	done_barrier.arrive_and_wait();
+	for (auto& thread : threads)
+		thread.join();
+}
+
+TEST(object_pool, thread_cache_slots_are_recycled) {
+	win::ObjectPool<Foo> object_pool(1000, true);
+
+	// more threads than slots are created one after another.
+	for (std::size_t i = 0; i < 2 * win::MAX_THREAD_CACHE_SLOTS; i++) {
+		std::thread([&] {
+			EXPECT_LT(win::current_thread_cache_slot(), win::MAX_THREAD_CACHE_SLOTS);
+			EXPECT_TRUE(object_pool.free_object(object_pool.new_object_raw(0, 'a')));
+			win::release_thread_caches();
+		}).join();
+	}
+
+	std::vector<Foo*> objects;
+	for (int i = 0; i < 1000; i++)
+		objects.push_back(object_pool.new_object_raw(i, 'a'));
+	EXPECT_EQ(std::count(objects.begin(), objects.end(), nullptr), 0);
+}
+
+TEST(object_pool, thread_cache_concurrent_new_and_free_100k) {
+	const int max_capacity = 100'000;
+	const int num_of_threads = 8;
+	const int num_of_rounds = 20;
+	const int objects_per_thread = max_capacity / num_of_threads;
+
+	win::ObjectPool<Foo> object_pool(max_capacity, true);
+
+	std::vector<std::vector<Foo*>> allocated_objects(num_of_threads);
+	std::barrier round_barrier(num_of_threads);
+	std::atomic<int> num_of_failures{ 0 };
+
+	auto worker = [&](int thread_id) {
+		for (int round = 0; round < num_of_rounds; round++) {
+			auto& objects = allocated_objects[thread_id];
+			for (int i = 0; i < objects_per_thread; i++) {
+				auto obj = object_pool.new_object_raw(thread_id, 'a');
+				if (obj == nullptr)
+					num_of_failures++;
+				else
+					objects.push_back(obj);
+			}
+
+			round_barrier.arrive_and_wait();
+
+			// half of the objects are freed by the owner, the others by the neighbor thread.
+			auto& neighbor_objects = allocated_objects[(thread_id + 1) % num_of_threads];
+			for (std::size_t i = 0; i < neighbor_objects.size(); i += 2) {
+				if (not object_pool.free_object(neighbor_objects[i]))
+					num_of_failures++;
+			}
+
+			round_barrier.arrive_and_wait();
+
+			for (std::size_t i = 1; i < objects.size(); i += 2) {
+				if (objects[i]->a != thread_id || not object_pool.free_object(objects[i]))
+					num_of_failures++;
+			}
+			objects.clear();
+
+			round_barrier.arrive_and_wait();
+		}
+
+		win::release_thread_caches();
+	};
+
+	auto started_at = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < num_of_threads; i++)
+		threads.emplace_back(worker, i);
+	for (auto& thread : threads)
+		thread.join();
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started_at);
+	RecordProperty("elapsed_ms", int(elapsed.count()));
+
+	EXPECT_EQ(num_of_failures, 0);
+}
+
+TEST(object_pool, commit_with_memory_options) {
+	const int max_capacity = 10'000;
+	win::VirtualMemoryOptions memory_options{ .huge_pages = true, .numa_node = win::current_numa_node() };
+	win::ObjectPool<Foo> object_pool(max_capacity, false, memory_options);
+
+	EXPECT_TRUE(object_pool.reserve(max_capacity));
+
+	std::vector<Foo*> objects;
+	for (int i = 0; i < max_capacity; i++)
+		objects.push_back(object_pool.new_object_raw(i, 'a'));
+
+	EXPECT_EQ(std::count(objects.begin(), objects.end(), nullptr), 0);
+	EXPECT_EQ(objects.back()->a, max_capacity - 1);
+}
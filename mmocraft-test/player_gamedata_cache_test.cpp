@@ -0,0 +1,107 @@
+#include "pch.h"
+
+#include <future>
+#include <optional>
+#include <string>
+
+#include "database/couchbase_core.h"
+#include "database/player_gamedata_cache.h"
+#include "embedded_database.h"
+
+namespace
+{
+    using database::collection::PlayerGamedata;
+
+    void wait_for_saves(const database::PlayerGamedataCache& cache)
+    {
+        ASSERT_TRUE(test::wait_until([&cache] { return cache.num_of_in_flight_saves() == 0; }));
+    }
+
+    std::optional<PlayerGamedata> load_gamedata(const std::string& player_uuid)
+    {
+        std::promise<std::optional<PlayerGamedata>> promise;
+        auto document_id = player_uuid + ':' + database::to_string(database::CollectionPath::player_gamedata);
+
+        database::CouchbaseCore::backend().get(database::CollectionPath::player_gamedata, document_id,
+            [&promise](couchbase::error err, couchbase::get_result result) {
+                if (err)
+                    promise.set_value(std::nullopt);
+                else
+                    promise.set_value(result.content_as<PlayerGamedata>());
+            });
+        return promise.get_future().get();
+    }
+}
+
+TEST(player_gamedata_cache, updates_are_coalesced_into_one_save)
+{
+    ASSERT_TRUE(test::connect_embedded_database());
+    database::PlayerGamedataCache cache;
+
+    for (std::uint32_t level = 1; level <= 3; level++)
+        cache.update("coalesced", PlayerGamedata{ .latest_pos = 100, .level = level });
+    EXPECT_EQ(cache.num_of_pending_saves(), 1);
+
+    EXPECT_EQ(cache.flush(), 1);
+    wait_for_saves(cache);
+    EXPECT_EQ(load_gamedata("coalesced")->level, 3);
+
+    // unchanged gamedata is not saved again.
+    cache.update("coalesced", PlayerGamedata{ .latest_pos = 100, .level = 3 });
+    EXPECT_EQ(cache.num_of_pending_saves(), 0);
+}
+
+TEST(player_gamedata_cache, in_flight_saves_are_bounded)
+{
+    ASSERT_TRUE(test::connect_embedded_database());
+    database::PlayerGamedataCache cache{ { .max_in_flight_saves = 4, .max_batch_size = 100 } };
+
+    for (int i = 0; i < 10; i++)
+        cache.update("bounded" + std::to_string(i), PlayerGamedata{ .level = 1 });
+
+    EXPECT_EQ(cache.flush(), 4);
+    EXPECT_LE(cache.num_of_in_flight_saves(), 4);
+
+    // the rest is not issued beyond the bound, completed saves take over their slots.
+    EXPECT_EQ(cache.flush(), 0);
+    EXPECT_LE(cache.num_of_in_flight_saves(), 4);
+
+    ASSERT_TRUE(test::wait_until([&cache] {
+        return cache.num_of_pending_saves() == 0 && cache.num_of_in_flight_saves() == 0;
+    }));
+}
+
+TEST(player_gamedata_cache, completed_saves_issue_pending_saves)
+{
+    ASSERT_TRUE(test::connect_embedded_database());
+    database::PlayerGamedataCache cache{ { .max_in_flight_saves = 4, .max_batch_size = 100 } };
+
+    for (int i = 0; i < 20; i++)
+        cache.update("drained" + std::to_string(i), PlayerGamedata{ .level = 2 });
+
+    // flushed only once, the backlog is drained by completions.
+    EXPECT_EQ(cache.flush(), 4);
+    ASSERT_TRUE(test::wait_until([&cache] {
+        return cache.num_of_pending_saves() == 0 && cache.num_of_in_flight_saves() == 0;
+    }));
+
+    for (int i = 0; i < 20; i++)
+        EXPECT_EQ(load_gamedata("drained" + std::to_string(i))->level, 2);
+}
+
+TEST(player_gamedata_cache, released_player_is_dropped_after_save)
+{
+    ASSERT_TRUE(test::connect_embedded_database());
+    database::PlayerGamedataCache cache;
+
+    cache.update("released", PlayerGamedata{ .level = 1 });
+    cache.release("released", PlayerGamedata{ .level = 2 });
+
+    // the unsaved gamedata is served from the cache. (e.g. the player logs in again)
+    EXPECT_EQ(cache.find("released")->level, 2);
+
+    cache.flush();
+    wait_for_saves(cache);
+    EXPECT_FALSE(cache.find("released").has_value());
+    EXPECT_EQ(load_gamedata("released")->level, 2);
+}
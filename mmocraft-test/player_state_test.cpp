@@ -22,4 +22,50 @@ TEST(player_state, transit_properly)
 
     EXPECT_EQ(player_state.prev_state(), game::PlayerState::handshaking);
     EXPECT_EQ(player_state.state(), game::PlayerState::handshaked);
-}
\ No newline at end of file
+}
+
+TEST(player_state, enqueue_on_state_changed)
+{
+    game::PlayerStateQueue state_queue;
+    state_queue.watch(game::PlayerState::handshaked);
+    state_queue.watch(game::PlayerState::disconnecting);
+
+    game::PlayerState player_state;
+    player_state.set_state_queue(&state_queue);
+
+    // not watched state is not enqueued.
+    player_state.prepare_state_transition(game::PlayerState::handshaking, game::PlayerState::handshaked);
+    EXPECT_FALSE(player_state.is_state_queued());
+
+    player_state.transit_state(game::PlayerState::handshaked);
+    EXPECT_TRUE(player_state.is_state_queued());
+
+    // the queued player is not enqueued again.
+    player_state.prepare_state_transition(game::PlayerState::disconnecting, game::PlayerState::disconnected);
+
+    EXPECT_EQ(state_queue.pop(), &player_state);
+    EXPECT_EQ(state_queue.pop(), nullptr);
+    EXPECT_FALSE(player_state.is_state_queued());
+    EXPECT_EQ(player_state.state(), game::PlayerState::disconnecting);
+
+    // the popped player can be enqueued again.
+    player_state.retry_state_transition();
+    EXPECT_EQ(state_queue.pop(), &player_state);
+    EXPECT_EQ(state_queue.pop(), nullptr);
+}
+
+TEST(player_state, queue_is_fifo)
+{
+    game::PlayerStateQueue state_queue;
+    state_queue.watch(game::PlayerState::handshaked);
+
+    game::PlayerState players[3];
+    for (auto& player : players) {
+        player.set_state_queue(&state_queue);
+        player.prepare_state_transition(game::PlayerState::handshaked, game::PlayerState::handshaked);
+    }
+
+    for (auto& player : players)
+        EXPECT_EQ(state_queue.pop(), &player);
+    EXPECT_EQ(state_queue.pop(), nullptr);
+}
@@ -0,0 +1,25 @@
+#include "pch.h"
+
+#include <cstdint>
+
+#include "util/sharded_hash_map.h"
+
+TEST(sharded_hash_map, stale_erase_keeps_newer_value)
+{
+    util::ShardedHashMap<std::uint64_t> directory;
+
+    directory.insert_or_assign("player", 1);
+    directory.insert_or_assign("player", 2);   // logged in again.
+    EXPECT_EQ(directory.find("player"), 2);
+
+    // the logout of the previous connection arrives late.
+    auto is_connection = [](std::uint64_t key) {
+        return [key](std::uint64_t value) { return value == key; };
+    };
+    EXPECT_FALSE(directory.erase_if("player", is_connection(1)));
+    EXPECT_EQ(directory.find("player"), 2);
+
+    EXPECT_TRUE(directory.erase_if("player", is_connection(2)));
+    EXPECT_FALSE(directory.find("player").has_value());
+    EXPECT_EQ(directory.size(), 0);
+}
@@ -0,0 +1,247 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "io/async_task.h"
+#include "io/single_flight.h"
+#include "util/lru_cache.h"
+
+namespace
+{
+    // DatabaseStub completes reads on its own thread, like database callbacks.
+    // a round trip takes the latency and completes up to max_batch_size reads. (limited throughput)
+    class DatabaseStub
+    {
+    public:
+        explicit DatabaseStub(std::chrono::microseconds latency = {}, std::size_t max_batch_size = 64)
+            : _latency{ latency }
+            , _max_batch_size{ max_batch_size }
+            , worker{ [this] { run(); } }
+        { }
+
+        ~DatabaseStub()
+        {
+            {
+                std::lock_guard<std::mutex> lock(queue_lock);
+                is_stopped = true;
+            }
+            queue_cv.notify_one();
+            worker.join();
+        }
+
+        auto read(const std::string& key)
+        {
+            struct ReadAwaiter
+            {
+                DatabaseStub& database;
+                const std::string& key;
+
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+
+                void await_suspend(std::coroutine_handle<> coro)
+                {
+                    database.enqueue(coro);
+                }
+
+                std::string await_resume() const
+                {
+                    return "value of " + key;
+                }
+            };
+            num_of_reads.fetch_add(1, std::memory_order_relaxed);
+            return ReadAwaiter{ *this, key };
+        }
+
+        std::atomic<std::size_t> num_of_reads{ 0 };
+
+    private:
+        void enqueue(std::coroutine_handle<> coro)
+        {
+            {
+                std::lock_guard<std::mutex> lock(queue_lock);
+                pending.push_back(coro);
+            }
+            queue_cv.notify_one();
+        }
+
+        void run()
+        {
+            std::vector<std::coroutine_handle<>> resumable;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(queue_lock);
+                    queue_cv.wait(lock, [this] { return is_stopped || not pending.empty(); });
+                    if (is_stopped && pending.empty())
+                        return;
+
+                    auto batch_size = std::min(pending.size(), _max_batch_size);
+                    resumable.assign(pending.begin(), pending.begin() + batch_size);
+                    pending.erase(pending.begin(), pending.begin() + batch_size);
+                }
+
+                std::this_thread::sleep_for(_latency);
+                for (auto coro : resumable)
+                    coro.resume();
+                resumable.clear();
+            }
+        }
+
+        const std::chrono::microseconds _latency;
+        const std::size_t _max_batch_size;
+
+        std::mutex queue_lock;
+        std::condition_variable queue_cv;
+        std::vector<std::coroutine_handle<>> pending;
+        bool is_stopped = false;
+
+        std::thread worker;
+    };
+
+    struct LoginService
+    {
+        DatabaseStub& database;
+        util::ShardedLruCache<std::string> cache{ 100'000, 60 * 1000 };
+        io::SingleFlight<std::string> flights;
+
+        // same shape as LoginServer::find_player_login.
+        io::AsyncTask<std::string> find(std::string key)
+        {
+            if (auto value = cache.get(key))
+                co_return std::move(*value);
+
+            if (auto shared_value = co_await flights.join(key))
+                co_return std::move(*shared_value);
+
+            auto flight = flights.lead(key, "failed");
+
+            auto value = co_await database.read(key);
+            if (key.starts_with("malformed"))
+                throw std::runtime_error("malformed document");
+
+            cache.put(key, value);
+            flight.complete(value);
+            co_return value;
+        }
+    };
+
+    io::DetachedTask handshake(LoginService& service, std::string key, std::atomic<std::size_t>& num_of_handshakes)
+    {
+        auto value = co_await service.find(key);
+        if (value == "value of " + key)
+            num_of_handshakes.fetch_add(1, std::memory_order_release);
+    }
+
+    io::DetachedTask failed_handshake(LoginService& service, std::string key, std::atomic<std::size_t>& num_of_failures)
+    {
+        auto value = co_await service.find(key);
+        if (value != "value of " + key)
+            num_of_failures.fetch_add(1, std::memory_order_release);
+    }
+
+    io::DetachedTask uncached_handshake(DatabaseStub& database, std::string key, std::atomic<std::size_t>& num_of_handshakes)
+    {
+        auto value = co_await database.read(key);
+        if (value == "value of " + key)
+            num_of_handshakes.fetch_add(1, std::memory_order_release);
+    }
+
+    void wait_for(const std::atomic<std::size_t>& counter, std::size_t expected)
+    {
+        while (counter.load(std::memory_order_acquire) != expected)
+            std::this_thread::yield();
+    }
+}
+
+TEST(single_flight, concurrent_lookups_share_one_read)
+{
+    DatabaseStub database{ std::chrono::milliseconds(10) };
+    LoginService service{ database };
+    std::atomic<std::size_t> num_of_handshakes{ 0 };
+
+    // all lookups join the flight while the first read is in flight.
+    for (int i = 0; i < 100; i++)
+        handshake(service, "player", num_of_handshakes);
+    wait_for(num_of_handshakes, 100);
+
+    EXPECT_EQ(database.num_of_reads.load(), 1);
+    EXPECT_EQ(service.flights.num_of_flights(), 0);
+
+    // served by the cache.
+    handshake(service, "player", num_of_handshakes);
+    wait_for(num_of_handshakes, 101);
+    EXPECT_EQ(database.num_of_reads.load(), 1);
+}
+
+TEST(single_flight, different_keys_do_not_share_flights)
+{
+    DatabaseStub database;
+    LoginService service{ database };
+    std::atomic<std::size_t> num_of_handshakes{ 0 };
+
+    for (int i = 0; i < 10; i++)
+        handshake(service, "player" + std::to_string(i), num_of_handshakes);
+    wait_for(num_of_handshakes, 10);
+
+    EXPECT_EQ(database.num_of_reads.load(), 10);
+}
+
+TEST(single_flight, throwing_leader_completes_the_flight)
+{
+    DatabaseStub database{ std::chrono::milliseconds(10) };
+    LoginService service{ database };
+    std::atomic<std::size_t> num_of_failures{ 0 };
+
+    // followers are resumed with the fallback result instead of waiting forever.
+    for (int i = 0; i < 10; i++)
+        failed_handshake(service, "malformed", num_of_failures);
+    wait_for(num_of_failures, 10);
+
+    EXPECT_EQ(service.flights.num_of_flights(), 0);
+
+    // a later lookup leads a new flight, not joining the dead one.
+    failed_handshake(service, "malformed", num_of_failures);
+    wait_for(num_of_failures, 11);
+    EXPECT_EQ(database.num_of_reads.load(), 2);
+}
+
+// run with --gtest_also_run_disabled_tests --gtest_filter=*benchmark*
+TEST(single_flight, DISABLED_benchmark_reconnect_storm)
+{
+    constexpr std::size_t num_of_players = 1000;
+    constexpr std::size_t num_of_handshakes = 100'000;    // each player reconnects many times.
+
+    for (bool coalescing : { false, true }) {
+        DatabaseStub database{ std::chrono::microseconds(500) };
+        LoginService service{ database };
+        std::atomic<std::size_t> num_of_completed{ 0 };
+
+        auto start_at = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < num_of_handshakes; i++) {
+            auto key = "player" + std::to_string(i % num_of_players);
+            if (coalescing)
+                handshake(service, std::move(key), num_of_completed);
+            else
+                uncached_handshake(database, std::move(key), num_of_completed);
+        }
+
+        wait_for(num_of_completed, num_of_handshakes);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_at;
+
+        std::cout << (coalescing ? "cache + single flight: " : "database only: ")
+                  << std::size_t(num_of_handshakes / elapsed.count()) << " handshakes/s, "
+                  << database.num_of_reads.load() << " database reads\n";
+    }
+}
@@ -0,0 +1,58 @@
+#include "pch.h"
+
+#include <vector>
+
+#include "game/terrain_generator.h"
+#include "util/noise.h"
+
+TEST(terrain_generator, noise_row_matches_scalar_noise)
+{
+    util::GradientNoise noise(12345);
+
+    constexpr std::size_t num_of_samples = 103;
+    std::vector<float> row(num_of_samples);
+
+    noise.noise2_row(-7.3f, 0.37f, 2.9f, row.data(), num_of_samples);
+    for (std::size_t i = 0; i < num_of_samples; i++)
+        EXPECT_NEAR(row[i], noise.noise2(-7.3f + float(int(i)) * 0.37f, 2.9f), 1e-5f);
+
+    noise.noise3_row(-7.3f, 0.37f, 5.1f, 2.9f, row.data(), num_of_samples);
+    for (std::size_t i = 0; i < num_of_samples; i++)
+        EXPECT_NEAR(row[i], noise.noise3(-7.3f + float(int(i)) * 0.37f, 5.1f, 2.9f), 1e-5f);
+}
+
+TEST(terrain_generator, same_seed_generates_same_terrain)
+{
+    util::Coordinate3D map_size{ 64, 32, 48 };
+    const std::size_t map_volume = 64 * 32 * 48;
+
+    std::vector<std::byte> blocks(map_volume), other_blocks(map_volume);
+    game::TerrainGenerator(777, map_size).generate(blocks.data(), 4);
+    game::TerrainGenerator(777, map_size).generate(other_blocks.data(), 1);
+
+    EXPECT_EQ(blocks, other_blocks);
+}
+
+TEST(terrain_generator, columns_are_layered)
+{
+    util::Coordinate3D map_size{ 64, 32, 48 };
+    const std::size_t layer_size = 64 * 48;
+
+    std::vector<std::byte> blocks(layer_size * 32);
+    game::TerrainGenerator generator(42, map_size);
+    generator.generate(blocks.data(), 2);
+
+    std::vector<int> heights(64);
+    generator.generate_heightmap_row(10, heights.data());
+
+    for (int x = 0; x < 64; x++) {
+        auto block_at = [&](int y) { return game::BlockID(blocks[layer_size * y + 64 * 10 + x]); };
+
+        EXPECT_EQ(block_at(0), game::block_id::bedrock);
+        EXPECT_NE(block_at(heights[x]), game::block_id::air);
+        EXPECT_EQ(block_at(31), game::block_id::air);
+
+        if (heights[x] < generator.water_level())
+            EXPECT_EQ(block_at(generator.water_level()), game::block_id::still_water);
+    }
+}
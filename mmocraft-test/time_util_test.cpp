@@ -0,0 +1,39 @@
+#include "pch.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "util/time_util.h"
+
+TEST(time_util, coarse_tick_never_moves_backward)
+{
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++)
+        threads.emplace_back([] {
+            for (int j = 0; j < 10000; j++) {
+                auto before = util::coarse_monotonic_tick();
+                util::update_coarse_monotonic_tick();
+                EXPECT_GE(util::coarse_monotonic_tick(), before);
+            }
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_LE(util::coarse_monotonic_tick(), util::current_monotonic_tick());
+}
+
+TEST(time_util, fine_clock_follows_steady_clock)
+{
+    util::calibrate_fine_clock();
+
+    const auto begin_time = std::chrono::steady_clock::now();
+    const auto begin_ns = util::fine_time_ns();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto end_ns = util::fine_time_ns();
+    const auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin_time).count();
+
+    ASSERT_GT(end_ns, begin_ns);
+    // allow 5% error of the calibration.
+    EXPECT_NEAR(double(end_ns - begin_ns), double(elapsed_ns), elapsed_ns * 0.05);
+}
@@ -0,0 +1,75 @@
+#include "pch.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "metrics/trace.h"
+
+namespace
+{
+    std::size_t count_of(const std::string& str, std::string_view pattern)
+    {
+        std::size_t count = 0;
+        for (auto pos = str.find(pattern); pos != std::string::npos; pos = str.find(pattern, pos + 1))
+            count++;
+        return count;
+    }
+}
+
+TEST(trace, spans_are_recorded_only_while_tracing)
+{
+    {
+        TRACE_SPAN("before_start");
+    }
+
+    metrics::trace::start();
+    {
+        TRACE_SPAN("outer");
+        TRACE_SPAN_ARG("inner", 42);
+    }
+    std::thread([] {
+        TRACE_SPAN("other_thread");
+    }).join();
+    metrics::trace::stop();
+
+    {
+        TRACE_SPAN("after_stop");
+    }
+
+    std::ostringstream trace;
+    ASSERT_TRUE(metrics::trace::write_chrome_trace(trace));
+
+    auto json = trace.str();
+    EXPECT_TRUE(json.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    EXPECT_EQ(count_of(json, "\"ph\":\"X\""), 3);
+    EXPECT_EQ(count_of(json, "\"name\":\"outer\""), 1);
+    EXPECT_EQ(count_of(json, "\"name\":\"inner\""), 1);
+    EXPECT_EQ(count_of(json, "\"args\":{\"arg\":42}"), 1);
+    EXPECT_EQ(count_of(json, "\"name\":\"other_thread\""), 1);
+    EXPECT_EQ(count_of(json, "before_start"), 0);
+    EXPECT_EQ(count_of(json, "after_stop"), 0);
+}
+
+TEST(trace, new_session_discards_previous_events)
+{
+    metrics::trace::start();
+    {
+        TRACE_SPAN("first_session");
+    }
+    metrics::trace::stop();
+
+    metrics::trace::start();
+    for (std::size_t i = 0; i < metrics::trace::max_events_per_thread + 10; i++) {
+        TRACE_SPAN("second_session");
+    }
+    metrics::trace::stop();
+
+    std::ostringstream trace;
+    ASSERT_TRUE(metrics::trace::write_chrome_trace(trace));
+
+    auto json = trace.str();
+    EXPECT_EQ(count_of(json, "first_session"), 0);
+    EXPECT_EQ(count_of(json, "second_session"), metrics::trace::max_events_per_thread);
+    EXPECT_EQ(metrics::trace::num_of_dropped_events(), 10);
+}
@@ -0,0 +1,82 @@
+#include "pch.h"
+
+#include <thread>
+#include <vector>
+
+#include "game/world_transfer_queue.h"
+
+namespace
+{
+    // the queue only carries the target world, never dereferences it.
+    game::World* fake_world(std::uintptr_t id)
+    {
+        return reinterpret_cast<game::World*>(id * 0x1000);
+    }
+}
+
+TEST(world_transfer_queue, pop_in_request_order)
+{
+    game::WorldTransferQueue transfer_queue;
+
+    transfer_queue.push(net::ConnectionKey(1, 100), fake_world(1));
+    transfer_queue.push(net::ConnectionKey(2, 100), fake_world(2));
+    transfer_queue.push(net::ConnectionKey(1, 100), fake_world(3));
+    EXPECT_EQ(transfer_queue.size(), 3);
+
+    // requests of the same player are kept, the world validates each of them.
+    auto transfer = transfer_queue.pop();
+    ASSERT_TRUE(transfer);
+    EXPECT_EQ(transfer->connection_key, net::ConnectionKey(1, 100));
+    EXPECT_EQ(transfer->target_world, fake_world(1));
+
+    transfer = transfer_queue.pop();
+    ASSERT_TRUE(transfer);
+    EXPECT_EQ(transfer->connection_key, net::ConnectionKey(2, 100));
+    EXPECT_EQ(transfer->target_world, fake_world(2));
+
+    transfer = transfer_queue.pop();
+    ASSERT_TRUE(transfer);
+    EXPECT_EQ(transfer->target_world, fake_world(3));
+
+    EXPECT_FALSE(transfer_queue.pop());
+    EXPECT_EQ(transfer_queue.size(), 0);
+}
+
+TEST(world_transfer_queue, requests_from_multiple_threads)
+{
+    constexpr unsigned num_of_threads = 4;
+    constexpr unsigned num_of_requests = 10000;
+
+    game::WorldTransferQueue transfer_queue;
+
+    std::vector<std::thread> io_threads;
+    for (unsigned i = 0; i < num_of_threads; i++) {
+        io_threads.emplace_back([&transfer_queue, i] {
+            for (unsigned sequence = 0; sequence < num_of_requests; sequence++)
+                transfer_queue.push(net::ConnectionKey(i, sequence), fake_world(i + 1));
+        });
+    }
+
+    // requests of each thread are popped in order.
+    unsigned next_sequence[num_of_threads] = {};
+    unsigned num_of_popped = 0;
+
+    while (num_of_popped < num_of_threads * num_of_requests) {
+        auto transfer = transfer_queue.pop();
+        if (not transfer) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        auto thread_index = transfer->connection_key.index();
+        ASSERT_LT(thread_index, num_of_threads);
+        EXPECT_EQ(transfer->connection_key.created_at(), next_sequence[thread_index]++);
+        EXPECT_EQ(transfer->target_world, fake_world(thread_index + 1));
+        num_of_popped++;
+    }
+
+    for (auto& thread : io_threads)
+        thread.join();
+
+    EXPECT_FALSE(transfer_queue.pop());
+}
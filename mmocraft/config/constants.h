@@ -7,6 +7,9 @@ namespace config
     namespace task {
         constexpr int announce_server_period = 5000; // 5s
         constexpr int flush_common_chat_period = 500; // 0.5s
+        constexpr int report_tick_statistics_period = 60 * 1000; // 1m
+        constexpr int export_metrics_period = 10 * 1000; // 10s
+        constexpr int flush_player_gamedata_period = 1000; // 1s
     }
 
     namespace network {
@@ -0,0 +1,151 @@
+#include "pch.h"
+#include "chat_log_writer.h"
+
+#include <vector>
+
+#include "database/couchbase_core.h"
+#include "logging/logger.h"
+#include "metrics/metrics.h"
+#include "util/time_util.h"
+#include "util/uuid_v4.h"
+
+namespace
+{
+    struct WriterMetrics
+    {
+        metrics::Counter& messages = metrics::counter("mmocraft_chat_log_messages_total",
+            "Chat messages logged by batches.");
+        metrics::Counter& batches = metrics::counter("mmocraft_chat_log_batches_total",
+            "Chat log batches inserted. (one document each)");
+        metrics::Counter& dropped = metrics::counter("mmocraft_chat_log_dropped_total",
+            "Chat messages dropped because the database fell behind.");
+        metrics::Counter& errors = metrics::counter("mmocraft_chat_log_errors_total",
+            "Failed chat log batch inserts. (retried)");
+        metrics::Gauge& pending = metrics::gauge("mmocraft_chat_log_pending_messages",
+            "Chat messages waiting to be inserted.");
+    };
+
+    WriterMetrics& writer_metrics()
+    {
+        static WriterMetrics metrics;
+        return metrics;
+    }
+}
+
+namespace database
+{
+    bool ChatLogWriter::append(collection::ChatMessage&& message)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+
+            if (pending_messages >= _options.max_pending_messages) {
+                writer_metrics().dropped.add();
+                return false;
+            }
+
+            if (message.created_at == 0)
+                message.created_at = util::current_timestamp_ms();
+
+            open_batch.messages.push_back(std::move(message));
+            pending_messages++;
+
+            if (open_batch.messages.size() < _options.max_batch_size)
+                return true;
+
+            seal_open_batch();
+        }
+
+        issue_batches();
+        return true;
+    }
+
+    std::size_t ChatLogWriter::flush()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            seal_open_batch();
+        }
+        return issue_batches();
+    }
+
+    std::size_t ChatLogWriter::num_of_pending_messages() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return pending_messages;
+    }
+
+    std::size_t ChatLogWriter::num_of_in_flight_batches() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return in_flight_batches;
+    }
+
+    std::string ChatLogWriter::new_writer_id()
+    {
+        return util::uuid();
+    }
+
+    void ChatLogWriter::seal_open_batch()
+    {
+        if (open_batch.messages.empty())
+            return;
+
+        open_batch.sealed_at = util::current_timestamp_ms();
+        open_batch.first_created_at = open_batch.messages.front().created_at;
+        open_batch.last_created_at = open_batch.messages.back().created_at;
+
+        auto bucket_start = open_batch.sealed_at - open_batch.sealed_at % _options.time_bucket_ms;
+        open_batch.id = "chat:" + std::to_string(bucket_start) + ':' + writer_id + ':' + std::to_string(next_batch_sequence++);
+
+        sealed_batches.push_back(std::move(open_batch));
+        open_batch = {};
+    }
+
+    std::size_t ChatLogWriter::issue_batches()
+    {
+        std::vector<batch_type> batches;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+
+            while (not sealed_batches.empty() && in_flight_batches < _options.max_in_flight_batches) {
+                pending_messages -= sealed_batches.front().messages.size();
+                batches.push_back(std::move(sealed_batches.front()));
+                sealed_batches.pop_front();
+                in_flight_batches++;
+            }
+            writer_metrics().pending.set(std::int64_t(pending_messages));
+        }
+
+        for (auto& batch : batches)
+            insert(std::move(batch));
+
+        return batches.size();
+    }
+
+    io::DetachedTask ChatLogWriter::insert(batch_type batch)
+    {
+        // upserted, as a timed-out insert may have succeeded before the retry.
+        auto [err, result] = co_await CouchbaseCore::upsert_document(_collection_path, batch.id, batch);
+        CONSOLE_LOG_IF(error, err) << "Fail to insert chat log: " << err.ec();
+
+        complete_insert(std::move(batch), not err);
+    }
+
+    void ChatLogWriter::complete_insert(batch_type&& batch, bool is_succeeded)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        in_flight_batches--;
+
+        if (is_succeeded) {
+            writer_metrics().batches.add();
+            writer_metrics().messages.add(batch.messages.size());
+            return;
+        }
+
+        // retried ahead of newer batches, and counted as pending so that appends are throttled.
+        writer_metrics().errors.add();
+        pending_messages += batch.messages.size();
+        sealed_batches.push_front(std::move(batch));
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include "database/couchbase_definitions.h"
+#include "io/async_task.h"
+#include "util/noncopyable.h"
+
+namespace database
+{
+    // ChatLogWriter logs chat messages in batches. (one document per batch, instead of one per message)
+    //
+    // - appended messages are sealed into a batch when it is full, or by flush() at the flush period.
+    // - a batch is keyed by the time bucket it is sealed in, so logs can be scanned by time.
+    //   (chat:<bucket start ms>:<writer>:<sequence>, the writer is unique per process)
+    // - at most max_in_flight_batches inserts are in flight, and sealed batches wait for them.
+    // - if the database falls behind and max_pending_messages are buffered, new messages are dropped. (backpressure)
+    // - a failed batch is retried by a later flush.
+    //
+    // thread-safe.
+    class ChatLogWriter : util::NonCopyable, util::NonMovable
+    {
+    public:
+        struct Options
+        {
+            std::size_t max_batch_size = 256;
+            std::size_t max_in_flight_batches = 4;
+            std::size_t max_pending_messages = 64 * 1024;
+            std::size_t time_bucket_ms = 60 * 1000;
+        };
+
+        ChatLogWriter(CollectionPath path, const Options& options)
+            : _collection_path{ path }
+            , _options{ options }
+        { }
+
+        explicit ChatLogWriter(CollectionPath path)
+            : ChatLogWriter{ path, Options{} }
+        { }
+
+        // returns false if the message is dropped. the creation time is stamped unless it is set.
+        bool append(collection::ChatMessage&&);
+
+        // seals the open batch and returns the number of issued inserts.
+        std::size_t flush();
+
+        std::size_t num_of_pending_messages() const;
+
+        std::size_t num_of_in_flight_batches() const;
+
+    private:
+        using batch_type = collection::ChatMessageBatch;
+
+        static std::string new_writer_id();
+
+        void seal_open_batch();
+
+        std::size_t issue_batches();
+
+        io::DetachedTask insert(batch_type);
+
+        void complete_insert(batch_type&&, bool is_succeeded);
+
+        const CollectionPath _collection_path;
+        const Options _options;
+        const std::string writer_id = new_writer_id();
+
+        mutable std::mutex lock;
+        batch_type open_batch;
+        std::deque<batch_type> sealed_batches;
+        std::size_t pending_messages = 0;   // in the open and sealed batches.
+        std::size_t in_flight_batches = 0;
+        std::size_t next_batch_sequence = 0;
+    };
+}
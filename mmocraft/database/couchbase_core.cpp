@@ -8,10 +8,9 @@
 
 namespace database
 {
-    couchbase::cluster CouchbaseCore::_global_cluster;
-    std::map<database::CollectionPath, couchbase::collection> CouchbaseCore::collection_mapping;
+    std::unique_ptr<database::DatabaseBackend> CouchbaseCore::_backend;
 
-    couchbase::cluster_options CouchbaseCore::get_cluster_option(const std::string& username, const std::string& password)
+    couchbase::cluster_options CouchbaseBackend::get_cluster_option(const std::string& username, const std::string& password)
     {
         auto options = couchbase::cluster_options(username, password);
         options.timeouts()
@@ -21,37 +20,83 @@ namespace database
         return options;
     }
 
-    bool CouchbaseCore::connect_server_with_login(const config::Configuration_Database& conf)
+    bool CouchbaseBackend::connect(const config::Configuration_Database& conf)
     {
         CONSOLE_LOG(info) << "Connecting couchbase server...";
         auto [err, cluster] = couchbase::cluster::connect(conf.server_address(), get_cluster_option(conf.userid(), conf.password())).get();
         CONSOLE_LOG_IF(fatal, err) << "Fail to connect to the cluster";
 
-        _global_cluster = std::move(cluster);
-        
+        _cluster = std::move(cluster);
+
         connect_collections();
 
         CONSOLE_LOG(info) << "Done";
         return true;
     }
 
-    void CouchbaseCore::connect_collections()
+    void CouchbaseBackend::connect_collections()
     {
         connect_collection(database::standard_bucket_name, CollectionPath::player_login);
         connect_collection(database::standard_bucket_name, CollectionPath::player_gamedata);
+        connect_collection(database::standard_bucket_name, CollectionPath::chat_message_common);
+        connect_collection(database::standard_bucket_name, CollectionPath::chat_message_private);
+        connect_collection(database::standard_bucket_name, CollectionPath::chat_message_permanent);
         connect_collection(database::cached_bucket_name, CollectionPath::player_login_session);
     }
 
-    void CouchbaseCore::connect_collection(const char* bucket_name, database::CollectionPath path)
+    void CouchbaseBackend::connect_collection(const char* bucket_name, database::CollectionPath path)
     {
-        collection_mapping.emplace(path, _global_cluster
+        collection_mapping.emplace(path, _cluster
             .bucket(bucket_name)
             .default_scope()
             .collection(to_string(path)));
     }
 
-    couchbase::cluster& CouchbaseCore::get_cluster()
+    void CouchbaseBackend::get(database::CollectionPath path, std::string id, handler_type handler)
+    {
+        get_collection(path).get(std::move(id), {}, [handler = std::move(handler)](auto err, auto res) {
+            handler(std::move(err), std::move(res));
+        });
+    }
+
+    void CouchbaseBackend::upsert(database::CollectionPath path, std::string id, couchbase::codec::encoded_value body, handler_type handler)
     {
-        return _global_cluster;
+        get_collection(path).upsert(std::move(id), std::move(body), {}, [handler = std::move(handler)](auto err, auto&&) {
+            handler(std::move(err), {});
+        });
+    }
+
+    void CouchbaseBackend::insert(database::CollectionPath path, std::string id, couchbase::codec::encoded_value body, handler_type handler)
+    {
+        get_collection(path).insert(std::move(id), std::move(body), {}, [handler = std::move(handler)](auto err, auto&&) {
+            handler(std::move(err), {});
+        });
+    }
+
+    void CouchbaseBackend::remove(database::CollectionPath path, std::string id, handler_type handler)
+    {
+        get_collection(path).remove(std::move(id), {}, [handler = std::move(handler)](auto err, auto&&) {
+            handler(std::move(err), {});
+        });
+    }
+
+    bool CouchbaseCore::connect_server_with_login(const config::Configuration_Database& conf)
+    {
+        if (conf.driver_name() == embedded_driver_name) {
+            CONSOLE_LOG(info) << "Opening embedded database at " << conf.server_address() << "...";
+            auto backend = std::make_unique<database::EmbeddedKvBackend>(conf.server_address());
+            CONSOLE_LOG_IF(fatal, not backend->is_open()) << "Fail to open the embedded database";
+
+            _backend = std::move(backend);
+            CONSOLE_LOG(info) << "Done";
+            return true;
+        }
+
+        auto backend = std::make_unique<database::CouchbaseBackend>();
+        if (not backend->connect(conf))
+            return false;
+
+        _backend = std::move(backend);
+        return true;
     }
-}
\ No newline at end of file
+}
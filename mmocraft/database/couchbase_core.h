@@ -1,19 +1,60 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <map>
+#include <string>
 
 #include <couchbase/cluster.hxx>
 #include <tao/json.hpp>
 
 #include "database/couchbase_definitions.h"
+#include "database/database_backend.h"
 #include "io/async_task.h"
+#include "io/executor.h"
+#include "metrics/metrics.h"
 #include "proto/generated/config.pb.h"
 #include "util/common_util.h"
 #include "util/uuid_v4.h"
 
 namespace database
 {
+    // CouchbaseBackend stores documents in the collections of a Couchbase cluster.
+    class CouchbaseBackend : public DatabaseBackend, util::NonCopyable, util::NonMovable
+    {
+    public:
+        bool connect(const config::Configuration_Database& conf);
+
+        static couchbase::cluster_options get_cluster_option(const std::string& username, const std::string& password);
+
+        couchbase::cluster& get_cluster()
+        {
+            return _cluster;
+        }
+
+        couchbase::collection& get_collection(database::CollectionPath path)
+        {
+            return collection_mapping.at(path);
+        }
+
+        void get(database::CollectionPath, std::string id, handler_type) override;
+
+        void upsert(database::CollectionPath, std::string id, couchbase::codec::encoded_value, handler_type) override;
+
+        void insert(database::CollectionPath, std::string id, couchbase::codec::encoded_value, handler_type) override;
+
+        void remove(database::CollectionPath, std::string id, handler_type) override;
+
+    private:
+        void connect_collections();
+
+        void connect_collection(const char* bucket_name, database::CollectionPath path);
+
+        couchbase::cluster _cluster;
+
+        std::map<database::CollectionPath, couchbase::collection> collection_mapping;
+    };
+
     class CouchbaseCore : util::NonCopyable, util::NonMovable
     {
     public:
@@ -21,17 +62,27 @@ namespace database
 
         ~CouchbaseCore() = default;
 
+        // the backend is selected by the driver name. (embedded_driver_name or Couchbase by default)
         static bool connect_server_with_login(const config::Configuration_Database& conf);
 
-        static couchbase::cluster_options get_cluster_option(const std::string& username, const std::string& password);
-
-        static couchbase::cluster& get_cluster();
-
-        static couchbase::collection& get_collection(database::CollectionPath path)
+        static database::DatabaseBackend& backend()
         {
-            return collection_mapping.at(path);
+            return *_backend;
         }
 
+        struct OperationMetrics
+        {
+            explicit OperationMetrics(const std::string& operation)
+                : duration{ metrics::histogram("mmocraft_couchbase_operation_duration_us{operation=\"" + operation + "\"}",
+                                               "Latency of Couchbase data operations.") }
+                , errors{ metrics::counter("mmocraft_couchbase_operation_errors_total{operation=\"" + operation + "\"}",
+                                           "Failed Couchbase data operations. (except document_not_found)") }
+            { }
+
+            metrics::Histogram& duration;
+            metrics::Counter& errors;
+        };
+
         struct DataOperationAwaiter
         {
             constexpr bool await_ready() const noexcept { return false; }
@@ -57,6 +108,31 @@ namespace database
                 return std::string(document_name) + ':' + to_string(collection_path);
             }
 
+            void start_operation()
+            {
+                started_at = std::chrono::steady_clock::now();
+                origin = io::Executor::current();
+            }
+
+            // resume on the executor which started the operation, not on the Couchbase io thread.
+            // (resumed in place if the operation was started outside of executors)
+            void resume(std::coroutine_handle<> coro)
+            {
+                resume_event.coroutine = coro;
+                if (not origin || not origin->post(resume_event))
+                    coro.resume();
+            }
+
+            // invoked by the completion handler before resuming.
+            void finish_operation(OperationMetrics& operation_metrics) const
+            {
+                auto elapsed = std::chrono::steady_clock::now() - started_at;
+                operation_metrics.duration.record(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+
+                if (error && error.ec() != couchbase::errc::key_value::document_not_found)
+                    operation_metrics.errors.add();
+            }
+
             database::CollectionPath collection_path;
             std::string_view document_name;
 
@@ -64,6 +140,11 @@ namespace database
 
             couchbase::error error;
             couchbase::get_result result;
+
+            std::chrono::steady_clock::time_point started_at;
+
+            io::Executor* origin = nullptr;
+            io::ResumeEvent resume_event;
         };
 
         struct GetOperationAwaiter : DataOperationAwaiter
@@ -72,11 +153,14 @@ namespace database
 
             void await_suspend(std::coroutine_handle<> coro)
             {
-                auto& coll = CouchbaseCore::get_collection(collection_path);
-                coll.get(document_id(), {}, [this, coro](auto err, auto res) {
+                static OperationMetrics operation_metrics{ "get" };
+
+                start_operation();
+                CouchbaseCore::backend().get(collection_path, document_id(), [this, coro](auto err, auto res) {
                     error = std::move(err);
                     result = std::move(res);
-                    coro.resume();
+                    finish_operation(operation_metrics);
+                    resume(coro);
                 });
             }
         };
@@ -87,10 +171,13 @@ namespace database
 
             void await_suspend(std::coroutine_handle<> coro)
             {
-                auto& coll = CouchbaseCore::get_collection(collection_path);
-                coll.upsert(document_id(), std::move(document_body), {}, [this, coro](auto err, auto&& res) {
+                static OperationMetrics operation_metrics{ "upsert" };
+
+                start_operation();
+                CouchbaseCore::backend().upsert(collection_path, document_id(), std::move(document_body), [this, coro](auto err, auto&&) {
                     error = std::move(err);
-                    coro.resume();
+                    finish_operation(operation_metrics);
+                    resume(coro);
                 });
             }
         };
@@ -101,10 +188,13 @@ namespace database
 
             void await_suspend(std::coroutine_handle<> coro)
             {
-                auto& coll = CouchbaseCore::get_collection(collection_path);
-                coll.remove(document_id(), {}, [this, coro](auto err, auto&& res) {
+                static OperationMetrics operation_metrics{ "remove" };
+
+                start_operation();
+                CouchbaseCore::backend().remove(collection_path, document_id(), [this, coro](auto err, auto&&) {
                     error = std::move(err);
-                    coro.resume();
+                    finish_operation(operation_metrics);
+                    resume(coro);
                 });
             }
         };
@@ -115,10 +205,13 @@ namespace database
 
             void await_suspend(std::coroutine_handle<> coro)
             {
-                auto& coll = CouchbaseCore::get_collection(collection_path);
-                coll.insert(util::uuid(), std::move(document_body), {}, [this, coro](auto err, auto&& res) {
+                static OperationMetrics operation_metrics{ "insert" };
+
+                start_operation();
+                CouchbaseCore::backend().insert(collection_path, util::uuid(), std::move(document_body), [this, coro](auto err, auto&&) {
                     error = std::move(err);
-                    coro.resume();
+                    finish_operation(operation_metrics);
+                    resume(coro);
                 });
             }
         };
@@ -145,14 +238,9 @@ namespace database
             return { path, "", Transcoder::encode(document) };
         }
 
-    private:
-
-        static void connect_collections();
+        static constexpr const char* embedded_driver_name = "embedded";
 
-        static void connect_collection(const char* bucket_name, database::CollectionPath path);
-
-        static couchbase::cluster _global_cluster;
-
-        static std::map<database::CollectionPath, couchbase::collection> collection_mapping;
+    private:
+        static std::unique_ptr<database::DatabaseBackend> _backend;
     };
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <tao/json.hpp>
 #include <tao/pegtl.hpp>
 #include <couchbase/codec/tao_json_serializer.hxx>
@@ -69,6 +70,8 @@ namespace database
             std::uint64_t spawn_pos = 0;
             std::uint32_t level = 0;
             std::uint32_t exp = 0;
+
+            bool operator==(const PlayerGamedata&) const = default;
         };
 
         struct ChatMessage
@@ -76,6 +79,19 @@ namespace database
             std::string sender_name;
             std::string receiver_name;
             std::string message;
+            std::uint64_t created_at = 0;   // unix time in milliseconds.
+        };
+
+        struct ChatMessageBatch
+        {
+            // chat:<time bucket start>:<writer>:<sequence>. (not stored in the document)
+            // kept across retries, so a retried insert doesn't duplicate the batch.
+            std::string id;
+
+            std::uint64_t sealed_at = 0;
+            std::uint64_t first_created_at = 0;
+            std::uint64_t last_created_at = 0;
+            std::vector<ChatMessage> messages;
         };
     }
 }
@@ -151,7 +167,8 @@ struct tao::json::traits<database::collection::ChatMessage> {
         v = {
             { "sender_name", p.sender_name },
             { "receiver_name", p.receiver_name },
-            { "message", p.message }
+            { "message", p.message },
+            { "created_at", p.created_at }
         };
     }
 
@@ -161,5 +178,35 @@ struct tao::json::traits<database::collection::ChatMessage> {
         v.at("sender_name").to(p.sender_name);
         v.at("receiver_name").to(p.receiver_name);
         v.at("message").to(p.message);
+        if (auto created_at = v.find("created_at"))
+            created_at->to(p.created_at);
+    }
+};
+
+template<>
+struct tao::json::traits<database::collection::ChatMessageBatch> {
+    template<template<typename...> class Traits>
+    static void assign(tao::json::basic_value<Traits>& v, const database::collection::ChatMessageBatch& p)
+    {
+        tao::json::basic_value<Traits> messages = tao::json::empty_array;
+        for (const auto& message : p.messages)
+            messages.emplace_back(message);
+
+        v = {
+            { "sealed_at", p.sealed_at },
+            { "first_created_at", p.first_created_at },
+            { "last_created_at", p.last_created_at },
+            { "messages", std::move(messages) }
+        };
+    }
+
+    template<template<typename...> class Traits>
+    static void to(const tao::json::basic_value<Traits>& v, database::collection::ChatMessageBatch& p)
+    {
+        v.at("sealed_at").to(p.sealed_at);
+        v.at("first_created_at").to(p.first_created_at);
+        v.at("last_created_at").to(p.last_created_at);
+        for (const auto& message : v.at("messages").get_array())
+            p.messages.push_back(message.template as<database::collection::ChatMessage>());
     }
 };
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "pch.h"
+#include "database_backend.h"
+
+namespace
+{
+    couchbase::error to_couchbase_error(database::KvStatus status)
+    {
+        switch (status) {
+        case database::KvStatus::success:
+            return {};
+        case database::KvStatus::not_found:
+            return couchbase::error{ couchbase::errc::key_value::document_not_found };
+        case database::KvStatus::already_exists:
+            return couchbase::error{ couchbase::errc::key_value::document_exists };
+        default:
+            return couchbase::error{ couchbase::errc::common::internal_server_failure, "embedded kv store io error" };
+        }
+    }
+
+    database::EmbeddedKvStore::handler_type to_kv_handler(database::DatabaseBackend::handler_type&& handler)
+    {
+        return [handler = std::move(handler)](database::KvStatus status, database::KvValue&& value) {
+            couchbase::get_result result;
+            if (status == database::KvStatus::success)
+                result = couchbase::get_result{ couchbase::cas{ value.sequence }, { std::move(value.data), value.flags }, {} };
+
+            handler(to_couchbase_error(status), std::move(result));
+        };
+    }
+}
+
+namespace database
+{
+    EmbeddedKvBackend::EmbeddedKvBackend(const std::filesystem::path& dir)
+    {
+        for (int path = 0; path < database::CollectionPath::SIZE; path++)
+            stores[path] = std::make_unique<database::EmbeddedKvStore>(dir / to_string(database::CollectionPath(path)));
+    }
+
+    bool EmbeddedKvBackend::is_open() const
+    {
+        for (const auto& store : stores)
+            if (not store->is_open())
+                return false;
+        return true;
+    }
+
+    void EmbeddedKvBackend::get(database::CollectionPath path, std::string id, handler_type handler)
+    {
+        stores[path]->get(std::move(id), to_kv_handler(std::move(handler)));
+    }
+
+    void EmbeddedKvBackend::upsert(database::CollectionPath path, std::string id, couchbase::codec::encoded_value body, handler_type handler)
+    {
+        stores[path]->upsert(std::move(id), { .data = std::move(body.data), .flags = body.flags }, to_kv_handler(std::move(handler)));
+    }
+
+    void EmbeddedKvBackend::insert(database::CollectionPath path, std::string id, couchbase::codec::encoded_value body, handler_type handler)
+    {
+        stores[path]->insert(std::move(id), { .data = std::move(body.data), .flags = body.flags }, to_kv_handler(std::move(handler)));
+    }
+
+    void EmbeddedKvBackend::remove(database::CollectionPath path, std::string id, handler_type handler)
+    {
+        stores[path]->remove(std::move(id), to_kv_handler(std::move(handler)));
+    }
+}
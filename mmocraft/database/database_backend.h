@@ -0,0 +1,56 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <couchbase/codec/encoded_value.hxx>
+#include <couchbase/error.hxx>
+#include <couchbase/get_result.hxx>
+
+#include "database/couchbase_definitions.h"
+#include "database/embedded_kv_store.h"
+
+namespace database
+{
+    // DatabaseBackend stores the documents of collections for CouchbaseCore.
+    // results are reported in Couchbase types, so callers don't depend on the backend.
+    // (handlers are invoked by an io thread of the backend)
+    class DatabaseBackend
+    {
+    public:
+        using handler_type = std::function<void(couchbase::error, couchbase::get_result)>;
+
+        virtual ~DatabaseBackend() = default;
+
+        virtual void get(database::CollectionPath, std::string id, handler_type) = 0;
+
+        virtual void upsert(database::CollectionPath, std::string id, couchbase::codec::encoded_value, handler_type) = 0;
+
+        virtual void insert(database::CollectionPath, std::string id, couchbase::codec::encoded_value, handler_type) = 0;
+
+        virtual void remove(database::CollectionPath, std::string id, handler_type) = 0;
+    };
+
+    // EmbeddedKvBackend keeps each collection in an in-process store under the directory.
+    // it needs no server, e.g. for a single machine deployment, tests and benchmarks.
+    class EmbeddedKvBackend : public DatabaseBackend
+    {
+    public:
+        explicit EmbeddedKvBackend(const std::filesystem::path& dir);
+
+        bool is_open() const;
+
+        void get(database::CollectionPath, std::string id, handler_type) override;
+
+        void upsert(database::CollectionPath, std::string id, couchbase::codec::encoded_value, handler_type) override;
+
+        void insert(database::CollectionPath, std::string id, couchbase::codec::encoded_value, handler_type) override;
+
+        void remove(database::CollectionPath, std::string id, handler_type) override;
+
+    private:
+        std::unique_ptr<database::EmbeddedKvStore> stores[database::CollectionPath::SIZE];
+    };
+}
@@ -0,0 +1,691 @@
+#include "pch.h"
+#include "embedded_kv_store.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <format>
+
+#include "logging/logger.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    enum class RecordType : std::uint8_t
+    {
+        put,
+        remove,
+        compaction_marker,  // the segment contains all live records of the segments before it.
+    };
+
+    struct RecordHeader
+    {
+        std::uint32_t checksum;     // crc32 of the rest of the record.
+        std::uint32_t key_size;
+        std::uint32_t value_size;
+        std::uint32_t flags;
+        std::uint64_t sequence;
+        RecordType type;
+        std::uint8_t reserved[7];
+    };
+    static_assert(sizeof(RecordHeader) == 32);
+
+    constexpr std::size_t max_record_body_size = 256 * 1024 * 1024;
+
+    constexpr auto crc32_table = [] {
+        std::array<std::uint32_t, 256> table{};
+        for (std::uint32_t i = 0; i < 256; i++) {
+            std::uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+            table[i] = crc;
+        }
+        return table;
+    }();
+
+    std::uint32_t update_crc32(std::uint32_t crc, const void* data, std::size_t size)
+    {
+        auto bytes = static_cast<const std::uint8_t*>(data);
+        crc = ~crc;
+        for (std::size_t i = 0; i < size; i++)
+            crc = crc32_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    std::uint32_t record_checksum(const RecordHeader& header, const void* body, std::size_t body_size)
+    {
+        constexpr auto checksum_size = sizeof(RecordHeader::checksum);
+        auto crc = update_crc32(0, reinterpret_cast<const char*>(&header) + checksum_size, sizeof(header) - checksum_size);
+        return update_crc32(crc, body, body_size);
+    }
+
+    std::uint32_t record_size_of(std::size_t key_size, std::size_t value_size)
+    {
+        return std::uint32_t(sizeof(RecordHeader) + key_size + value_size);
+    }
+
+    RecordHeader compaction_marker()
+    {
+        RecordHeader header{};
+        header.type = RecordType::compaction_marker;
+        header.checksum = record_checksum(header, nullptr, 0);
+        return header;
+    }
+
+    bool starts_with_compaction_marker(const fs::path& path)
+    {
+        std::ifstream reader(path, std::ios::binary);
+        RecordHeader header;
+        return reader.read(reinterpret_cast<char*>(&header), sizeof(header))
+            && header.type == RecordType::compaction_marker
+            && header.checksum == record_checksum(header, nullptr, 0);
+    }
+}
+
+namespace database
+{
+    EmbeddedKvStore::EmbeddedKvStore(const fs::path& dir, const Options& options)
+        : _dir{ dir }
+        , _options{ options }
+    {
+        _is_open = open_segments();
+        if (not _is_open) {
+            CONSOLE_LOG(error) << "Fail to open embedded kv store at " << _dir;
+            return;
+        }
+
+        store_thread = std::thread{ [this] { run_store_thread(); } };
+        compaction_thread = std::thread{ [this] { run_compaction_thread(); } };
+    }
+
+    EmbeddedKvStore::~EmbeddedKvStore()
+    {
+        {
+            std::lock_guard<std::mutex> lock(queue_lock);
+            is_stopped = true;
+        }
+        queue_cv.notify_one();
+        compaction_cv.notify_one();
+
+        if (store_thread.joinable())
+            store_thread.join();
+        if (compaction_thread.joinable())
+            compaction_thread.join();
+    }
+
+    void EmbeddedKvStore::get(std::string key, handler_type handler)
+    {
+        enqueue({ .type = OperationType::get, .key = std::move(key), .handler = std::move(handler) });
+    }
+
+    void EmbeddedKvStore::upsert(std::string key, KvValue value, handler_type handler)
+    {
+        enqueue({ .type = OperationType::upsert, .key = std::move(key), .value = std::move(value), .handler = std::move(handler) });
+    }
+
+    void EmbeddedKvStore::insert(std::string key, KvValue value, handler_type handler)
+    {
+        enqueue({ .type = OperationType::insert, .key = std::move(key), .value = std::move(value), .handler = std::move(handler) });
+    }
+
+    void EmbeddedKvStore::remove(std::string key, handler_type handler)
+    {
+        enqueue({ .type = OperationType::remove, .key = std::move(key), .handler = std::move(handler) });
+    }
+
+    bool EmbeddedKvStore::compact()
+    {
+        if (not _is_open)
+            return false;
+
+        {
+            // a seal failure is reported here, not to the next batch of the store thread.
+            std::lock_guard<std::mutex> lock(state_lock);
+            if (segments.at(active_segment_id).size && not seal_active_segment())
+                return false;
+        }
+
+        return run_compaction();
+    }
+
+    void EmbeddedKvStore::wait_for_compaction()
+    {
+        std::unique_lock<std::mutex> lock(queue_lock);
+        compaction_done_cv.wait(lock, [this] { return is_stopped || (not is_compaction_requested && not is_compaction_running); });
+    }
+
+    std::size_t EmbeddedKvStore::num_of_keys() const
+    {
+        std::lock_guard<std::mutex> lock(state_lock);
+        return std::size_t(std::count_if(index.begin(), index.end(),
+            [](const auto& entry) { return not entry.second.is_removed; }));
+    }
+
+    std::size_t EmbeddedKvStore::num_of_segments() const
+    {
+        std::lock_guard<std::mutex> lock(state_lock);
+        return segments.size();
+    }
+
+    std::size_t EmbeddedKvStore::stale_bytes() const
+    {
+        std::lock_guard<std::mutex> lock(state_lock);
+        std::size_t stale_bytes = 0;
+        for (const auto& [segment_id, segment] : segments)
+            stale_bytes += segment.size - segment.live_bytes;
+        return stale_bytes;
+    }
+
+    void EmbeddedKvStore::enqueue(Operation&& operation)
+    {
+        if (not _is_open) {
+            operation.handler(KvStatus::io_error, {});
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queue_lock);
+            pending_operations.push_back(std::move(operation));
+        }
+        queue_cv.notify_one();
+    }
+
+    void EmbeddedKvStore::run_store_thread()
+    {
+        std::vector<Operation> batch;
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(queue_lock);
+                queue_cv.wait(lock, [this] { return is_stopped || not pending_operations.empty(); });
+                if (pending_operations.empty())
+                    return;
+                batch.swap(pending_operations);
+            }
+
+            bool compaction_needed = false;
+            {
+                std::lock_guard<std::mutex> lock(state_lock);
+                for (auto& operation : batch)
+                    process(operation);
+
+                // group commit: writes of the batch are completed after a single flush and sync.
+                bool has_writes = std::any_of(batch.begin(), batch.end(),
+                    [](const auto& operation) { return operation.type != OperationType::get; });
+
+                if (has_writes && (not active_writer.flush() || not active_sync.sync() || is_sync_failed)) {
+                    CONSOLE_LOG(error) << "Fail to sync segment " << segment_path(active_segment_id);
+                    for (auto& operation : batch)
+                        if (operation.type != OperationType::get && operation.status == KvStatus::success)
+                            operation.status = KvStatus::io_error;
+                }
+                is_sync_failed = false;
+
+                compaction_needed = should_compact();
+            }
+
+            // requested before the completion, so that waiters see it.
+            if (compaction_needed) {
+                {
+                    std::lock_guard<std::mutex> lock(queue_lock);
+                    is_compaction_requested = true;
+                }
+                compaction_cv.notify_one();
+            }
+
+            for (auto& operation : batch)
+                operation.handler(operation.status, std::move(operation.value));
+            batch.clear();
+        }
+    }
+
+    void EmbeddedKvStore::run_compaction_thread()
+    {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(queue_lock);
+                compaction_cv.wait(lock, [this] { return is_stopped || is_compaction_requested; });
+                if (is_stopped) {
+                    compaction_done_cv.notify_all();
+                    return;
+                }
+                is_compaction_requested = false;
+                is_compaction_running = true;
+            }
+
+            bool is_compacted = run_compaction();
+            if (not is_compacted)
+                CONSOLE_LOG(error) << "Fail to compact embedded kv store at " << _dir;
+
+            // segments sealed during the compaction may be stale enough to compact again.
+            bool compaction_needed = false;
+            if (is_compacted) {
+                std::lock_guard<std::mutex> lock(state_lock);
+                compaction_needed = should_compact();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(queue_lock);
+                is_compaction_running = false;
+                is_compaction_requested |= compaction_needed;
+            }
+            compaction_done_cv.notify_all();
+        }
+    }
+
+    void EmbeddedKvStore::process(Operation& operation)
+    {
+        auto it = index.find(operation.key);
+        bool is_exist = it != index.end() && not it->second.is_removed;
+
+        if (operation.type == OperationType::get) {
+            if (not is_exist) {
+                operation.status = KvStatus::not_found;
+                return;
+            }
+
+            auto& location = it->second;
+            if (location.segment_id == active_segment_id)
+                active_writer.flush();
+
+            if (not read_record(segments.at(location.segment_id).reader, location, operation.value))
+                operation.status = KvStatus::io_error;
+            return;
+        }
+
+        if (operation.type == OperationType::insert && is_exist) {
+            operation.status = KvStatus::already_exists;
+            return;
+        }
+        if (operation.type == OperationType::remove && not is_exist) {
+            operation.status = KvStatus::not_found;
+            return;
+        }
+
+        Location location;
+        if (not append_record(operation, last_sequence + 1, location)) {
+            CONSOLE_LOG(error) << "Fail to append record to " << segment_path(active_segment_id);
+            operation.status = KvStatus::io_error;
+            return;
+        }
+
+        operation.value.sequence = ++last_sequence;
+        index_record(operation.key, location);
+
+        if (segments.at(active_segment_id).size >= _options.max_segment_size && not seal_active_segment())
+            is_sync_failed = true;
+    }
+
+    void EmbeddedKvStore::index_record(const std::string& key, const Location& location)
+    {
+        auto [it, is_inserted] = index.try_emplace(key, location);
+        if (not is_inserted) {
+            // older record. (e.g. recovered from a segment which wasn't deleted after compaction)
+            if (it->second.sequence > location.sequence)
+                return;
+
+            segments.at(it->second.segment_id).live_bytes -= it->second.record_size;
+            it->second = location;
+        }
+        segments.at(location.segment_id).live_bytes += location.record_size;
+    }
+
+    bool EmbeddedKvStore::read_record(std::ifstream& reader, const Location& location, KvValue& value)
+    {
+        RecordHeader header;
+        reader.clear();
+        reader.seekg(std::streamoff(location.offset));
+        if (not reader.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            return false;
+
+        if (record_size_of(header.key_size, header.value_size) != location.record_size)
+            return false;
+
+        std::vector<std::byte> body(header.key_size + header.value_size);
+        if (not reader.read(reinterpret_cast<char*>(body.data()), std::streamsize(body.size())))
+            return false;
+
+        if (record_checksum(header, body.data(), body.size()) != header.checksum)
+            return false;
+
+        value.data.assign(body.begin() + header.key_size, body.end());
+        value.flags = header.flags;
+        value.sequence = header.sequence;
+        return true;
+    }
+
+    bool EmbeddedKvStore::append_record(Operation& operation, std::uint64_t sequence, Location& location)
+    {
+        auto& segment = segments.at(active_segment_id);
+        bool is_removed = operation.type == OperationType::remove;
+
+        RecordHeader header{};
+        header.key_size = std::uint32_t(operation.key.size());
+        header.value_size = is_removed ? 0 : std::uint32_t(operation.value.data.size());
+        header.flags = operation.value.flags;
+        header.sequence = sequence;
+        header.type = is_removed ? RecordType::remove : RecordType::put;
+
+        auto crc = record_checksum(header, operation.key.data(), operation.key.size());
+        header.checksum = update_crc32(crc, operation.value.data.data(), header.value_size);
+
+        active_writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        active_writer.write(operation.key.data(), std::streamsize(operation.key.size()));
+        active_writer.write(reinterpret_cast<const char*>(operation.value.data.data()), std::streamsize(header.value_size));
+        if (not active_writer)
+            return false;
+
+        location = {
+            .segment_id = active_segment_id,
+            .record_size = record_size_of(header.key_size, header.value_size),
+            .offset = segment.size,
+            .sequence = sequence,
+            .is_removed = is_removed
+        };
+        segment.size += location.record_size;
+        return true;
+    }
+
+    bool EmbeddedKvStore::open_segments()
+    {
+        std::error_code error;
+        fs::create_directories(_dir, error);
+        if (error)
+            return false;
+
+        std::vector<std::uint32_t> segment_ids;
+        for (const auto& entry : fs::directory_iterator(_dir, error)) {
+            auto path = entry.path();
+            if (path.extension() == ".compact") {
+                // incomplete compaction output.
+                fs::remove(path, error);
+                continue;
+            }
+
+            std::uint32_t segment_id = 0;
+            auto stem = path.stem().string();
+            auto [ptr, ec] = std::from_chars(stem.data(), stem.data() + stem.size(), segment_id);
+            if (path.extension() == ".log" && ec == std::errc{} && ptr == stem.data() + stem.size())
+                segment_ids.push_back(segment_id);
+        }
+        if (error)
+            return false;
+
+        std::sort(segment_ids.begin(), segment_ids.end());
+        if (not drop_compacted_segments(segment_ids))
+            return false;
+
+        for (auto segment_id : segment_ids) {
+            if (not recover_segment(segment_id, segment_id == segment_ids.back()))
+                return false;
+        }
+
+        // keep appending to the last segment.
+        return open_active_segment(segment_ids.empty() ? 1 : segment_ids.back());
+    }
+
+    // segments before the last compaction output are left behind by a crash before they were deleted.
+    bool EmbeddedKvStore::drop_compacted_segments(std::vector<std::uint32_t>& segment_ids)
+    {
+        auto compacted = std::find_if(segment_ids.rbegin(), segment_ids.rend(),
+            [this](auto segment_id) { return starts_with_compaction_marker(segment_path(segment_id)); });
+        if (compacted == segment_ids.rend())
+            return true;
+
+        auto first = std::prev(compacted.base());
+        for (auto it = segment_ids.begin(); it != first; ++it) {
+            std::error_code error;
+            fs::remove(segment_path(*it), error);
+            if (error)
+                return false;
+        }
+
+        segment_ids.erase(segment_ids.begin(), first);
+        return true;
+    }
+
+    bool EmbeddedKvStore::recover_segment(std::uint32_t segment_id, bool is_last)
+    {
+        auto path = segment_path(segment_id);
+
+        std::error_code error;
+        auto file_size = fs::file_size(path, error);
+        if (error)
+            return false;
+
+        auto& segment = segments[segment_id];
+        segment.reader.open(path, std::ios::binary);
+        if (not segment.reader)
+            return false;
+
+        std::size_t offset = 0;
+        RecordHeader header;
+        std::vector<char> body;
+
+        while (segment.reader.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            std::size_t body_size = std::size_t(header.key_size) + header.value_size;
+            if (body_size > max_record_body_size)
+                break;
+
+            body.resize(body_size);
+            if (not segment.reader.read(body.data(), std::streamsize(body_size)))
+                break;
+            if (record_checksum(header, body.data(), body_size) != header.checksum)
+                break;
+
+            if (header.type == RecordType::compaction_marker) {
+                segment.live_bytes += sizeof(header);   // never stale.
+                offset += sizeof(header);
+                continue;
+            }
+
+            Location location{
+                .segment_id = segment_id,
+                .record_size = record_size_of(header.key_size, header.value_size),
+                .offset = offset,
+                .sequence = header.sequence,
+                .is_removed = header.type == RecordType::remove
+            };
+            index_record(std::string(body.data(), header.key_size), location);
+
+            last_sequence = std::max(last_sequence, header.sequence);
+            offset += location.record_size;
+        }
+
+        segment.size = file_size;
+        if (offset != file_size) {
+            if (not is_last) {
+                CONSOLE_LOG(error) << "Segment " << path << " is corrupted at " << offset;
+                return true;
+            }
+
+            // a torn write by a crash.
+            CONSOLE_LOG(warn) << "Truncate the incomplete record of " << path << " at " << offset;
+            segment.reader.close();
+            fs::resize_file(path, offset, error);
+            if (error)
+                return false;
+
+            segment.size = offset;
+            segment.reader.open(path, std::ios::binary);
+        }
+
+        return bool(segment.reader.is_open());
+    }
+
+    bool EmbeddedKvStore::open_active_segment(std::uint32_t segment_id)
+    {
+        auto path = segment_path(segment_id);
+
+        active_writer.open(path, std::ios::binary | std::ios::app);
+        if (not active_writer || not active_sync.open(path))
+            return false;
+
+        auto& segment = segments[segment_id];
+        if (not segment.reader.is_open())
+            segment.reader.open(path, std::ios::binary);
+
+        active_segment_id = segment_id;
+        return segment.reader.is_open();
+    }
+
+    bool EmbeddedKvStore::seal_active_segment()
+    {
+        // writes of the current batch are completed after the sync of the active segment.
+        bool is_synced = active_writer.flush() && active_sync.sync();
+        if (not is_synced)
+            CONSOLE_LOG(error) << "Fail to sync segment " << segment_path(active_segment_id);
+
+        active_writer.close();
+        active_sync.close();
+        if (not open_active_segment(active_segment_id + 1))
+            CONSOLE_LOG(error) << "Fail to open segment " << segment_path(active_segment_id + 1);
+
+        return is_synced;
+    }
+
+    bool EmbeddedKvStore::should_compact() const
+    {
+        // the active segment is not compacted.
+        std::size_t total_bytes = 0, stale_bytes = 0;
+        for (const auto& [segment_id, segment] : segments) {
+            if (segment_id == active_segment_id)
+                continue;
+            total_bytes += segment.size;
+            stale_bytes += segment.size - segment.live_bytes;
+        }
+
+        return stale_bytes >= _options.compaction_min_stale_bytes
+            && stale_bytes >= std::size_t(double(total_bytes) * _options.compaction_stale_ratio);
+    }
+
+    bool EmbeddedKvStore::run_compaction()
+    {
+        std::lock_guard<std::mutex> compaction_guard(compaction_lock);
+
+        struct CompactedRecord
+        {
+            std::string key;
+            Location from;
+            Location to;
+        };
+
+        std::vector<std::uint32_t> input_ids;
+        std::vector<CompactedRecord> records;
+        {
+            std::lock_guard<std::mutex> lock(state_lock);
+            for (const auto& [segment_id, segment] : segments)
+                if (segment_id != active_segment_id)
+                    input_ids.push_back(segment_id);
+
+            if (input_ids.empty())
+                return true;
+
+            // removed keys are not rewritten, but dropped from the index after the compaction.
+            // the marker of the output keeps older values from being revived by a segment left behind.
+            for (const auto& [key, location] : index)
+                if (location.segment_id != active_segment_id)
+                    records.push_back({ .key = key, .from = location });
+        }
+
+        // the output replaces the newest input segment, so it is replayed before the active segment.
+        auto output_id = input_ids.back();
+        auto output_path = segment_path(output_id);
+        auto temp_path = fs::path(output_path).concat(".compact");
+
+        std::sort(records.begin(), records.end(), [](const auto& a, const auto& b) {
+            return a.from.segment_id != b.from.segment_id ? a.from.segment_id < b.from.segment_id : a.from.offset < b.from.offset;
+        });
+
+        std::size_t output_size = 0;
+        {
+            std::ofstream output(temp_path, std::ios::binary | std::ios::trunc);
+            std::map<std::uint32_t, std::ifstream> inputs;
+            for (auto segment_id : input_ids)
+                inputs[segment_id].open(segment_path(segment_id), std::ios::binary);
+
+            auto marker = compaction_marker();
+            output.write(reinterpret_cast<const char*>(&marker), sizeof(marker));
+            output_size += sizeof(marker);
+
+            std::vector<char> buffer;
+            for (auto& record : records) {
+                if (record.from.is_removed)
+                    continue;
+
+                auto& input = inputs[record.from.segment_id];
+                buffer.resize(record.from.record_size);
+                input.seekg(std::streamoff(record.from.offset));
+                if (not input.read(buffer.data(), std::streamsize(buffer.size()))
+                    || not output.write(buffer.data(), std::streamsize(buffer.size()))) {
+                    output.close();
+                    std::error_code error;
+                    fs::remove(temp_path, error);
+                    return false;
+                }
+
+                record.to = record.from;
+                record.to.segment_id = output_id;
+                record.to.offset = output_size;
+                output_size += record.from.record_size;
+            }
+
+            // the output must be on the disk before it replaces the inputs.
+            win::FileSync output_sync;
+            if (not output.flush() || not output_sync.open(temp_path) || not output_sync.sync()) {
+                output.close();
+                std::error_code error;
+                fs::remove(temp_path, error);
+                return false;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(state_lock);
+
+        for (auto segment_id : input_ids)
+            segments.at(segment_id).reader.close();
+
+        std::error_code error;
+        fs::rename(temp_path, output_path, error);
+        if (error) {
+            for (auto segment_id : input_ids)
+                segments.at(segment_id).reader.open(segment_path(segment_id), std::ios::binary);
+            return false;
+        }
+
+        for (auto segment_id : input_ids) {
+            if (segment_id != output_id)
+                fs::remove(segment_path(segment_id), error);
+            segments.erase(segment_id);
+        }
+
+        auto& output_segment = segments[output_id];
+        output_segment.size = output_size;
+        output_segment.live_bytes = sizeof(RecordHeader);  // the marker is never stale.
+        output_segment.reader.open(output_path, std::ios::binary);
+
+        // records which were overwritten during the compaction are stale in the output.
+        for (const auto& record : records) {
+            auto it = index.find(record.key);
+            if (it == index.end() || it->second.segment_id != record.from.segment_id || it->second.offset != record.from.offset)
+                continue;
+
+            if (record.from.is_removed) {
+                index.erase(it);
+            }
+            else {
+                it->second = record.to;
+                output_segment.live_bytes += record.to.record_size;
+            }
+        }
+
+        return output_segment.reader.is_open();
+    }
+
+    fs::path EmbeddedKvStore::segment_path(std::uint32_t segment_id) const
+    {
+        return _dir / std::format("{:08}.log", segment_id);
+    }
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "util/noncopyable.h"
+#include "win/file_sync.h"
+
+namespace database
+{
+    enum class KvStatus
+    {
+        success,
+        not_found,
+        already_exists,
+        io_error,
+    };
+
+    struct KvValue
+    {
+        std::vector<std::byte> data;
+        std::uint32_t flags = 0;    // opaque to the store. (e.g. codec flags)
+        std::uint64_t sequence = 0; // increases on every write. (like CAS)
+    };
+
+    // EmbeddedKvStore is a log-structured key-value store. (like Bitcask)
+    //
+    // - records are appended to segment files, which are also the write-ahead log.
+    //   a store thread processes operations in order and syncs each batch of writes to the disk at once before completion. (group commit)
+    // - the index of all keys (key -> record location) is kept in memory and rebuilt from the segments on open.
+    //   a torn record at the end of the last segment is truncated.
+    // - a compaction thread rewrites the live records of immutable segments into one segment
+    //   when stale records take a large part of the files.
+    //   the output starts with a marker, and segments before it are deleted on open. so removed keys are dropped.
+    // - handlers are invoked by the store thread.
+    class EmbeddedKvStore : util::NonCopyable, util::NonMovable
+    {
+    public:
+        struct Options
+        {
+            std::size_t max_segment_size = 64 * 1024 * 1024;
+            std::size_t compaction_min_stale_bytes = 16 * 1024 * 1024;
+            double compaction_stale_ratio = 0.5;
+        };
+
+        using handler_type = std::function<void(KvStatus, KvValue&&)>;
+
+        EmbeddedKvStore(const std::filesystem::path& dir, const Options& options);
+
+        explicit EmbeddedKvStore(const std::filesystem::path& dir)
+            : EmbeddedKvStore{ dir, Options{} }
+        { }
+
+        // completes queued operations before closing.
+        ~EmbeddedKvStore();
+
+        bool is_open() const
+        {
+            return _is_open;
+        }
+
+        void get(std::string key, handler_type);
+
+        void upsert(std::string key, KvValue value, handler_type);
+
+        // fails with already_exists if the key exists.
+        void insert(std::string key, KvValue value, handler_type);
+
+        // fails with not_found if the key doesn't exist.
+        void remove(std::string key, handler_type);
+
+        // seals the active segment and compacts all segments synchronously.
+        bool compact();
+
+        // waits until the background compaction requested so far is finished.
+        void wait_for_compaction();
+
+        /* Statistics */
+
+        std::size_t num_of_keys() const;
+
+        std::size_t num_of_segments() const;
+
+        std::size_t stale_bytes() const;
+
+    private:
+        enum class OperationType : std::uint8_t
+        {
+            get,
+            upsert,
+            insert,
+            remove,
+        };
+
+        struct Operation
+        {
+            OperationType type;
+            std::string key;
+            KvValue value;
+            handler_type handler;
+
+            KvStatus status = KvStatus::success;
+        };
+
+        struct Location
+        {
+            std::uint32_t segment_id = 0;
+            std::uint32_t record_size = 0;
+            std::uint64_t offset = 0;
+            std::uint64_t sequence = 0;
+            bool is_removed = false;    // removed keys are kept until their segment is compacted.
+        };
+
+        struct Segment
+        {
+            std::ifstream reader;
+            std::size_t size = 0;
+            std::size_t live_bytes = 0;     // size of records referenced by the index.
+        };
+
+        void enqueue(Operation&&);
+
+        void run_store_thread();
+
+        void run_compaction_thread();
+
+        bool open_segments();
+
+        bool recover_segment(std::uint32_t segment_id, bool is_last);
+
+        void index_record(const std::string& key, const Location&);
+
+        bool open_active_segment(std::uint32_t segment_id);
+
+        // returns false if the writes in the active segment failed to sync.
+        bool seal_active_segment();
+
+        bool drop_compacted_segments(std::vector<std::uint32_t>& segment_ids);
+
+        bool read_record(std::ifstream&, const Location&, KvValue&);
+
+        bool append_record(Operation&, std::uint64_t sequence, Location&);
+
+        void process(Operation&);
+
+        bool should_compact() const;
+
+        bool run_compaction();
+
+        std::filesystem::path segment_path(std::uint32_t segment_id) const;
+
+        const std::filesystem::path _dir;
+        const Options _options;
+        bool _is_open = false;
+
+        // protects below states. held by the store thread while processing a batch.
+        mutable std::mutex state_lock;
+
+        std::unordered_map<std::string, Location> index;
+        std::map<std::uint32_t, Segment> segments;
+        std::uint32_t active_segment_id = 0;
+        std::ofstream active_writer;
+        win::FileSync active_sync;
+        bool is_sync_failed = false;    // a sealed segment of the current batch failed to sync.
+        std::uint64_t last_sequence = 0;
+
+        // only one compaction runs at a time.
+        std::mutex compaction_lock;
+
+        std::mutex queue_lock;
+        std::condition_variable queue_cv;
+        std::condition_variable compaction_cv;
+        std::condition_variable compaction_done_cv;
+        std::vector<Operation> pending_operations;
+        bool is_compaction_requested = false;
+        bool is_compaction_running = false;
+        bool is_stopped = false;
+
+        std::thread store_thread;
+        std::thread compaction_thread;
+    };
+}
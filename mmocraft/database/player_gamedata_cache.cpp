@@ -0,0 +1,178 @@
+#include "pch.h"
+#include "player_gamedata_cache.h"
+
+#include <vector>
+
+#include "database/couchbase_core.h"
+#include "logging/logger.h"
+#include "metrics/metrics.h"
+
+namespace
+{
+    struct CacheMetrics
+    {
+        metrics::Counter& saves = metrics::counter("mmocraft_gamedata_saves_total",
+            "Player gamedata saves issued by the write-behind cache.");
+        metrics::Counter& coalesced = metrics::counter("mmocraft_gamedata_coalesced_total",
+            "Player gamedata updates merged into a pending save.");
+        metrics::Counter& errors = metrics::counter("mmocraft_gamedata_save_errors_total",
+            "Failed player gamedata saves. (retried)");
+        metrics::Gauge& pending = metrics::gauge("mmocraft_gamedata_pending_saves",
+            "Player gamedata waiting to be saved.");
+    };
+
+    CacheMetrics& cache_metrics()
+    {
+        static CacheMetrics metrics;
+        return metrics;
+    }
+}
+
+namespace database
+{
+    void PlayerGamedataCache::update(const std::string& player_uuid, const collection::PlayerGamedata& gamedata)
+    {
+        mark_dirty(player_uuid, gamedata, false);
+    }
+
+    void PlayerGamedataCache::release(const std::string& player_uuid, const collection::PlayerGamedata& gamedata)
+    {
+        mark_dirty(player_uuid, gamedata, true);
+    }
+
+    std::optional<collection::PlayerGamedata> PlayerGamedataCache::find(const std::string& player_uuid) const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (auto it = entries.find(player_uuid); it != entries.end())
+            return it->second.latest;
+        return std::nullopt;
+    }
+
+    std::size_t PlayerGamedataCache::num_of_pending_saves() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return dirty_players.size();
+    }
+
+    std::size_t PlayerGamedataCache::num_of_in_flight_saves() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return in_flight_saves;
+    }
+
+    void PlayerGamedataCache::mark_dirty(const std::string& player_uuid, const collection::PlayerGamedata& gamedata, bool is_released)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        auto [it, is_new] = entries.try_emplace(player_uuid);
+        auto& entry = it->second;
+        entry.is_released = is_released;
+
+        if (entry.is_dirty) {
+            entry.latest = gamedata;
+            cache_metrics().coalesced.add();
+            return;
+        }
+
+        if (not is_new && entry.latest == gamedata) {
+            if (is_released && not entry.is_in_flight)
+                entries.erase(it);
+            return;
+        }
+
+        entry.latest = gamedata;
+        entry.is_dirty = true;
+        dirty_players.push_back(player_uuid);
+        cache_metrics().pending.set(std::int64_t(dirty_players.size()));
+    }
+
+    std::size_t PlayerGamedataCache::flush()
+    {
+        std::vector<std::pair<std::string, collection::PlayerGamedata>> batch;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            take_dirty_players(_options.max_batch_size, batch);
+        }
+
+        issue_saves(batch);
+        return batch.size();
+    }
+
+    void PlayerGamedataCache::take_dirty_players(std::size_t max_saves, std::vector<std::pair<std::string, collection::PlayerGamedata>>& batch)
+    {
+        // players whose previous save is in flight wait for the next flush, so saves are not reordered.
+        std::deque<std::string> deferred_players;
+        while (not dirty_players.empty()
+            && batch.size() < max_saves
+            && in_flight_saves < _options.max_in_flight_saves) {
+            auto player_uuid = std::move(dirty_players.front());
+            dirty_players.pop_front();
+
+            auto& entry = entries.at(player_uuid);
+            if (entry.is_in_flight) {
+                deferred_players.push_back(std::move(player_uuid));
+                continue;
+            }
+
+            entry.is_dirty = false;
+            entry.is_in_flight = true;
+            in_flight_saves++;
+            batch.emplace_back(std::move(player_uuid), entry.latest);
+        }
+
+        dirty_players.insert(dirty_players.begin(), deferred_players.begin(), deferred_players.end());
+        cache_metrics().pending.set(std::int64_t(dirty_players.size()));
+    }
+
+    void PlayerGamedataCache::issue_saves(std::vector<std::pair<std::string, collection::PlayerGamedata>>& batch)
+    {
+        for (auto& [player_uuid, gamedata] : batch)
+            save(std::move(player_uuid), gamedata);
+
+        cache_metrics().saves.add(batch.size());
+    }
+
+    io::DetachedTask PlayerGamedataCache::save(std::string player_uuid, collection::PlayerGamedata gamedata)
+    {
+        auto [err, result] = co_await CouchbaseCore::upsert_document(CollectionPath::player_gamedata, player_uuid, gamedata);
+        CONSOLE_LOG_IF(error, err) << "Fail to save player gamedata: " << err.ec();
+
+        complete_save(player_uuid, not err);
+    }
+
+    void PlayerGamedataCache::complete_save(const std::string& player_uuid, bool is_succeeded)
+    {
+        std::vector<std::pair<std::string, collection::PlayerGamedata>> next_save;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            in_flight_saves--;
+
+            auto it = entries.find(player_uuid);
+            auto& entry = it->second;
+            entry.is_in_flight = false;
+
+            if (not is_succeeded) {
+                cache_metrics().errors.add();
+                if (not entry.is_dirty) {
+                    entry.is_dirty = true;
+                    dirty_players.push_back(player_uuid);
+                }
+            }
+            else if (entry.is_released && not entry.is_dirty)
+                entries.erase(it);
+
+            // the freed slot takes the next pending save, so the throughput isn't bound by the flush period.
+            // a failed save is retried by a later flush, not to retry a failing database back to back.
+            if (is_succeeded)
+                take_dirty_players(1, next_save);
+        }
+
+        issue_saves(next_save);
+    }
+
+    PlayerGamedataCache& player_gamedata_cache()
+    {
+        static PlayerGamedataCache cache;
+        return cache;
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "database/couchbase_definitions.h"
+#include "io/async_task.h"
+#include "util/noncopyable.h"
+
+namespace database
+{
+    // PlayerGamedataCache saves player gamedata behind the game. (write-behind)
+    //
+    // - saves of the same player are coalesced until flushed, and at most one save per player is in flight.
+    // - flush() issues pending saves as a batch, bounded by the number of in-flight saves.
+    //   (so mass disconnects don't turn into a write spike)
+    // - a completed save issues the next pending one, so the backlog drains without waiting for flushes.
+    // - a failed save is retried by a later flush unless a newer one is pending.
+    //
+    // thread-safe.
+    class PlayerGamedataCache : util::NonCopyable, util::NonMovable
+    {
+    public:
+        struct Options
+        {
+            std::size_t max_in_flight_saves = 64;
+            std::size_t max_batch_size = 256;
+        };
+
+        explicit PlayerGamedataCache(const Options& options)
+            : _options{ options }
+        { }
+
+        PlayerGamedataCache()
+            : PlayerGamedataCache{ Options{} }
+        { }
+
+        // saves the gamedata of an online player if it has changed since the last save.
+        void update(const std::string& player_uuid, const collection::PlayerGamedata&);
+
+        // saves the last gamedata of a leaving player. the entry is dropped once saved.
+        void release(const std::string& player_uuid, const collection::PlayerGamedata&);
+
+        // the latest gamedata of the player which is cached. (newer than the database if unsaved)
+        std::optional<collection::PlayerGamedata> find(const std::string& player_uuid) const;
+
+        // returns the number of issued saves.
+        std::size_t flush();
+
+        std::size_t num_of_pending_saves() const;
+
+        std::size_t num_of_in_flight_saves() const;
+
+    private:
+        struct Entry
+        {
+            collection::PlayerGamedata latest;
+            bool is_dirty = false;
+            bool is_in_flight = false;
+            bool is_released = false;
+        };
+
+        void mark_dirty(const std::string& player_uuid, const collection::PlayerGamedata&, bool is_released);
+
+        // must be invoked with the lock.
+        void take_dirty_players(std::size_t max_saves, std::vector<std::pair<std::string, collection::PlayerGamedata>>&);
+
+        void issue_saves(std::vector<std::pair<std::string, collection::PlayerGamedata>>&);
+
+        io::DetachedTask save(std::string player_uuid, collection::PlayerGamedata);
+
+        void complete_save(const std::string& player_uuid, bool is_succeeded);
+
+        const Options _options;
+
+        mutable std::mutex lock;
+        std::unordered_map<std::string, Entry> entries;
+        std::deque<std::string> dirty_players;  // in the order of getting dirty.
+        std::size_t in_flight_saves = 0;
+    };
+
+    PlayerGamedataCache& player_gamedata_cache();
+}
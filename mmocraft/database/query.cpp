@@ -8,12 +8,16 @@
 
 namespace database
 {
-    io::DetachedTask PlayerGamedata::save(const game::Player& player_unsafe)
+    void PlayerGamedata::update(const game::Player& player_unsafe)
     {
-        if (player_unsafe.is_support_gamedata_saving()) {
-            auto [err, result] = co_await ::database::CouchbaseCore::upsert_document(::database::CollectionPath::player_gamedata, player_unsafe.uuid(), player_unsafe.get_gamedata());
-            CONSOLE_LOG_IF(error, err) << "Fail to save player gamedata: " << err.ec();
-        }
+        if (player_unsafe.is_support_gamedata_saving())
+            player_gamedata_cache().update(player_unsafe.uuid(), player_unsafe.get_gamedata());
+    }
+
+    void PlayerGamedata::save(const game::Player& player_unsafe)
+    {
+        if (player_unsafe.is_support_gamedata_saving())
+            player_gamedata_cache().release(player_unsafe.uuid(), player_unsafe.get_gamedata());
     }
 
     io::DetachedTask PlayerLoginSession::load(std::string_view player_name, database::collection::PlayerLoginSession& session)
@@ -4,6 +4,7 @@
 #include "net/connection_environment.h"
 #include "database/sql_statement.h"
 #include "database/couchbase_core.h"
+#include "database/player_gamedata_cache.h"
 
 namespace database
 {
@@ -13,7 +14,11 @@ namespace database
     {
     public:
 
-         static io::DetachedTask save(const game::Player& player_unsafe);
+        // queues the gamedata of an online player to the write-behind cache. (skipped if unchanged)
+        static void update(const game::Player& player_unsafe);
+
+        // queues the last gamedata of a leaving player.
+        static void save(const game::Player& player_unsafe);
 
     };
 
@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "block_physics.h"
+
+namespace
+{
+    bool is_fluid(game::BlockID block_id)
+    {
+        return block_id == game::block_id::water || block_id == game::block_id::still_water
+            || block_id == game::block_id::lava || block_id == game::block_id::still_lava;
+    }
+
+    bool is_lava(game::BlockID block_id)
+    {
+        return block_id == game::block_id::lava || block_id == game::block_id::still_lava;
+    }
+
+    // falling blocks and flowing fluids can replace these blocks.
+    bool is_replaceable(game::BlockID block_id)
+    {
+        return block_id == game::block_id::air || is_fluid(block_id);
+    }
+
+    constexpr int horizontal_directions[4][2] = {
+        { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }
+    };
+}
+
+namespace game
+{
+    void BlockPhysics::reset(int map_width, int map_height, int map_length)
+    {
+        _map_width = map_width;
+        _map_height = map_height;
+        _map_length = map_length;
+
+        active_blocks.clear();
+        is_active.assign(std::size_t(map_width) * map_height * map_length, false);
+    }
+
+    void BlockPhysics::activate(int x, int y, int z)
+    {
+        constexpr int neighbors[7][3] = {
+            { 0, 0, 0 },
+            { 1, 0, 0 }, { -1, 0, 0 },
+            { 0, 1, 0 }, { 0, -1, 0 },
+            { 0, 0, 1 }, { 0, 0, -1 },
+        };
+
+        for (const auto& [dx, dy, dz] : neighbors) {
+            if (not is_in_map(x + dx, y + dy, z + dz))
+                continue;
+
+            auto block_index = block_index_of(x + dx, y + dy, z + dz);
+            if (is_active[block_index])
+                continue;
+
+            is_active[block_index] = true;
+            active_blocks.push_back(std::uint32_t(block_index));
+        }
+    }
+
+    bool BlockPhysics::is_due(const std::byte* blocks, std::uint32_t block_index) const
+    {
+        return BlockID(blocks[block_index]) != block_id::lava || step % lava_spread_delay == 0;
+    }
+
+    void BlockPhysics::compute_changes(const std::byte* blocks, std::uint32_t block_index, std::vector<game::BlockChange>& changes) const
+    {
+        const int x = int(block_index % _map_width);
+        const int z = int(block_index / _map_width % _map_length);
+        const int y = int(block_index / (std::size_t(_map_width) * _map_length));
+
+        auto block_at = [this, blocks](int block_x, int block_y, int block_z) {
+            return BlockID(blocks[block_index_of(block_x, block_y, block_z)]);
+        };
+
+        const auto current = BlockID(blocks[block_index]);
+
+        switch (current) {
+        case block_id::sand:
+        case block_id::gravel:
+            // fall one block per step.
+            if (y > 0 && is_replaceable(block_at(x, y - 1, z))) {
+                changes.push_back({ { x, y - 1, z }, current });
+                changes.push_back({ { x, y, z }, block_id::air });
+            }
+            return;
+        case block_id::water:
+        case block_id::lava:
+        {
+            // fluids flow downward first, and spread horizontally on the ground.
+            if (y > 0) {
+                auto below = block_at(x, y - 1, z);
+                if (below == block_id::air) {
+                    changes.push_back({ { x, y - 1, z }, current });
+                    return;
+                }
+                // water hardens lava.
+                if (current == block_id::water && is_lava(below)) {
+                    changes.push_back({ { x, y - 1, z }, block_id::stone });
+                    return;
+                }
+            }
+
+            for (const auto& [dx, dz] : horizontal_directions) {
+                if (not is_in_map(x + dx, y, z + dz))
+                    continue;
+
+                auto neighbor = block_at(x + dx, y, z + dz);
+                if (neighbor == block_id::air)
+                    changes.push_back({ { x + dx, y, z + dz }, current });
+                else if (current == block_id::water && is_lava(neighbor))
+                    changes.push_back({ { x + dx, y, z + dz }, block_id::stone });
+            }
+            return;
+        }
+        default:
+            return;
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "game/block.h"
+#include "util/math.h"
+
+namespace game
+{
+    struct BlockChange
+    {
+        util::Coordinate3D pos;
+        game::BlockID block_id;
+    };
+
+    // BlockPhysics simulates fluids and falling blocks.
+    // only active blocks (changed blocks and their neighbors) are simulated,
+    // so the cost of a step is proportional to the number of active blocks, not the map volume.
+    class BlockPhysics
+    {
+    public:
+        // lava spreads once every N steps.
+        static constexpr std::size_t lava_spread_delay = 4;
+
+        void reset(int map_width, int map_height, int map_length);
+
+        // activates the block and its neighbors.
+        // changes accepted by simulate() have to be activated again to continue the simulation.
+        void activate(int x, int y, int z);
+
+        bool has_active_blocks() const
+        {
+            return not active_blocks.empty();
+        }
+
+        std::size_t num_of_active_blocks() const
+        {
+            return active_blocks.size();
+        }
+
+        // simulates at most max_updates active blocks. the rest are carried over to the next step.
+        // changes of a block are written to the block map only if emit(changes) accepts them.
+        // returns the number of simulated blocks.
+        template <typename Emitter>
+        std::size_t simulate(std::byte* blocks, std::size_t max_updates, Emitter&& emit)
+        {
+            std::size_t num_of_updates = 0;
+            std::vector<game::BlockChange> changes;
+
+            // blocks re-queued in this step are simulated at the next step.
+            max_updates = std::min(max_updates, active_blocks.size());
+
+            for (; num_of_updates < max_updates; num_of_updates++) {
+                auto block_index = active_blocks.front();
+
+                changes.clear();
+                if (not is_due(blocks, block_index)) {
+                    // wait for the next spread step.
+                    active_blocks.pop_front();
+                    active_blocks.push_back(block_index);
+                    continue;
+                }
+
+                compute_changes(blocks, block_index, changes);
+
+                // the block stays active until its changes are accepted.
+                if (not changes.empty() && not emit(changes))
+                    break;
+
+                active_blocks.pop_front();
+                is_active[block_index] = false;
+
+                for (const auto& change : changes)
+                    blocks[block_index_of(change.pos.x, change.pos.y, change.pos.z)] = std::byte(change.block_id);
+            }
+
+            step++;
+            return num_of_updates;
+        }
+
+    private:
+        std::size_t block_index_of(int x, int y, int z) const
+        {
+            return std::size_t(x) + std::size_t(_map_width) * z + std::size_t(_map_width) * _map_length * y;
+        }
+
+        bool is_in_map(int x, int y, int z) const
+        {
+            return 0 <= x && x < _map_width && 0 <= y && y < _map_height && 0 <= z && z < _map_length;
+        }
+
+        bool is_due(const std::byte* blocks, std::uint32_t block_index) const;
+
+        void compute_changes(const std::byte* blocks, std::uint32_t block_index, std::vector<game::BlockChange>& changes) const;
+
+        int _map_width = 0;
+        int _map_height = 0;
+        int _map_length = 0;
+
+        std::size_t step = 0;
+
+        std::deque<std::uint32_t> active_blocks;
+        std::vector<bool> is_active;
+    };
+}
@@ -0,0 +1,171 @@
+#include "pch.h"
+#include "block_region.h"
+
+namespace game
+{
+    void BlockRegionTable::reset(int map_width, int map_height, int map_length)
+    {
+        _map_width = map_width;
+        _map_height = map_height;
+        _map_length = map_length;
+
+        num_of_regions_x = (map_width + region_block_size - 1) / region_block_size;
+        num_of_regions_z = (map_length + region_block_size - 1) / region_block_size;
+
+        regions.clear();
+        regions.resize(std::size_t(num_of_regions_x) * num_of_regions_z);
+        window_regions.clear();
+    }
+
+    int BlockRegionTable::region_index_of(int block_x, int block_z) const
+    {
+        block_x = std::clamp(block_x, 0, _map_width - 1);
+        block_z = std::clamp(block_z, 0, _map_length - 1);
+
+        return (block_z / region_block_size) * num_of_regions_x + block_x / region_block_size;
+    }
+
+    bool BlockRegionTable::is_in_view(int center_region_index, int region_index) const
+    {
+        return std::abs(center_region_index % num_of_regions_x - region_index % num_of_regions_x) <= region_view_distance
+            && std::abs(center_region_index / num_of_regions_x - region_index / num_of_regions_x) <= region_view_distance;
+    }
+
+    void BlockRegionTable::commit(const game::BlockHistory& block_history)
+    {
+        // records of the previous window were already delivered or marked as dirty.
+        for (auto region_index : window_regions)
+            regions[region_index].window_records.clear();
+        window_regions.clear();
+
+        const auto history_size = block_history.size();
+
+        for (std::size_t index = 0; index < history_size; index++) {
+            auto& record = block_history.get_record(index);
+            int x = _byteswap_ushort(record.x);
+            int y = _byteswap_ushort(record.y);
+            int z = _byteswap_ushort(record.z);
+
+            if (x >= _map_width || y >= _map_height || z >= _map_length)
+                continue;
+
+            auto region_index = region_index_of(x, z);
+            auto& region = regions[region_index];
+
+            // first change of the region at this window.
+            if (region.window_records.empty()) {
+                window_regions.push_back(region_index);
+                region.window_base_version = region.version++;
+            }
+
+            region.window_records.push_back(record);
+
+            auto block_index = std::uint32_t((y * region_block_size + z % region_block_size) * region_block_size + x % region_block_size);
+            region.changes[block_index] = { record, region.version };
+        }
+    }
+
+    void BlockRegionTable::mark_all_synced(RegionSyncState& sync_state) const
+    {
+        sync_state.versions.resize(regions.size());
+        for (std::size_t index = 0; index < regions.size(); index++)
+            sync_state.versions[index] = regions[index].version;
+
+        sync_state.has_dirty_region = false;
+    }
+
+    bool BlockRegionTable::is_window_synced(int center_region_index, const RegionSyncState& sync_state) const
+    {
+        bool is_synced = true;
+
+        for_each_region_in_view(center_region_index, [this, &sync_state, &is_synced](int region_index) {
+            auto& region = regions[region_index];
+            auto synced_version = sync_state.versions[region_index];
+
+            is_synced &= synced_version == region.version
+                || (not region.window_records.empty() && synced_version == region.window_base_version);
+        });
+
+        return is_synced;
+    }
+
+    void BlockRegionTable::collect_window_records(int center_region_index, std::vector<BlockHistoryRecord>& records) const
+    {
+        for_each_region_in_view(center_region_index, [this, &records](int region_index) {
+            auto& window_records = regions[region_index].window_records;
+            records.insert(records.end(), window_records.begin(), window_records.end());
+        });
+    }
+
+    void BlockRegionTable::collect_unsynced_records(int center_region_index, const RegionSyncState& sync_state, std::vector<BlockHistoryRecord>& records) const
+    {
+        for_each_region_in_view(center_region_index, [this, &sync_state, &records](int region_index) {
+            auto& region = regions[region_index];
+            auto synced_version = sync_state.versions[region_index];
+
+            if (synced_version >= region.version)
+                return;
+
+            // the player missed only the current window.
+            if (not region.window_records.empty() && synced_version == region.window_base_version) {
+                records.insert(records.end(), region.window_records.begin(), region.window_records.end());
+                return;
+            }
+
+            // resync the latest state of blocks changed after the last sync.
+            for (const auto& [block_index, change] : region.changes) {
+                if (change.second > synced_version)
+                    records.push_back(change.first);
+            }
+        });
+    }
+
+    void BlockRegionTable::trim_changes(const std::vector<const RegionSyncState*>& sync_states)
+    {
+        for (std::size_t index = 0; index < regions.size(); index++) {
+            auto& region = regions[index];
+            if (region.changes.empty())
+                continue;
+
+            auto min_synced_version = region.version;
+            for (auto sync_state : sync_states) {
+                if (index < sync_state->versions.size())
+                    min_synced_version = std::min(min_synced_version, sync_state->versions[index]);
+            }
+
+            std::erase_if(region.changes, [min_synced_version](const auto& change) {
+                return change.second.second <= min_synced_version;
+            });
+        }
+    }
+
+    std::size_t BlockRegionTable::num_of_changes() const
+    {
+        std::size_t num_of_changes = 0;
+        for (const auto& region : regions)
+            num_of_changes += region.changes.size();
+        return num_of_changes;
+    }
+
+    void BlockRegionTable::mark_view_synced(int center_region_index, RegionSyncState& sync_state) const
+    {
+        for_each_region_in_view(center_region_index, [this, &sync_state](int region_index) {
+            sync_state.versions[region_index] = regions[region_index].version;
+        });
+
+        // full scan is required only for players who already had dirty regions.
+        if (sync_state.has_dirty_region) {
+            sync_state.has_dirty_region = false;
+            for (std::size_t index = 0; index < regions.size(); index++)
+                sync_state.has_dirty_region |= sync_state.versions[index] < regions[index].version;
+            return;
+        }
+
+        for (auto region_index : window_regions) {
+            if (not is_in_view(center_region_index, region_index)) {
+                sync_state.has_dirty_region = true;
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "game/history_buffer.h"
+#include "util/math.h"
+
+namespace game
+{
+    // Width and length of a region in blocks. a region always spans the whole map height.
+    constexpr int region_block_size = 32;
+
+    // Players receive block changes of the regions within this distance (in regions) only.
+    constexpr int region_view_distance = 4;
+
+    using RegionVersion = std::uint32_t;
+
+    // Tracks which block changes a player has received.
+    // a region is dirty for the player while its version is lower than the region version.
+    struct RegionSyncState
+    {
+        std::vector<RegionVersion> versions;
+
+        bool has_dirty_region = false;
+    };
+
+    // BlockRegionTable buckets block changes by map region (x-z plane)
+    // so that each player receives only changes around itself.
+    class BlockRegionTable
+    {
+    public:
+        struct Region
+        {
+            RegionVersion version = 0;
+
+            // version of the region before the current sync window.
+            RegionVersion window_base_version = 0;
+
+            // block changes committed at the current sync window.
+            std::vector<BlockHistoryRecord> window_records;
+
+            // the latest change of each block (key: block index in the region).
+            // it is used to resync players who missed changes while the region was out of view,
+            // and trimmed once all players have synced past them.
+            std::unordered_map<std::uint32_t, std::pair<BlockHistoryRecord, RegionVersion>> changes;
+        };
+
+        void reset(int map_width, int map_height, int map_length);
+
+        std::size_t size() const
+        {
+            return regions.size();
+        }
+
+        int region_index_of(int block_x, int block_z) const;
+
+        // buckets records of the snapshot by region. must be invoked once per sync window.
+        void commit(const game::BlockHistory&);
+
+        // initialize sync state of the player who has received the whole level data.
+        void mark_all_synced(RegionSyncState&) const;
+
+        // check whether the player needs only changes of the current window around the center region.
+        bool is_window_synced(int center_region_index, const RegionSyncState&) const;
+
+        // collect window records of the regions in view. the result is shareable among players
+        // whose center region is the same and is_window_synced() is true.
+        void collect_window_records(int center_region_index, std::vector<BlockHistoryRecord>&) const;
+
+        // collect changes the player has not received from the regions in view (delta or resync).
+        void collect_unsynced_records(int center_region_index, const RegionSyncState&, std::vector<BlockHistoryRecord>&) const;
+
+        // mark the regions in view synced and update dirty flag of the regions out of view.
+        void mark_view_synced(int center_region_index, RegionSyncState&) const;
+
+        // drop changes which all the players have received. (players not synced yet have no versions)
+        void trim_changes(const std::vector<const RegionSyncState*>&);
+
+        std::size_t num_of_changes() const;
+
+        template <typename Func>
+        void for_each_region_in_view(int center_region_index, Func&& func) const
+        {
+            const int center_x = center_region_index % num_of_regions_x;
+            const int center_z = center_region_index / num_of_regions_x;
+
+            const int min_x = std::max(center_x - region_view_distance, 0);
+            const int max_x = std::min(center_x + region_view_distance, num_of_regions_x - 1);
+            const int min_z = std::max(center_z - region_view_distance, 0);
+            const int max_z = std::min(center_z + region_view_distance, num_of_regions_z - 1);
+
+            for (int z = min_z; z <= max_z; z++) {
+                for (int x = min_x; x <= max_x; x++)
+                    func(z * num_of_regions_x + x);
+            }
+        }
+
+    private:
+        bool is_in_view(int center_region_index, int region_index) const;
+
+        int _map_width = 0;
+        int _map_height = 0;
+        int _map_length = 0;
+
+        int num_of_regions_x = 0;
+        int num_of_regions_z = 0;
+
+        std::vector<Region> regions;
+
+        // regions changed at the current sync window.
+        std::vector<int> window_regions;
+    };
+}
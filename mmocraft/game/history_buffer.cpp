@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "history_buffer.h"
 
+#include "game/block_physics.h"
 #include "net/packet.h"
 
 namespace game
@@ -18,4 +19,26 @@ namespace game
         auto& buffer = input_buffer();
         return buffer.push(reinterpret_cast<const std::byte*>(&record), history_data_unit_size);
     }
-}
\ No newline at end of file
+
+    bool BlockHistory::add_records(const std::vector<game::BlockChange>& changes, std::size_t reserved_records)
+    {
+        if (num_of_live_records() + changes.size() + reserved_records > max_records)
+            return false;
+
+        std::vector<BlockHistoryRecord> records;
+        records.reserve(changes.size());
+
+        for (const auto& change : changes) {
+            records.push_back({
+                .packet_id = std::byte(net::packet_type_id::set_block_server),
+                .x = _byteswap_ushort(change.pos.x),
+                .y = _byteswap_ushort(change.pos.y),
+                .z = _byteswap_ushort(change.pos.z),
+                .block_id = std::byte(change.block_id)
+            });
+        }
+
+        auto& buffer = input_buffer();
+        return buffer.push(reinterpret_cast<const std::byte*>(records.data()), records.size() * history_data_unit_size);
+    }
+}
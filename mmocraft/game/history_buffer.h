@@ -4,6 +4,7 @@
 #include <cassert>
 #include <cstdlib>
 #include <memory>
+#include <vector>
 
 #include "game/block.h"
 #include "util/math.h"
@@ -12,6 +13,8 @@
 
 namespace game
 {
+    struct BlockChange;
+
     // Note: Must be packed in order to optimize serialization operation.
     #pragma pack(push, 1)
     struct BlockHistoryRecord
@@ -30,8 +33,13 @@ namespace game
         
         static constexpr std::size_t history_data_unit_size = sizeof(BlockHistoryRecord);
 
+        static constexpr std::size_t max_records = config::memory::block_history_capacity / history_data_unit_size;
+
         bool add_record(util::Coordinate3D pos, game::BlockID block_id);
 
+        // all or nothing. fails if fewer than reserved_records would be left for other writers.
+        bool add_records(const std::vector<game::BlockChange>&, std::size_t reserved_records = 0);
+
         const BlockHistoryRecord& get_record(std::size_t index) const
         {
             assert(index < config::memory::block_history_capacity / history_data_unit_size);
@@ -45,6 +53,12 @@ namespace game
         {
             return get_snapshot_data().size() / history_data_unit_size;
         }
+
+        // records added after the last snapshot.
+        std::size_t num_of_live_records() const
+        {
+            return input_buffer().size() / history_data_unit_size;
+        }
     };
 
     class CommonChatHistory : public util::DoubleBuffering<config::memory::common_chat_history_capacity>
@@ -4,6 +4,8 @@
 #include <string.h>
 
 #include "database/couchbase_definitions.h"
+#include "game/block_region.h"
+#include "game/player_state_queue.h"
 
 #include "net/packet_id.h"
 #include "net/connection_key.h"
@@ -14,6 +16,12 @@ namespace game
 {
     using PlayerID = std::uint8_t;
 
+    using WorldID = std::uint8_t;
+
+    // players join the default world after handshaking.
+    constexpr WorldID default_world_id = 0;
+    constexpr WorldID invalid_world_id = 0xFF;
+
     // Warning: PlayerLogin procedure uses these enum as raw value.
     //          we must reflect modification to the procedure.
     enum class player_type_id
@@ -31,7 +39,7 @@ namespace game
         admin,
     };
 
-    class PlayerState
+    class PlayerState : public PlayerStateQueueNode
     {
     public:
         enum State
@@ -85,21 +93,56 @@ namespace game
         void transit_state(State hint = State::invaild)
         {
             assert(hint == State::invaild || _next == hint);
+            bool is_changed = _cur != _next;
+
             _prev = _cur;
             _cur = _next;
+
+            if (is_changed)
+                notify_state_transition();
         }
 
         void prepare_state_transition(State cur, State next)
         {
+            bool is_changed = _cur != cur;
+
             _prev = _cur;
             _cur = cur;
             _next = next;
+
+            if (is_changed)
+                notify_state_transition();
+        }
+
+        // players are enqueued to the queue whenever the state is changed.
+        void set_state_queue(PlayerStateQueue* queue)
+        {
+            _state_queue = queue;
+        }
+
+        // enqueues again, e.g. when the transition couldn't be done.
+        void retry_state_transition()
+        {
+            notify_state_transition();
+        }
+
+        bool is_state_queued() const
+        {
+            return is_queued.load(std::memory_order_acquire);
         }
 
     private:
+        void notify_state_transition()
+        {
+            if (_state_queue)
+                _state_queue->push(_cur, this);
+        }
+
         State _prev = State::initialized;
         State _cur = State::initialized;
         State _next = State::initialized;
+
+        PlayerStateQueue* _state_queue = nullptr;
     };
 
     union PlayerPosition {
@@ -223,6 +266,16 @@ namespace game
             return PlayerID(_connection_key.index());
         }
 
+        WorldID world_id() const
+        {
+            return _world_id;
+        }
+
+        void set_world_id(WorldID world_id)
+        {
+            _world_id = world_id;
+        }
+
         PlayerPosition spawn_position() const
         {
             return _gamedata.spawn_pos;
@@ -295,7 +348,7 @@ namespace game
 
         void update_ping_time()
         {
-            _last_ping_time = util::current_monotonic_tick();
+            _last_ping_time = util::coarse_monotonic_tick();
         }
 
         void set_extension_count(unsigned count)
@@ -334,12 +387,19 @@ namespace game
             return _gamedata;
         }
 
+        game::RegionSyncState& region_sync_state()
+        {
+            return _region_sync_state;
+        }
+
     private:
 
         net::ConnectionKey _connection_key;
 
         game::player_type_id _player_type;
 
+        WorldID _world_id = default_world_id;
+
         char _username[16 + 1];
 
         database::collection::PlayerGamedata _gamedata;
@@ -353,5 +413,7 @@ namespace game
         PlayerPosition _last_transferred_pos_tmp;
 
         std::size_t _last_ping_time = 0;
+
+        game::RegionSyncState _region_sync_state;
     };
 }
\ No newline at end of file
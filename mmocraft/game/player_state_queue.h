@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <bitset>
+
+#include "util/common_util.h"
+#include "util/mpsc_queue.h"
+
+namespace game
+{
+    // players are linked into the queue through this node, so enqueuing doesn't allocate.
+    struct PlayerStateQueueNode : util::MpscQueueNode
+    {
+        // a node is linked at most once. (the player must not be deleted while it is set)
+        std::atomic<bool> is_queued{ false };
+
+        PlayerStateQueueNode() = default;
+        PlayerStateQueueNode(const PlayerStateQueueNode&) noexcept { }
+        PlayerStateQueueNode& operator=(const PlayerStateQueueNode&) noexcept { return *this; }
+    };
+
+    // PlayerStateQueue collects players whose state has changed, (a ready list)
+    // so that the world processes only them instead of sweeping all players every tick.
+    // Note: multiple producers (any threads) and a single consumer (world tick).
+    class PlayerStateQueue : util::NonCopyable, util::NonMovable
+    {
+    public:
+        static constexpr std::size_t max_num_of_states = 32;
+
+        // only players in watched states are enqueued. must be invoked before any players are registered.
+        void watch(int state)
+        {
+            watched_states.set(state);
+        }
+
+        // a player already in the queue is not enqueued again, the consumer reads its latest state.
+        void push(int state, PlayerStateQueueNode* node)
+        {
+            if (watched_states.test(state) && not node->is_queued.exchange(true, std::memory_order_acq_rel))
+                queue.push(node);
+        }
+
+        // the popped player can be enqueued again from now on.
+        PlayerStateQueueNode* pop()
+        {
+            auto node = queue.pop();
+            if (node)
+                node->is_queued.exchange(false, std::memory_order_acq_rel);
+            return node;
+        }
+
+    private:
+        std::bitset<max_num_of_states> watched_states;
+        util::MpscQueue<PlayerStateQueueNode> queue;
+    };
+}
@@ -0,0 +1,146 @@
+#include "pch.h"
+#include "terrain_generator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    constexpr int num_of_height_octaves = 4;
+    constexpr float height_frequency = 1.0f / 256;
+    constexpr float height_amplitude = 0.3f;   // ratio to the map height.
+
+    constexpr float cave_frequency = 1.0f / 32;
+    constexpr float cave_threshold = 0.06f;     // thickness of cave tunnels.
+    constexpr int cave_roof_depth = 4;          // caves do not reach the surface.
+
+    constexpr int dirt_depth = 3;
+}
+
+namespace game
+{
+    TerrainGenerator::TerrainGenerator(std::uint64_t seed, util::Coordinate3D map_size)
+        : _map_width{ map_size.x }
+        , _map_height{ map_size.y }
+        , _map_length{ map_size.z }
+        , height_noise{ std::uint32_t(seed) }
+        , cave_noise{ std::uint32_t(seed >> 32) ^ 0x5bd1e995u }
+        , ore_noise{ std::uint32_t(seed) * 31 + 7 }
+    {
+
+    }
+
+    void TerrainGenerator::generate(std::byte* blocks, unsigned num_of_threads) const
+    {
+        std::atomic<int> next_row{ 0 };
+
+        auto worker = [this, blocks, &next_row] {
+            for (;;) {
+                int z_begin = next_row.fetch_add(rows_per_work, std::memory_order_relaxed);
+                if (z_begin >= _map_length)
+                    return;
+
+                generate_rows(blocks, z_begin, std::min(z_begin + rows_per_work, _map_length));
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < std::max(num_of_threads, 1u); i++)
+            workers.emplace_back(worker);
+
+        worker();
+
+        for (auto& worker_thread : workers)
+            worker_thread.join();
+    }
+
+    void TerrainGenerator::generate_heightmap_row(int z, int* heights) const
+    {
+        std::vector<float> octave(_map_width);
+        std::vector<float> height(_map_width, 0.0f);
+
+        float frequency = height_frequency;
+        float amplitude = 1.0f;
+
+        // fractal sum of the octaves. each octave is shifted to avoid correlation at the origin.
+        for (int i = 0; i < num_of_height_octaves; i++) {
+            const float offset = 97.0f * float(i);
+            height_noise.noise2_row(offset, frequency, offset + float(z) * frequency, octave.data(), _map_width);
+
+            for (int x = 0; x < _map_width; x++)
+                height[x] += octave[x] * amplitude;
+
+            frequency *= 2.0f;
+            amplitude *= 0.5f;
+        }
+
+        for (int x = 0; x < _map_width; x++) {
+            int h = water_level() + int(height[x] * height_amplitude * float(_map_height));
+            heights[x] = std::clamp(h, 1, _map_height - 2);
+        }
+    }
+
+    void TerrainGenerator::generate_rows(std::byte* blocks, int z_begin, int z_end) const
+    {
+        const std::size_t layer_size = std::size_t(_map_width) * _map_length;
+
+        std::vector<int> heights(_map_width);
+        std::vector<float> caves(_map_width);
+
+        for (int z = z_begin; z < z_end; z++) {
+            generate_heightmap_row(z, heights.data());
+
+            const int max_height = std::max(*std::max_element(heights.begin(), heights.end()), water_level());
+
+            for (int y = 0; y < _map_height; y++) {
+                auto row = reinterpret_cast<game::BlockID*>(blocks + layer_size * y + std::size_t(_map_width) * z);
+
+                if (y == 0) {
+                    std::memset(row, block_id::bedrock, _map_width);
+                    continue;
+                }
+
+                if (y > max_height) {
+                    std::memset(row, block_id::air, _map_width);
+                    continue;
+                }
+
+                const bool has_cave = y < max_height - cave_roof_depth;
+                if (has_cave)
+                    cave_noise.noise3_row(0.0f, cave_frequency, float(y) * cave_frequency * 2.0f, float(z) * cave_frequency, caves.data(), _map_width);
+
+                for (int x = 0; x < _map_width; x++) {
+                    const int h = heights[x];
+                    const bool is_beach = h <= water_level();
+
+                    if (y > h)
+                        row[x] = y <= water_level() ? block_id::still_water : block_id::air;
+                    else if (y == h)
+                        row[x] = is_beach ? block_id::sand : block_id::grass;
+                    else if (y > h - dirt_depth)
+                        row[x] = is_beach ? block_id::sand : block_id::dirt;
+                    else if (has_cave && y < h - cave_roof_depth && std::abs(caves[x]) < cave_threshold)
+                        row[x] = block_id::air;
+                    else
+                        row[x] = ore_at(x, y, z);
+                }
+            }
+        }
+    }
+
+    game::BlockID TerrainGenerator::ore_at(int x, int y, int z) const
+    {
+        auto chance = ore_noise.hash(x, y, z) % 1000;
+
+        if (chance < 8)
+            return block_id::coal_ore;
+        if (chance < 12 && y < _map_height / 2)
+            return block_id::iron_ore;
+        if (chance < 14 && y < _map_height / 4)
+            return block_id::gold_ore;
+        return block_id::stone;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "game/block.h"
+#include "util/math.h"
+#include "util/noise.h"
+
+namespace game
+{
+    // TerrainGenerator generates a heightmap terrain with caves and ores from a seed.
+    // rows of columns are distributed to worker threads and written in place,
+    // so the memory usage is bounded by the destination (e.g. a file mapping of the block file).
+    class TerrainGenerator
+    {
+    public:
+        // rows of columns taken by a worker at a time.
+        static constexpr int rows_per_work = 8;
+
+        TerrainGenerator(std::uint64_t seed, util::Coordinate3D map_size);
+
+        int water_level() const
+        {
+            return _map_height / 2;
+        }
+
+        // blocks are laid out in (x + width * z + width * length * y) order.
+        void generate(std::byte* blocks, unsigned num_of_threads) const;
+
+        // height of the terrain surface of the row.
+        void generate_heightmap_row(int z, int* heights) const;
+
+    private:
+        void generate_rows(std::byte* blocks, int z_begin, int z_end) const;
+
+        game::BlockID ore_at(int x, int y, int z) const;
+
+        int _map_width;
+        int _map_height;
+        int _map_length;
+
+        util::GradientNoise height_noise;
+        util::GradientNoise cave_noise;
+        util::GradientNoise ore_noise;
+    };
+}
@@ -4,7 +4,9 @@
 #include <algorithm>
 #include <bitset>
 #include <cstring>
+#include <deque>
 #include <iostream>
+#include <unordered_map>
 
 #include "database/query.h"
 #include "net/packet_extension.h"
@@ -13,6 +15,8 @@
 #include "game/world_generator.h"
 
 #include "logging/logger.h"
+#include "metrics/metrics.h"
+#include "metrics/trace.h"
 #include "proto/generated/world_metadata.pb.h"
 #include "util/time_util.h"
 #include "util/protobuf_util.h"
@@ -21,21 +25,44 @@ namespace fs = std::filesystem;
 
 namespace game
 {
-    World::World(net::ConnectionEnvironment& a_connection_env)
-        : connection_env{ a_connection_env }
+    World::World(game::WorldID world_id, net::ConnectionEnvironment& a_connection_env, unsigned num_of_task_threads)
+        : _world_id{ world_id }
+        , connection_env{ a_connection_env }
+        , task_shard{ int(num_of_task_threads) }
         , spawn_player_task{ &World::spawn_player, this, game::world_task_interval::spawn_player }
         , disconnect_player_task{ &World::disconnect_player, this, game::world_task_interval::despawn_player }
         , sync_block_task{ &World::sync_block, this, game::world_task_interval::sync_block }
-        , sync_player_position_task{ &World::sync_player_position, this, game::world_task_interval::sync_player_position }
+        , sync_player_position_task{ &World::sync_player_position, this, game::world_task_interval::sync_player_position, io::Task::Priority::critical }
         , common_chat_transfer_task{ &World::common_chat_transfer, this, game::world_task_interval::common_chat_transfer }
-    { }
+        , level_transfer_task{ &World::transfer_level_data, this, game::world_task_interval::level_transfer }
+        , save_block_data_task{ &World::save_block_data, this, game::world_task_interval::save_block_data, io::Task::Priority::bulk }
+        , save_player_gamedata_task{ &World::save_player_gamedata, this, game::world_task_interval::save_player_gamedata, io::Task::Priority::bulk }
+        , task_scheduler{ "world=\"" + std::to_string(world_id) + '"' }
+    {
+        for (auto state : watched_player_states)
+            player_state_queue.watch(state);
+
+        task_scheduler.add(&sync_player_position_task, "sync_player_position");
+        task_scheduler.add(&spawn_player_task, "spawn_player");
+        task_scheduler.add(&disconnect_player_task, "disconnect_player");
+        task_scheduler.add(&sync_block_task, "sync_block");
+        task_scheduler.add(&common_chat_transfer_task, "common_chat_transfer");
+        task_scheduler.add(&level_transfer_task, "level_transfer");
+        task_scheduler.add(&save_block_data_task, "save_block_data");
+        task_scheduler.add(&save_player_gamedata_task, "save_player_gamedata");
+
+        level_transfer_task.set_task_shard(task_scheduler, task_shard);
+
+        for (unsigned i = 0; i < num_of_task_threads; i++)
+            task_shard.spawn_event_thread();
+    }
 
     void World::broadcast_to_world_player(net::chat_message_type_id message_type, const char* message)
     {
         std::vector<game::Player*> world_players;
         world_players.reserve(connection_env.size_of_max_connections());
 
-        connection_env.select_players([](const game::Player* player)
+        connection_env.select_players(_world_id, [](const game::Player* player)
             { return player->state() >= PlayerState::spawned; },
             world_players);
 
@@ -63,9 +90,18 @@ namespace game
 
     void World::multicast_to_players(const std::vector<game::Player*>& players, std::shared_ptr<io::IoMulticastEventData>& data, void(*successed)(game::Player*))
     {
+        static auto& multicast_fan_out = metrics::histogram("mmocraft_multicast_fan_out", "Recipients of a multicast.");
+        static auto& multicast_failures = metrics::counter("mmocraft_multicast_failures_total", "Recipients who couldn't take a multicast.");
+
+        multicast_fan_out.record(players.size());
+
         for (auto player : players) {
             if (auto connection_io = connection_env.try_acquire_connection_io(player->connection_key())) {
-                if (connection_io->post_multicast_event(data) && successed) successed(player);
+                if (not connection_io->post_multicast_event(data)) {
+                    multicast_failures.add();
+                    continue;
+                }
+                if (successed) successed(player);
             }
         }
     }
@@ -74,20 +110,135 @@ namespace game
 
     void World::process_level_wait_player(const std::vector<game::Player*>& level_wait_players)
     {
-        // compress and serialize block datas.
-        net::PacketLevelDataChunk level_packet(block_mapping.data(), _metadata.volume(),
-            net::PacketFieldType::Short(_metadata.width()),
-            net::PacketFieldType::Short(_metadata.height()),
-            net::PacketFieldType::Short(_metadata.length())
-        );
+        std::vector<game::Player*> gzip_players, fast_map_players;
 
-        std::unique_ptr<std::byte[]> level_packet_data;
-        auto data_size = level_packet.serialize(level_packet_data);
+        for (auto player : level_wait_players) {
+            if (player->is_supported_extension(net::packet_type_id::level_initialize))
+                fast_map_players.push_back(player);
+            else
+                gzip_players.push_back(player);
+        }
+
+        if (not gzip_players.empty())
+            request_level_transfer(gzip_players, false);
+
+        if (not fast_map_players.empty())
+            request_level_transfer(fast_map_players, true);
+    }
+
+    void World::request_level_transfer(const std::vector<game::Player*>& players, bool fast_map)
+    {
+        const auto current_block_version = block_version.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(level_data_cache_lock);
+
+        // level data contains all committed block changes.
+        // changes committed after this point are resynchronized by the block sync task.
+        for (auto player : players)
+            block_regions.mark_all_synced(player->region_sync_state());
+
+        // send cached level data if blocks are not changed.
+        if (auto& cache = level_data_cache[fast_map]; cache.data && cache.block_version == current_block_version) {
+            multicast_to_players(players, cache.data, [](game::Player* player) {
+                player->transit_state(game::PlayerState::level_initialized);
+            });
+            return;
+        }
+
+        // join the unfinished transfer if blocks are not changed since it was queued,
+        // or too many transfers are queued already.
+        if (auto latest = latest_level_transfer[fast_map]) {
+            bool is_stale = latest->block_version != current_block_version;
+            if (not is_stale || level_transfer_task.num_of_pending_works() >= game::world_task_budget::max_pending_transfers) {
+                for (auto player : players) {
+                    // the player receives blocks of the snapshot, so changes after it are resynchronized.
+                    if (is_stale) {
+                        player->region_sync_state() = latest->region_sync_state;
+                        player->region_sync_state().has_dirty_region = true;
+                    }
+                    latest->players.push_back(player->connection_key());
+                }
+                return;
+            }
+        }
+
+        // take a copy of blocks, so that the compression is not affected by block changes afterward.
+        // gzip stream includes the 4-byte volume prefix, but FastMap stream dose not.
+        const auto header_size = fast_map ? WorldGenerator::block_file_header_size : 0;
+
+        auto transfer = std::make_unique<game::LevelTransfer>();
+        transfer->fast_map = fast_map;
+        transfer->block_version = current_block_version;
+        transfer->block_data_size = _metadata.volume() + WorldGenerator::block_file_header_size - header_size;
+        transfer->block_data.reset(new std::byte[transfer->block_data_size]);
+        std::memcpy(transfer->block_data.get(), block_mapping.data() + header_size, transfer->block_data_size);
+        block_regions.mark_all_synced(transfer->region_sync_state);
+
+        for (auto player : players)
+            transfer->players.push_back(player->connection_key());
+
+        latest_level_transfer[fast_map] = transfer.get();
+        level_transfer_task.push(std::move(transfer));
+    }
 
+    bool World::transfer_level_data(game::LevelTransfer& transfer)
+    {
+        if (not transfer.level_packet) {
+            transfer.level_packet = std::make_unique<net::PacketLevelDataChunk>(
+                transfer.block_data.get(), unsigned(transfer.block_data_size),
+                net::PacketFieldType::Short(_metadata.width()),
+                net::PacketFieldType::Short(_metadata.height()),
+                net::PacketFieldType::Short(_metadata.length()),
+                transfer.fast_map
+            );
+        }
+
+        // compress chunks until the slice budget is exhausted.
+        const auto slice_end_at = util::fine_time_ns() + game::world_task_budget::level_transfer_slice * 1'000'000;
+
+        while (not transfer.level_packet->serialize_chunks(game::world_task_budget::level_transfer_chunks)) {
+            if (util::fine_time_ns() >= slice_end_at)
+                return false;
+        }
+
+        std::unique_ptr<std::byte[]> level_packet_data;
+        auto data_size = transfer.level_packet->release(level_packet_data);
         auto multicast_data = std::make_shared<io::IoMulticastEventData>(std::move(level_packet_data), data_size);
-        multicast_to_players(level_wait_players, multicast_data, [](game::Player* player) {
+
+        // no more players can join the transfer from now on.
+        std::vector<net::ConnectionKey> connection_keys;
+        {
+            std::lock_guard<std::mutex> lock(level_data_cache_lock);
+            auto& cache = level_data_cache[transfer.fast_map];
+
+            if (cache.block_version <= transfer.block_version)
+                cache = { multicast_data, transfer.block_version };
+
+            if (latest_level_transfer[transfer.fast_map] == &transfer)
+                latest_level_transfer[transfer.fast_map] = nullptr;
+
+            connection_keys = std::move(transfer.players);
+        }
+
+        std::vector<game::Player*> players;
+        for (auto connection_key : connection_keys) {
+            if (auto conn = connection_env.try_acquire_connection(connection_key)) {
+                // skip players disconnected during the transfer.
+                auto player = conn->associated_player();
+                if (player && player->state() == game::PlayerState::level_initializing && player->world_id() == _world_id)
+                    players.push_back(player);
+            }
+        }
+
+        multicast_to_players(players, multicast_data, [](game::Player* player) {
             player->transit_state(game::PlayerState::level_initialized);
         });
+
+        // blocks were changed during the transfer.
+        if (transfer.block_version != block_version.load(std::memory_order_relaxed))
+            sync_block_task.request_resync();
+
+        return true;
     }
 
     void World::spawn_player(const std::vector<game::Player*>& spawn_wait_players)
@@ -96,7 +247,7 @@ namespace game
         std::vector<game::Player*> old_players;
         old_players.reserve(connection_env.size_of_max_connections());
 
-        connection_env.select_players([](const game::Player* player)
+        connection_env.select_players(_world_id, [](const game::Player* player)
             { return player->state() >= PlayerState::spawned; },
             old_players);
 
@@ -143,6 +294,9 @@ namespace game
                 player->transit_state(game::PlayerState::disconnected);
             }
         }
+
+        // saved as a batch with pending updates.
+        database::player_gamedata_cache().flush();
     }
 
     std::size_t World::coordinate_to_block_map_index(int x, int y, int z)
@@ -162,26 +316,161 @@ namespace game
             auto& record = block_change_history.get_record(index);
             std::size_t block_map_index = coordinate_to_block_map_index(record.x, record.y, record.z);
 
-            if (block_map_index < _metadata.volume())
+            if (block_map_index < _metadata.volume()) {
                 block_array[block_map_index] = record.block_id;
+                block_mapping.mark_dirty(block_map_index);
+                block_physics.activate(_byteswap_ushort(record.x), _byteswap_ushort(record.y), _byteswap_ushort(record.z));
+            }
         }
+
+        // cached level datas are outdated.
+        if (history_size)
+            block_version.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void World::simulate_block_physics()
+    {
+        auto blocks = block_mapping.data() + WorldGenerator::block_file_header_size;
+
+        // changes of the block physics don't take the room of player edits, the rest stays active.
+        block_physics.simulate(blocks, game::world_task_budget::block_physics_updates,
+            [this](const std::vector<game::BlockChange>& changes) {
+                return sync_block_task.push(changes, game::world_task_budget::player_block_changes);
+            });
+
+        // unsimulated blocks are carried over to the next window.
+        sync_block_task.set_active_block(block_physics.has_active_blocks());
+    }
+
+    int World::center_region_index_of(const game::Player& player) const
+    {
+        auto pos = player.last_position();
+        if (pos.raw_coordinate() == 0)
+            pos = player.spawn_position();
+
+        // player coordinates are fixed-point numbers (1/32 block).
+        return block_regions.region_index_of(pos.view.x / 32, pos.view.z / 32);
+    }
+
+    std::size_t World::serialize_block_sync_data(const std::vector<game::BlockHistoryRecord>& records, bool bulk_block_update,
+                                                 std::unique_ptr<std::byte[]>& serialized_data)
+    {
+        if (bulk_block_update)
+            return net::PacketBulkBlockUpdate::serialize(records, _metadata.width(), _metadata.length(), serialized_data);
+
+        // records are already serialized as set block packets.
+        auto data_size = records.size() * game::BlockHistory::history_data_unit_size;
+        serialized_data.reset(new std::byte[data_size]);
+        std::memcpy(serialized_data.get(), records.data(), data_size);
+
+        return data_size;
+    }
+
+    std::shared_ptr<io::IoMulticastEventData> World::create_block_sync_data(const std::vector<game::BlockHistoryRecord>& records, bool bulk_block_update)
+    {
+        if (records.empty())
+            return nullptr;
+
+        std::unique_ptr<std::byte[]> block_sync_data;
+        auto data_size = serialize_block_sync_data(records, bulk_block_update, block_sync_data);
+
+        return std::make_shared<io::IoMulticastEventData>(std::move(block_sync_data), data_size);
     }
 
     void World::sync_block(const std::vector<game::Player*>& level_wait_players, const game::BlockHistory& block_change_history)
     {
-        // copy block histories.
-        if (block_change_history.size()) {
+        if (block_change_history.size())
             commit_block_changes(block_change_history);
 
-            auto block_history_data = block_change_history.get_snapshot_data();
-            std::unique_ptr<std::byte[]> copyed_block_history_data(block_history_data.clone());
+        // Note: commit even if there are no changes to close the previous sync window.
+        block_regions.commit(block_change_history);
+
+        // players receiving the level data are selected only to keep the changes they will need.
+        std::vector<game::Player*> world_players;
+        world_players.reserve(connection_env.size_of_max_connections());
+
+        connection_env.select_players(_world_id, [](const game::Player* player)
+            { return player->state() >= PlayerState::level_initializing; },
+            world_players);
+
+        std::vector<const game::RegionSyncState*> sync_states;
+        sync_states.reserve(world_players.size());
+
+        // players whose center region is the same share the block sync data of the current window.
+        // (index 0: legacy set block packets, index 1: bulk block update packets)
+        struct WindowSyncData
+        {
+            bool is_collected = false;
+            std::vector<game::BlockHistoryRecord> records;
+            std::shared_ptr<io::IoMulticastEventData> data[2];
+        };
+        std::unordered_map<int, WindowSyncData> window_sync_data;
+        std::vector<game::BlockHistoryRecord> records;
+        bool has_dirty_region = false;
+
+        for (auto player : world_players) {
+            sync_states.push_back(&player->region_sync_state());
+            if (player->state() < PlayerState::level_initialized)
+                continue;
+
+            auto connection_io = connection_env.try_acquire_connection_io(player->connection_key());
+            if (not connection_io)
+                continue;
+
+            auto& sync_state = player->region_sync_state();
+            auto center_region_index = center_region_index_of(*player);
+            bool bulk_block_update = player->is_supported_extension(net::packet_type_id::bulk_block_update);
+            bool is_sent = true;
+
+            if (block_regions.is_window_synced(center_region_index, sync_state)) {
+                auto& window = window_sync_data[center_region_index];
+                if (not window.is_collected) {
+                    block_regions.collect_window_records(center_region_index, window.records);
+                    window.is_collected = true;
+                }
+
+                auto& multicast_data = window.data[bulk_block_update];
+                if (not multicast_data)
+                    multicast_data = create_block_sync_data(window.records, bulk_block_update);
+
+                if (multicast_data)
+                    is_sent = connection_io->post_multicast_event(multicast_data);
+            }
+            else {
+                // resync changes the player missed while the regions were out of view.
+                records.clear();
+                block_regions.collect_unsynced_records(center_region_index, sync_state, records);
+
+                if (not records.empty()) {
+                    std::unique_ptr<std::byte[]> block_sync_data;
+                    auto data_size = serialize_block_sync_data(records, bulk_block_update, block_sync_data);
+
+                    if (not connection_io->send_raw_data(block_sync_data.get(), data_size)) {
+                        auto multicast_data = std::make_shared<io::IoMulticastEventData>(std::move(block_sync_data), data_size);
+                        is_sent = connection_io->post_multicast_event(multicast_data);
+                    }
+                }
+            }
+
+            // unsent regions remain dirty and will be resynchronized at the next window.
+            if (is_sent)
+                block_regions.mark_view_synced(center_region_index, sync_state);
+            else
+                sync_state.has_dirty_region = true;
 
-            auto multicast_data = std::make_shared<io::IoMulticastEventData>(std::move(copyed_block_history_data), block_history_data.size());
-            multicast_to_specific_players<PlayerState::level_initialized>(multicast_data);
+            has_dirty_region |= sync_state.has_dirty_region;
         }
+
+        sync_block_task.set_dirty_region(has_dirty_region);
+
+        // changes every player has received are no longer needed for resync.
+        block_regions.trim_changes(sync_states);
+
+        // changes of the block physics are synchronized at the next window.
+        simulate_block_physics();
         
-        // submit level data to handshaked players.
-        // Note: level data task can't be seperated from block data task to achieve block data synchronization.
+        // request level data transfer of handshaked players.
+        // Note: level data must be taken in the block sync task to achieve block data synchronization.
         //       the client dose not allow to send block datas before level initialization completed.
         if (not level_wait_players.empty())
             process_level_wait_player(level_wait_players);
@@ -193,7 +482,7 @@ namespace game
         std::vector<game::Player*> world_players;
         world_players.reserve(connection_env.size_of_max_connections());
 
-        connection_env.select_players([](const game::Player* player)
+        connection_env.select_players(_world_id, [](const game::Player* player)
             { return player->state() >= PlayerState::spawned; },
             world_players);
 
@@ -217,6 +506,31 @@ namespace game
         }
     }
 
+    void World::save_block_data()
+    {
+        // write back only pages changed since the last save.
+        if (block_mapping.is_valid())
+            block_mapping.flush_dirty();
+
+        last_save_map_at = util::coarse_monotonic_tick();
+    }
+
+    void World::save_player_gamedata()
+    {
+        std::vector<game::Player*> world_players;
+        world_players.reserve(connection_env.size_of_max_connections());
+
+        connection_env.select_players(_world_id, [](const game::Player* player)
+            { return player->state() >= PlayerState::spawned; },
+            world_players);
+
+        // only changed gamedata is queued, and the cache flushes it on the server tick.
+        for (auto player : world_players) {
+            if (auto conn = connection_env.try_acquire_connection(player->connection_key()))
+                database::PlayerGamedata::update(*player);
+        }
+    }
+
     /* World task end */
 
     bool World::try_change_block(util::Coordinate3D pos, BlockID block_id)
@@ -229,85 +543,202 @@ namespace game
         return common_chat_transfer_task.push(chat_packet_data);
     }
 
-    void World::tick(io::RegisteredIO& task_scheduler)
+    void World::register_player(game::Player& player)
     {
-        auto transit_player_state = [this](net::Connection& conn, game::Player& player) {
-            switch (player.state()) {
-            case game::PlayerState::ex_handshaked:
-            {
-                net::PacketExtInfo ext_info_packet;
-                net::PacketExtEntry ext_entry_packet;
+        player.set_world_id(_world_id);
+        player.set_state_queue(&player_state_queue);
+    }
 
-                if (conn.io()->send_packet(ext_info_packet) && conn.io()->send_packet(ext_entry_packet))
-                    player.prepare_state_transition(game::PlayerState::extension_syncing, game::PlayerState::extension_synced);
-            }
-            break;
-            case game::PlayerState::handshaked:
-            case game::PlayerState::extension_synced:
-            {
-                conn.on_handshake_success();
-
-                player.prepare_state_transition(game::PlayerState::level_initializing, game::PlayerState::level_initialized);
-                sync_block_task.push(&player);
-            }
-            break;
-            case game::PlayerState::level_initialized:
-            {
-                player.set_spawn_coordinate(_metadata.spawn_x(), _metadata.spawn_y(), _metadata.spawn_z(), false);
-                player.set_spawn_orientation(_metadata.spawn_yaw(), _metadata.spawn_pitch(), false);
-
-                player.prepare_state_transition(game::PlayerState::spawning, game::PlayerState::spawned);
-                spawn_player_task.push(&player);
-            }
-            break;
-            case game::PlayerState::spawned:
-            {
-                if (player.last_ping_time() + game::world_task_interval::ping < util::current_monotonic_tick()) {
-                    conn.io()->send_ping();
-                    player.update_ping_time();
-                }
-            }
-            break;
-            case game::PlayerState::disconnecting:
-            {
-                disconnect_player_task.push(&player);
-            }
-            break;
-            case game::PlayerState::disconnected:
-            {
-                conn.disconnect();
-            }
-            break;
-            }
-        };
+    void World::request_world_transfer(const game::Player& player, game::World& target_world)
+    {
+        world_transfer_queue.push(player.connection_key(), &target_world);
+    }
+
+    void World::join_player(game::Player& player)
+    {
+        // spawn at the spawn point of this world.
+        player.set_position(game::PlayerPosition());
+        player.set_spawn_position(game::PlayerPosition());
+
+        register_player(player);
+
+        // re-run the level initialization path.
+        player.prepare_state_transition(game::PlayerState::handshaked, game::PlayerState::level_initializing);
+    }
+
+    void World::leave_player(game::Player& player)
+    {
+        std::vector<game::Player*> leaving_players{ &player };
 
-        connection_env.for_each_player(transit_player_state);
+        // remove from the world first, not to receive its own despawn packet.
+        player.set_world_id(game::invalid_world_id);
+
+        if (player.state() >= game::PlayerState::spawned)
+            despawn_player(leaving_players);
+    }
 
-        for (auto world_task : world_tasks) {
-            if (world_task->ready()) {
-                task_scheduler.schedule_task(world_task);
+    void World::process_world_transfer()
+    {
+        while (auto transfer = world_transfer_queue.pop()) {
+            auto conn = connection_env.try_acquire_connection(transfer->connection_key);
+            if (not conn)
+                continue;
+
+            // the player may have disconnected or moved already since the request.
+            auto player = conn->associated_player();
+            if (not player || player->world_id() != _world_id || player->state() != game::PlayerState::spawned)
+                continue;
+
+            leave_player(*player);
+            transfer->target_world->join_player(*player);
+        }
+    }
+
+    void World::process_player_state_transition()
+    {
+        // drain first, so players enqueued again while processing wait for the next tick.
+        std::vector<game::Player*> transited_players;
+        while (auto node = player_state_queue.pop())
+            transited_players.push_back(static_cast<game::Player*>(static_cast<game::PlayerState*>(node)));
+
+        for (auto player : transited_players) {
+            auto conn = connection_env.try_acquire_connection(player->connection_key());
+            if (not conn || conn->associated_player() != player)
+                continue;
+
+            // the player has moved to another world. let that world handle the latest state.
+            if (player->world_id() != _world_id) {
+                if (player->world_id() != game::invalid_world_id)
+                    player->retry_state_transition();
+                continue;
             }
+
+            transit_player_state(*conn, *player);
         }
     }
 
-    bool World::load_filesystem_world(std::string_view a_save_dir)
+    void World::transit_player_state(net::Connection& conn, game::Player& player)
+    {
+        switch (player.state()) {
+        case game::PlayerState::ex_handshaked:
+        {
+            net::PacketExtInfo ext_info_packet;
+            net::PacketExtEntry ext_entry_packet;
+
+            if (conn.io()->send_packet(ext_info_packet) && conn.io()->send_packet(ext_entry_packet))
+                player.prepare_state_transition(game::PlayerState::extension_syncing, game::PlayerState::extension_synced);
+            else
+                player.retry_state_transition(); // retry at the next tick.
+        }
+        break;
+        case game::PlayerState::handshaked:
+        case game::PlayerState::extension_synced:
+        {
+            conn.on_handshake_success(unsigned(_metadata.volume()));
+
+            player.prepare_state_transition(game::PlayerState::level_initializing, game::PlayerState::level_initialized);
+            sync_block_task.push(&player);
+        }
+        break;
+        case game::PlayerState::level_initialized:
+        {
+            player.set_spawn_coordinate(_metadata.spawn_x(), _metadata.spawn_y(), _metadata.spawn_z(), false);
+            player.set_spawn_orientation(_metadata.spawn_yaw(), _metadata.spawn_pitch(), false);
+
+            player.prepare_state_transition(game::PlayerState::spawning, game::PlayerState::spawned);
+            spawn_player_task.push(&player);
+        }
+        break;
+        case game::PlayerState::spawned:
+        {
+            conn.io()->send_ping();
+            player.update_ping_time();
+
+            ping_wait_players.push_back({ util::coarse_monotonic_tick() + game::world_task_interval::ping, player.connection_key() });
+        }
+        break;
+        case game::PlayerState::disconnecting:
+        {
+            disconnect_player_task.push(&player);
+        }
+        break;
+        case game::PlayerState::disconnected:
+        {
+            conn.disconnect();
+        }
+        break;
+        }
+    }
+
+    void World::process_ping()
+    {
+        // deadlines are sorted because the interval is constant.
+        const auto now = util::coarse_monotonic_tick();
+
+        while (not ping_wait_players.empty() && ping_wait_players.front().first <= now) {
+            auto connection_key = ping_wait_players.front().second;
+            ping_wait_players.pop_front();
+
+            auto conn = connection_env.try_acquire_connection(connection_key);
+            if (not conn)
+                continue;
+
+            auto player = conn->associated_player();
+            if (not player || player->state() != game::PlayerState::spawned || player->world_id() != _world_id)
+                continue;
+
+            conn->io()->send_ping();
+            player->update_ping_time();
+
+            ping_wait_players.push_back({ now + game::world_task_interval::ping, connection_key });
+        }
+    }
+
+    void World::tick()
+    {
+        TRACE_SPAN_ARG("World::tick", _world_id);
+
+        process_world_transfer();
+
+        process_player_state_transition();
+
+        process_ping();
+    }
+
+    void World::dispatch_tasks()
+    {
+        task_scheduler.dispatch(task_shard);
+    }
+
+    void World::report_task_statistics()
+    {
+        task_scheduler.log_statistics();
+        task_scheduler.reset_statistics();
+    }
+
+    bool World::load_filesystem_world(const config::Configuration_World& world_conf)
     {
         if (last_save_map_at) {
             CONSOLE_LOG(error) << "World is already loaded.";
             return false;
         }
 
+        _name = world_conf.name();
+
         // set world files path.
-        save_dir = a_save_dir;
+        save_dir = world_conf.save_dir();
         block_data_path = save_dir / block_data_filename;
         metadata_path = save_dir / world_metadata_filename;
+
+        if (not fs::exists(save_dir))
+            fs::create_directories(save_dir);
         
-        WorldGenerator::create_world_if_not_exist(block_data_path, metadata_path);
+        WorldGenerator::create_world_if_not_exist(world_conf, block_data_path, metadata_path);
 
         load_metadata();
-        load_block_data();
+        load_block_data({ .prefetch = world_conf.prefetch_blocks(), .huge_pages = world_conf.huge_pages() });
 
-        last_save_map_at = util::current_monotonic_tick();
+        last_save_map_at = util::coarse_monotonic_tick();
 
         return true;
     }
@@ -315,11 +746,14 @@ namespace game
     void World::load_metadata()
     {
         util::json_file_to_proto_message(&_metadata, metadata_path);
+
+        block_regions.reset(_metadata.width(), _metadata.height(), _metadata.length());
+        block_physics.reset(_metadata.width(), _metadata.height(), _metadata.length());
     }
 
-    void World::load_block_data()
+    void World::load_block_data(const win::FileMappingOptions& options)
     {
-        if (not block_mapping.open(block_data_path.string())) {
+        if (not block_mapping.open(block_data_path.string(), options)) {
             CONSOLE_LOG(error) << "Unalbe to mapping block map";
             return;
         }
@@ -1,13 +1,24 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <filesystem>
 #include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 #include <shared_mutex>
 
 #include "game/block.h"
+#include "game/block_physics.h"
+#include "game/block_region.h"
 #include "game/player.h"
+#include "game/player_state_queue.h"
+#include "game/world_transfer_queue.h"
 #include "game/world_task.h"
+#include "io/io_service.h"
+#include "io/task_scheduler.h"
+#include "proto/generated/config.pb.h"
 #include "proto/generated/world_metadata.pb.h"
 #include "net/connection_key.h"
 #include "net/connection_environment.h"
@@ -31,12 +42,34 @@ namespace game
         constexpr std::size_t sync_player_position  = 100;      // 100 milliseconds.
         constexpr std::size_t ping                  = 5 * 1000; // 5 seconds.
         constexpr std::size_t common_chat_transfer  = 1 * 1000; // 1 seconds
+        constexpr std::size_t level_transfer        = 0;
+        constexpr std::size_t save_block_data       = 30 * 1000;// 30 seconds.
+        constexpr std::size_t save_player_gamedata  = 10 * 1000;// 10 seconds. (bounds the loss by a crash)
+    }
+
+    namespace world_task_budget {
+        constexpr std::size_t level_transfer_slice  = 10;       // 10 milliseconds.
+        constexpr std::size_t level_transfer_chunks = 16;       // chunks between budget checks.
+        constexpr std::size_t block_physics_updates = 256;      // active blocks per block sync.
+        constexpr std::size_t player_block_changes  = 512;      // block history records the block physics leaves for players.
+        constexpr std::size_t max_pending_transfers = 4;        // level transfers (block copies) in the queue.
     }
     
     class World final : util::NonCopyable, util::NonMovable
     {
     public:
-        World(net::ConnectionEnvironment&);
+        // each world dispatches its tasks to its own event thread shard.
+        World(game::WorldID, net::ConnectionEnvironment&, unsigned num_of_task_threads = 1);
+
+        game::WorldID world_id() const
+        {
+            return _world_id;
+        }
+
+        const std::string& name() const
+        {
+            return _name;
+        }
 
         void broadcast_to_world_player(net::chat_message_type_id, const char* message);
 
@@ -44,6 +77,8 @@ namespace game
 
         void process_level_wait_player(const std::vector<game::Player*>&);
 
+        bool transfer_level_data(game::LevelTransfer&);
+
         void spawn_player(const std::vector<game::Player*>&);
 
         void disconnect_player(const std::vector<game::Player*>&);
@@ -55,6 +90,10 @@ namespace game
         void sync_player_position();
 
         void common_chat_transfer(util::byte_view chat_history_data);
+
+        void save_block_data();
+
+        void save_player_gamedata();
         
         /* end */
 
@@ -62,9 +101,25 @@ namespace game
 
         bool try_add_common_chat(util::byte_view chat_packet_data);
 
-        void tick(io::RegisteredIO&);
+        // must be invoked before the player changes its state.
+        void register_player(game::Player&);
+
+        // thread-safe. the player leaves this world at the next world tick.
+        void request_world_transfer(const game::Player&, game::World& target_world);
+
+        // take over the player from another world. the player re-runs the level initialization.
+        void join_player(game::Player&);
+
+        // the player is moving to another world.
+        void leave_player(game::Player&);
+
+        void tick();
 
-        bool load_filesystem_world(std::string_view);
+        void dispatch_tasks();
+
+        void report_task_statistics();
+
+        bool load_filesystem_world(const config::Configuration_World&);
 
     private:
         void send_to_players(const std::vector<game::Player*>&, util::byte_view ,
@@ -77,7 +132,7 @@ namespace game
             std::vector<game::Player*> players;
             players.reserve(connection_env.size_of_max_connections());
 
-            connection_env.select_players([](const game::Player* player)
+            connection_env.select_players(_world_id, [](const game::Player* player)
                 { return player->state() >= T; },
                 players);
 
@@ -92,41 +147,101 @@ namespace game
             std::vector<game::Player*> players;
             players.reserve(connection_env.size_of_max_connections());
 
-            connection_env.select_players([](const game::Player* player)
+            connection_env.select_players(_world_id, [](const game::Player* player)
                 { return player->state() >= T; },
                 players);
 
             multicast_to_players(players, data);
         }
         
+        void process_world_transfer();
+
+        void process_player_state_transition();
+
+        void transit_player_state(net::Connection&, game::Player&);
+
+        void process_ping();
+
         void commit_block_changes(const game::BlockHistory&);
 
+        void simulate_block_physics();
+
+        void request_level_transfer(const std::vector<game::Player*>&, bool fast_map);
+
+        int center_region_index_of(const game::Player&) const;
+
+        std::size_t serialize_block_sync_data(const std::vector<game::BlockHistoryRecord>&, bool bulk_block_update, std::unique_ptr<std::byte[]>&);
+
+        std::shared_ptr<io::IoMulticastEventData> create_block_sync_data(const std::vector<game::BlockHistoryRecord>&, bool bulk_block_update);
+
         void load_metadata();
 
-        void load_block_data();
+        void load_block_data(const win::FileMappingOptions&);
 
         std::size_t coordinate_to_block_map_index(int x, int y, int z);
 
+        const game::WorldID _world_id;
+        std::string _name;
+
         net::ConnectionEnvironment& connection_env;
 
+        io::IoCompletionPort task_shard;
+
         game::WorldPlayerTask spawn_player_task;
         game::WorldPlayerTask disconnect_player_task;
         game::BlockSyncTask sync_block_task;
         io::SimpleTask<game::World> sync_player_position_task;
         game::CommonChatTask common_chat_transfer_task;
-
-        io::Task* world_tasks[5] = {
-            &spawn_player_task,
-            &disconnect_player_task,
-            &sync_block_task,
-            &sync_player_position_task,
-            &common_chat_transfer_task
+        game::LevelTransferTask level_transfer_task;
+        io::SimpleTask<game::World> save_block_data_task;
+        io::SimpleTask<game::World> save_player_gamedata_task;
+
+        io::TaskScheduler task_scheduler;
+
+        // states that the world has to handle.
+        static constexpr game::PlayerState::State watched_player_states[] = {
+            game::PlayerState::ex_handshaked,
+            game::PlayerState::handshaked,
+            game::PlayerState::extension_synced,
+            game::PlayerState::level_initialized,
+            game::PlayerState::spawned,
+            game::PlayerState::disconnecting,
+            game::PlayerState::disconnected,
         };
 
+        game::PlayerStateQueue player_state_queue;
+
+        game::WorldTransferQueue world_transfer_queue;
+
+        // (ping deadline, connection key) of spawned players.
+        std::deque<std::pair<std::size_t, net::ConnectionKey>> ping_wait_players;
+
         WorldMetadata _metadata;
 
         win::FileMapping block_mapping;
 
+        // incremented whenever block changes are committed.
+        std::atomic<std::size_t> block_version{ 0 };
+
+        // compressed level data streams (index 0: gzip, index 1: FastMap raw deflate).
+        // shared by level wait players until blocks are changed.
+        struct LevelDataCache
+        {
+            std::shared_ptr<io::IoMulticastEventData> data;
+            std::size_t block_version = 0;
+        };
+
+        std::mutex level_data_cache_lock;
+        LevelDataCache level_data_cache[2];
+
+        // the last queued transfer which is not finished yet. (guarded by level_data_cache_lock)
+        // players join it instead of copying blocks again.
+        game::LevelTransfer* latest_level_transfer[2] = {};
+
+        game::BlockRegionTable block_regions;
+
+        game::BlockPhysics block_physics;
+
         std::size_t last_save_map_at = 0;
 
         std::filesystem::path save_dir;
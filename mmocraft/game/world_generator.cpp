@@ -1,46 +1,77 @@
 #include "pch.h"
 #include "world_generator.h"
 
+#include <chrono>
+#include <random>
+
 #include "config/config.h"
+#include "game/terrain_generator.h"
 #include "proto/generated/world_metadata.pb.h"
 #include "util/protobuf_util.h"
 #include "logging/logger.h"
+#include "win/file_mapping.h"
 
 namespace fs = std::filesystem;
 
 namespace game
 {
-    void WorldGenerator::create_world_if_not_exist(const fs::path& block_data_path, const fs::path& metadata_path)
+    void WorldGenerator::create_world_if_not_exist(const config::Configuration_World& world_conf, const fs::path& block_data_path, const fs::path& metadata_path)
     {
         if (fs::exists(metadata_path))
             return;
 
-        const auto& conf = config::get_config();
-
-        CONSOLE_LOG_IF(fatal, conf.world().width() < 10 || conf.world().height() < 10 || conf.world().length() < 10)
+        CONSOLE_LOG_IF(fatal, world_conf.width() < 10 || world_conf.height() < 10 || world_conf.length() < 10)
             << "world map size must greater than 10x10x10.";
 
-        auto map_size = util::Coordinate3D{ conf.world().width(), conf.world().height(), conf.world().length()};
+        auto map_size = util::Coordinate3D{ world_conf.width(), world_conf.height(), world_conf.length()};
         std::size_t map_volume = map_size.x * map_size.y * map_size.z;
 
+        const auto& generator = world_conf.generator().empty() ? flat_generator : world_conf.generator();
+        const auto seed = world_conf.seed() ? world_conf.seed() : (std::uint64_t(std::random_device{}()) << 32 | std::random_device{}());
+
         // write world files to the disk.
-        create_block_file(block_data_path, map_size, map_volume);
-        create_metadata_file(metadata_path, map_size);
+        CONSOLE_LOG_IF(fatal, not create_block_file(block_data_path, map_size, map_volume, generator, seed))
+            << "Unable to create block file: " << block_data_path;
+        create_metadata_file(metadata_path, map_size, generator, seed);
     }
 
-    void WorldGenerator::create_block_file(const fs::path& block_data_path, util::Coordinate3D map_size, std::size_t map_volume)
+    bool WorldGenerator::create_block_file(const fs::path& block_data_path, util::Coordinate3D map_size, std::size_t map_volume,
+                                           const std::string& generator, std::uint64_t seed)
     {
-        auto blocks_ptr = WorldGenerator::generate_flat_world(map_size);
-
-        std::ofstream block_file(block_data_path);
-        // block data header (map volume)
-        map_volume = ::htonl(u_long(map_volume));
-        block_file.write(reinterpret_cast<char*>(&map_volume), block_file_header_size);
-        // raw block data
-        block_file.write(blocks_ptr.get(), map_size.x * map_size.y * map_size.z);
+        {
+            std::ofstream block_file(block_data_path, std::ios::binary | std::ios::trunc);
+            // block data header (map volume)
+            auto volume_header = ::htonl(u_long(map_volume));
+            block_file.write(reinterpret_cast<char*>(&volume_header), block_file_header_size);
+        }
+
+        // raw block data is generated in the file mapping instead of a heap buffer of the whole map.
+        fs::resize_file(block_data_path, block_file_header_size + map_volume);
+
+        win::FileMapping block_mapping;
+        if (not block_mapping.open(block_data_path.string()))
+            return false;
+
+        auto blocks = block_mapping.data() + block_file_header_size;
+        auto started_at = std::chrono::steady_clock::now();
+
+        if (generator == terrain_generator) {
+            auto num_of_threads = std::max(config::get_config().system().num_of_processors(), 1u);
+            TerrainGenerator(seed, map_size).generate(blocks, num_of_threads);
+        }
+        else
+            generate_flat_world(blocks, map_size);
+
+        block_mapping.flush();
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started_at);
+        CONSOLE_LOG(info) << "Generated " << generator << " world (" << map_size.x << 'x' << map_size.y << 'x' << map_size.z
+                          << ", seed " << seed << ") in " << elapsed.count() << "ms";
+        return true;
     }
 
-    void WorldGenerator::create_metadata_file(const fs::path& metadata_path, util::Coordinate3D map_size)
+    void WorldGenerator::create_metadata_file(const fs::path& metadata_path, util::Coordinate3D map_size,
+                                              const std::string& generator, std::uint64_t seed)
     {
         WorldMetadata metadata;
         metadata.set_format_version(WORLD_METADATA_FORMAT_VERSION);
@@ -58,21 +89,20 @@ namespace game
 
         metadata.set_created_at(util::current_timestmap());
 
+        metadata.set_generator(generator);
+        metadata.set_seed(seed);
+
         util::proto_message_to_json_file(metadata, metadata_path);
     }
 
-
-
-    std::unique_ptr<BlockID[]> WorldGenerator::generate_flat_world(util::Coordinate3D map_size)
+    void WorldGenerator::generate_flat_world(std::byte* blocks, util::Coordinate3D map_size)
     {
-        const auto plain_size = map_size.x * map_size.z;
-        auto blocks = new BlockID[plain_size * map_size.y]();
+        // Note: blocks are zero-filled (air) by the file extension.
+        const std::size_t plain_size = std::size_t(map_size.x) * map_size.z;
 
         auto num_of_dirt_block = plain_size * (map_size.y / 2);
         std::memset(blocks, game::block_id::dirt, num_of_dirt_block);
         std::memset(blocks + num_of_dirt_block, game::block_id::grass, plain_size);
         std::memset(blocks, game::block_id::bedrock, plain_size);
-
-        return std::unique_ptr<BlockID[]>(blocks);
     }
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <string>
 
 #include "game/block.h"
+#include "proto/generated/config.pb.h"
 #include "util/common_util.h"
 #include "util/math.h"
 
@@ -15,12 +18,18 @@ namespace game
     public:
         static constexpr std::size_t block_file_header_size = 4;
 
-        static void create_world_if_not_exist(const std::filesystem::path& block_data_path, const std::filesystem::path& metadata_path);
+        static constexpr const char* flat_generator = "flat";
+        static constexpr const char* terrain_generator = "terrain";
 
-        static void create_block_file(const std::filesystem::path& block_data_path, util::Coordinate3D map_size, std::size_t map_volume);
+        static void create_world_if_not_exist(const config::Configuration_World&, const std::filesystem::path& block_data_path, const std::filesystem::path& metadata_path);
 
-        static void create_metadata_file(const std::filesystem::path& metadata_path, util::Coordinate3D map_size);
+        // blocks are generated in place of the mapped block file.
+        static bool create_block_file(const std::filesystem::path& block_data_path, util::Coordinate3D map_size, std::size_t map_volume,
+                                      const std::string& generator, std::uint64_t seed);
 
-        static std::unique_ptr<BlockID[]> generate_flat_world(util::Coordinate3D map_size);
+        static void create_metadata_file(const std::filesystem::path& metadata_path, util::Coordinate3D map_size,
+                                         const std::string& generator, std::uint64_t seed);
+
+        static void generate_flat_world(std::byte* blocks, util::Coordinate3D map_size);
     };
 }
\ No newline at end of file
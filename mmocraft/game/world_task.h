@@ -1,11 +1,19 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #include "io/task.h"
+#include "io/task_scheduler.h"
 #include "game/block.h"
+#include "game/block_physics.h"
+#include "game/block_region.h"
 #include "game/history_buffer.h"
+#include "net/connection_key.h"
+#include "net/packet.h"
 #include "util/math.h"
+#include "util/mpsc_queue.h"
 
 namespace game
 {
@@ -16,15 +24,20 @@ namespace game
     public:
         using handler_type = void (game::World::* const)(const std::vector<game::Player*>&);
 
-        WorldPlayerTask(handler_type handler, game::World* world_inst, std::size_t interval_ms = 0)
-            : io::Task{ interval_ms }
+        WorldPlayerTask(handler_type handler, game::World* world_inst, std::size_t interval_ms = 0, Priority priority = Priority::normal)
+            : io::Task{ interval_ms, priority }
             , _handler{ handler }
             , _world_inst{ world_inst }
         { }
 
-        virtual bool ready() const override
+        virtual bool has_work() const override
         {
-            return io::Task::ready() && not _players_queue.empty();
+            return not _players_queue.empty();
+        }
+
+        virtual std::size_t num_of_pending_works() const override
+        {
+            return _players_queue.size();
         }
 
         virtual void before_scheduling() override
@@ -40,6 +53,8 @@ namespace game
 
         virtual void on_event_complete(io::IoEventHandler* completion_key, DWORD transferred_bytes) override
         {
+            TRACE_SPAN(name());
+
             std::invoke(_handler, _world_inst, _players_target);
 
             _players_target.clear();
@@ -59,21 +74,28 @@ namespace game
     public:
         using handler_type = void (game::World::* const)(const std::vector<game::Player*>&, const game::BlockHistory&);
 
-        BlockSyncTask(handler_type handler, game::World* world, std::size_t interval_ms = 0)
-            : io::Task{ interval_ms }
+        BlockSyncTask(handler_type handler, game::World* world, std::size_t interval_ms = 0, Priority priority = Priority::normal)
+            : io::Task{ interval_ms, priority }
             , _handler{ handler }
             , _world{ world }
         { }
 
-        virtual bool ready() const override
+        virtual bool has_work() const override
         {
-            return io::Task::ready() && (block_history.has_live_data() || not _level_wait_player_queue.empty());
+            return block_history.has_live_data() || not _level_wait_player_queue.empty() || has_dirty_region
+                || has_active_block || resync_requested.load(std::memory_order_relaxed);
+        }
+
+        virtual std::size_t num_of_pending_works() const override
+        {
+            return _level_wait_player_queue.size() + block_history.num_of_live_records();
         }
 
         virtual void before_scheduling() override
         {
             _level_wait_player_queue.swap(_level_wait_players);
             block_history.snapshot();
+            resync_requested.store(false, std::memory_order_relaxed);
 
             set_state(State::processing);
         }
@@ -88,8 +110,33 @@ namespace game
             return block_history.add_record(pos, block_id);
         }
 
+        bool push(const std::vector<game::BlockChange>& changes, std::size_t reserved_records = 0)
+        {
+            return block_history.add_records(changes, reserved_records);
+        }
+
+        // keep scheduling while some players have out of view changes to be synchronized.
+        void set_dirty_region(bool dirty)
+        {
+            has_dirty_region = dirty;
+        }
+
+        // keep scheduling while the block physics has active blocks.
+        void set_active_block(bool active)
+        {
+            has_active_block = active;
+        }
+
+        // request synchronization even if there are no new changes. (thread-safe)
+        void request_resync()
+        {
+            resync_requested.store(true, std::memory_order_relaxed);
+        }
+
         virtual void on_event_complete(io::IoEventHandler* completion_key, DWORD transferred_bytes) override
         {
+            TRACE_SPAN(name());
+
             std::invoke(_handler, _world, _level_wait_players, block_history);
 
             _level_wait_players.clear();
@@ -103,6 +150,10 @@ namespace game
 
         game::BlockHistory block_history;
 
+        bool has_dirty_region = false;
+        bool has_active_block = false;
+        std::atomic<bool> resync_requested{ false };
+
         std::vector<game::Player*> _level_wait_players;
         std::vector<game::Player*> _level_wait_player_queue;
     };
@@ -112,15 +163,15 @@ namespace game
     public:
         using handler_type = void (game::World::* const)(util::byte_view);
 
-        CommonChatTask(handler_type handler, game::World* world, std::size_t interval_ms = 0)
-            : io::Task{ interval_ms }
+        CommonChatTask(handler_type handler, game::World* world, std::size_t interval_ms = 0, Priority priority = Priority::normal)
+            : io::Task{ interval_ms, priority }
             , _handler{ handler }
             , _world{ world }
         { }
 
-        virtual bool ready() const override
+        virtual bool has_work() const override
         {
-            return io::Task::ready() && common_chat_history.has_live_data();
+            return common_chat_history.has_live_data();
         }
 
         virtual void before_scheduling() override
@@ -137,6 +188,8 @@ namespace game
 
         virtual void on_event_complete(io::IoEventHandler* completion_key, DWORD transferred_bytes) override
         {
+            TRACE_SPAN(name());
+
             std::invoke(_handler, _world, common_chat_history.get_snapshot_data());
             
             common_chat_history.clear_snapshot();
@@ -149,4 +202,107 @@ namespace game
 
         game::CommonChatHistory common_chat_history;
     };
+
+    // LevelTransfer is a level data transfer to the players who requested it before it finishes.
+    struct LevelTransfer : util::MpscQueueNode
+    {
+        bool fast_map = false;
+
+        // players join an unfinished transfer. (guarded by the level data cache lock of the world)
+        std::vector<net::ConnectionKey> players;
+
+        // copy of the block map at the request time.
+        std::unique_ptr<std::byte[]> block_data;
+        std::size_t block_data_size = 0;
+        std::size_t block_version = 0;
+
+        // region versions of the copy. players who join a stale transfer are synchronized from it.
+        game::RegionSyncState region_sync_state;
+
+        std::unique_ptr<net::PacketLevelDataChunk> level_packet;
+    };
+
+    class LevelTransferTask : public io::Task
+    {
+    public:
+        // returns true if the transfer is completed.
+        using handler_type = bool (game::World::* const)(game::LevelTransfer&);
+
+        LevelTransferTask(handler_type handler, game::World* world, std::size_t interval_ms = 0, Priority priority = Priority::bulk)
+            : io::Task{ interval_ms, priority }
+            , _handler{ handler }
+            , _world{ world }
+        { }
+
+        virtual bool has_work() const override
+        {
+            return num_of_transfers.load(std::memory_order_relaxed) != 0;
+        }
+
+        virtual std::size_t num_of_pending_works() const override
+        {
+            return num_of_transfers.load(std::memory_order_relaxed);
+        }
+
+        virtual std::size_t pending_since() const override
+        {
+            return _pending_since.load(std::memory_order_relaxed);
+        }
+
+        // slices are continued through the task shard without waiting for the next dispatch.
+        void set_task_shard(io::TaskScheduler& scheduler, io::IoCompletionPort& task_shard)
+        {
+            _scheduler = &scheduler;
+            _task_shard = &task_shard;
+        }
+
+        // thread-safe
+        void push(std::unique_ptr<game::LevelTransfer> transfer)
+        {
+            // counted before pushed, so the consumer never decrements the count below zero.
+            if (num_of_transfers.fetch_add(1, std::memory_order_relaxed) == 0)
+                _pending_since.store(util::coarse_monotonic_tick(), std::memory_order_relaxed);
+            transfer_queue.push(transfer.release());
+        }
+
+        // process a slice of the current transfer.
+        virtual void on_event_complete(io::IoEventHandler* completion_key, DWORD transferred_bytes) override
+        {
+            TRACE_SPAN(name());
+
+            if (not current_transfer)
+                current_transfer.reset(transfer_queue.pop()); // nullptr if the producer is not finished pushing yet.
+
+            if (current_transfer && std::invoke(_handler, _world, *current_transfer)) {
+                current_transfer.reset();
+                num_of_transfers.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            // post the next slice while other tasks are idle. (the task stays processing, so it isn't dispatched twice)
+            if (has_work() && _task_shard && not _scheduler->has_foreground_work()
+                && _task_shard->schedule_task(this))
+                return;
+
+            set_state(State::unused);
+        }
+
+        ~LevelTransferTask()
+        {
+            while (auto transfer = transfer_queue.pop())
+                delete transfer;
+        }
+
+    private:
+        handler_type _handler;
+        game::World* _world = nullptr;
+
+        io::TaskScheduler* _scheduler = nullptr;
+        io::IoCompletionPort* _task_shard = nullptr;
+
+        std::unique_ptr<game::LevelTransfer> current_transfer;
+
+        util::MpscQueue<game::LevelTransfer> transfer_queue;
+        std::atomic<std::size_t> num_of_transfers{ 0 };
+        std::atomic<std::size_t> _pending_since{ 0 };
+    };
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "net/connection_key.h"
+#include "util/noncopyable.h"
+#include "util/mpsc_queue.h"
+
+namespace game
+{
+    class World;
+
+    // a request of the player to move to another world.
+    struct WorldTransfer : util::MpscQueueNode
+    {
+        net::ConnectionKey connection_key;
+        game::World* target_world = nullptr;
+    };
+
+    // WorldTransferQueue collects world transfer requests from I/O threads,
+    // so that the source world moves players on its tick, as it handles state transitions.
+    // Note: multiple producers (any threads) and a single consumer (world tick).
+    class WorldTransferQueue : util::NonCopyable, util::NonMovable
+    {
+    public:
+        // thread-safe
+        void push(net::ConnectionKey connection_key, game::World* target_world)
+        {
+            auto transfer = new WorldTransfer();
+            transfer->connection_key = connection_key;
+            transfer->target_world = target_world;
+
+            queue.push(transfer);
+            _size.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // consumer only. the request is validated by the consumer, as the player may have changed meanwhile.
+        std::unique_ptr<WorldTransfer> pop()
+        {
+            std::unique_ptr<WorldTransfer> transfer{ queue.pop() };
+            if (transfer)
+                _size.fetch_sub(1, std::memory_order_relaxed);
+            return transfer;
+        }
+
+        std::size_t size() const
+        {
+            return _size.load(std::memory_order_relaxed);
+        }
+
+        ~WorldTransferQueue()
+        {
+            while (pop());
+        }
+
+    private:
+        util::MpscQueue<WorldTransfer> queue;
+        std::atomic<std::size_t> _size{ 0 };
+    };
+}
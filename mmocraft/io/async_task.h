@@ -3,12 +3,24 @@
 #include <coroutine>
 #include <optional>
 
+#include "io/coroutine_frame_pool.h"
+
 namespace io
 {
     template <typename T> struct AsyncTask;
 
     struct TaskPromiseBase
     {
+        static void* operator new(std::size_t size)
+        {
+            return allocate_coroutine_frame(size);
+        }
+
+        static void operator delete(void* frame, std::size_t size)
+        {
+            free_coroutine_frame(frame, size);
+        }
+
         std::suspend_always initial_suspend() { return {}; }
 
         struct FinalAwaitable
@@ -133,6 +145,16 @@ namespace io
     {
         struct promise_type
         {
+            static void* operator new(std::size_t size)
+            {
+                return allocate_coroutine_frame(size);
+            }
+
+            static void operator delete(void* frame, std::size_t size)
+            {
+                free_coroutine_frame(frame, size);
+            }
+
             DetachedTask get_return_object() { return {}; }
             std::suspend_never initial_suspend() { return {}; }
             std::suspend_never final_suspend() noexcept { return {}; }
@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "coroutine_frame_pool.h"
+
+#include <atomic>
+#include <bit>
+#include <new>
+
+#include "util/intrusive_stack.h"
+
+namespace
+{
+    constexpr std::size_t min_size_class_bits = 7; // 128 bytes
+    constexpr std::size_t num_of_size_classes = 6;  // up to 4KB
+
+    constexpr std::size_t max_cached_frames = 64;   // per thread and size class.
+    constexpr std::size_t depot_batch_size = max_cached_frames / 2;
+
+    std::size_t size_class_of(std::size_t size)
+    {
+        return size <= (std::size_t(1) << min_size_class_bits) ? 0 : std::bit_width(size - 1) - min_size_class_bits;
+    }
+
+    std::size_t size_of_class(std::size_t size_class)
+    {
+        return std::size_t(1) << (size_class + min_size_class_bits);
+    }
+
+    struct FreeFrame : util::IntrusiveStackNode
+    { };
+
+    using FrameStack = util::IntrusiveStack<FreeFrame>;
+
+    FrameStack depots[num_of_size_classes];
+
+    std::atomic<bool> is_pooling_enabled{ true };
+
+    struct ThreadFrameCache
+    {
+        struct FreeList
+        {
+            FreeFrame* head = nullptr;
+            std::size_t size = 0;
+        };
+
+        FreeList free_lists[num_of_size_classes];
+
+        // cached frames are handed over to other threads.
+        ~ThreadFrameCache()
+        {
+            for (std::size_t size_class = 0; size_class < num_of_size_classes; size_class++) {
+                auto first = free_lists[size_class].head;
+                if (not first)
+                    continue;
+
+                auto last = first;
+                while (auto next = FrameStack::next_of(last))
+                    last = next;
+
+                depots[size_class].push_chain(first, last);
+            }
+        }
+    };
+
+    thread_local ThreadFrameCache frame_cache;
+}
+
+namespace io
+{
+    void* allocate_coroutine_frame(std::size_t size)
+    {
+        auto size_class = size_class_of(size);
+        if (size_class >= num_of_size_classes)
+            return ::operator new(size);
+
+        if (is_pooling_enabled.load(std::memory_order_relaxed)) {
+            auto& free_list = frame_cache.free_lists[size_class];
+            if (auto frame = free_list.head) {
+                free_list.head = FrameStack::next_of(frame);
+                free_list.size--;
+                return frame;
+            }
+
+            if (auto frame = depots[size_class].pop())
+                return frame;
+        }
+
+        // frames are always allocated in the size of the class, so it can be pooled later.
+        return ::operator new(size_of_class(size_class));
+    }
+
+    void free_coroutine_frame(void* frame, std::size_t size)
+    {
+        auto size_class = size_class_of(size);
+        if (size_class >= num_of_size_classes || not is_pooling_enabled.load(std::memory_order_relaxed)) {
+            ::operator delete(frame);
+            return;
+        }
+
+        auto& free_list = frame_cache.free_lists[size_class];
+
+        auto free_frame = new (frame) FreeFrame;
+        free_frame->next.store(free_list.head, std::memory_order_relaxed);
+        free_list.head = free_frame;
+        free_list.size++;
+
+        if (free_list.size > max_cached_frames) {
+            auto first = free_list.head;
+            auto last = first;
+            for (std::size_t i = 1; i < depot_batch_size; i++)
+                last = FrameStack::next_of(last);
+
+            free_list.head = FrameStack::next_of(last);
+            free_list.size -= depot_batch_size;
+            depots[size_class].push_chain(first, last);
+        }
+    }
+
+    void set_coroutine_frame_pooling(bool enabled)
+    {
+        is_pooling_enabled.store(enabled, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+namespace io
+{
+    // Coroutine frames are allocated from power of two size classes. (128B ~ 4KB, larger frames use the global operator new)
+    // freed frames are cached in a thread-local free list, and the overflow is shared with other threads through a lock-free depot.
+    // (frames are often freed by another thread, e.g. resumed by a database callback)
+    // the memory is kept for reuse until the process exits.
+    void* allocate_coroutine_frame(std::size_t size);
+
+    void free_coroutine_frame(void* frame, std::size_t size);
+
+    // frames are allocated with the global operator new if disabled. (for benchmarks)
+    void set_coroutine_frame_pooling(bool enabled);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <coroutine>
+
+#include "io/io_event.h"
+#include "logging/logger.h"
+
+namespace io
+{
+    // ResumeEvent resumes a coroutine on the event thread which dequeues it.
+    // it is a member of an awaiter, so it lives in the coroutine frame until the coroutine is resumed.
+    struct ResumeEvent : io::Event
+    {
+        std::coroutine_handle<> coroutine;
+
+        virtual void on_event_complete(io::IoEventHandler*, DWORD) override
+        {
+            coroutine.resume();
+        }
+    };
+
+    // Executor runs completion events on its event threads. coroutines are resumed on them by posting ResumeEvent.
+    class Executor
+    {
+    public:
+        virtual ~Executor() = default;
+
+        // thread-safe.
+        virtual bool post(io::ResumeEvent&) = 0;
+
+        // the executor whose event loop runs on the current thread. (nullptr if none)
+        static Executor* current()
+        {
+            return current_executor;
+        }
+
+    protected:
+        // invoked by an event thread before running the event loop.
+        static void set_current(Executor* executor)
+        {
+            current_executor = executor;
+        }
+
+    private:
+        static inline thread_local Executor* current_executor = nullptr;
+    };
+
+    // "co_await io::resume_on(executor)" continues the coroutine on an event thread of the executor.
+    // it doesn't suspend if the current thread already runs the executor.
+    inline auto resume_on(io::Executor& executor)
+    {
+        struct ResumeOnAwaiter
+        {
+            io::Executor& executor;
+            io::ResumeEvent event;
+
+            bool await_ready() const noexcept
+            {
+                return Executor::current() == &executor;
+            }
+
+            bool await_suspend(std::coroutine_handle<> coroutine)
+            {
+                event.coroutine = coroutine;
+                if (executor.post(event))
+                    return true;
+
+                CONSOLE_LOG(error) << "Fail to post resumption. continue on the current thread.";
+                return false;
+            }
+
+            constexpr void await_resume() const noexcept { }
+        };
+
+        return ResumeOnAwaiter{ executor };
+    }
+}
@@ -6,6 +6,7 @@
 #include "net/packet.h"
 #include "util/deferred_call.h"
 #include "logging/logger.h"
+#include "metrics/metrics.h"
 
 namespace io
 {
@@ -155,6 +156,9 @@ namespace io
 
         rio->notify_completion();
 
+        static auto& rio_completions_per_dequeue = metrics::histogram("mmocraft_rio_completions_per_dequeue", "RIO completions dequeued at once.");
+        rio_completions_per_dequeue.record(num_dequeued_results);
+
         for (int i = 0; i < num_dequeued_results; i++) {
             auto io_event = reinterpret_cast<io::IoEvent*>(event_results[i].RequestContext);
             auto connection = reinterpret_cast<io::IoEventHandler*>(event_results[i].SocketContext);
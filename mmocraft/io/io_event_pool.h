@@ -11,18 +11,19 @@ namespace io
 {
     /// 오브젝트 풀을 통해 IoContext 구조체를 할당하는 클래스.
     /// 각각의 풀은 VirtualAlloc으로 연속된 공간에 할당된다.
+    /// 이벤트 스레드 간 bitmap 경합을 줄이기 위해 thread cache를 사용한다.
     class IoEventObjectPool
     {	
     public:
 
         IoEventObjectPool(std::size_t max_capacity)
             : accept_event_pool{ 1 }
-            , recv_event_pool{ max_capacity }
-            , recv_event_data_pool{ max_capacity + 1}
+            , recv_event_pool{ max_capacity, true }
+            , recv_event_data_pool{ max_capacity + 1, true }
 
-            , send_event_pool{ 2 * max_capacity }
-            , send_event_data_pool{ max_capacity }
-            , send_event_lockfree_data_pool{ max_capacity }
+            , send_event_pool{ 2 * max_capacity, true }
+            , send_event_data_pool{ max_capacity, true }
+            , send_event_lockfree_data_pool{ max_capacity, true }
         { }
 
         auto new_accept_event_data()
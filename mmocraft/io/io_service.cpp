@@ -5,10 +5,20 @@
 #include "net/socket.h"
 #include "logging/error.h"
 #include "logging/logger.h"
+#include "metrics/metrics.h"
+#include "util/time_util.h"
+#include "win/object_pool.h"
+#include "win/virtual_memory.h"
 
 namespace
 {
-
+    // event threads run on the numa node where pool memory is committed.
+    void bind_event_thread_to_numa_node()
+    {
+        auto numa_node = win::default_memory_options().numa_node;
+        if (numa_node != win::any_numa_node && not win::bind_current_thread_to_numa_node(numa_node))
+            CONSOLE_LOG(warn) << "Unable to bind event thread to numa node " << numa_node;
+    }
 }
 
 namespace io
@@ -35,6 +45,11 @@ namespace io
         return ::PostQueuedCompletionStatus(_handle.get(), 0, ULONG_PTR(task_handler_inst), &task->overlapped) != 0;
     }
 
+    bool IoCompletionPort::post(io::ResumeEvent& event)
+    {
+        return ::PostQueuedCompletionStatus(_handle.get(), 0, ULONG_PTR(0), &event.overlapped) != 0;
+    }
+
     int IoCompletionPort::dequeue_event_results(io::IoEventResult* event_results, std::size_t max_results)
     {
         ULONG num_of_results = 0;
@@ -65,11 +80,15 @@ namespace io
     {
         io::IoEventResult event_results[64];
 
+        Executor::set_current(this);
+
         while (true) {
             auto num_results = dequeue_event_results(event_results, std::size(event_results));
             if (num_results < 0)
                 return;
 
+            util::update_coarse_monotonic_tick();
+
             for (int i = 0; i < num_results; i++) {
                 if (event_results[i].lpOverlapped == nullptr) {
                     LOG(error) << "GetQueuedCompletionStatus() failed";
@@ -77,19 +96,11 @@ namespace io
                 }
 
                 auto transferred_bytes_or_signal = event_results[i].dwNumberOfBytesTransferred;
+                auto completion_key = reinterpret_cast<io::IoEventHandler*>(event_results[i].lpCompletionKey);
+                auto event = CONTAINING_RECORD(event_results[i].lpOverlapped, io::Event, overlapped);
 
                 try {
-                    if (transferred_bytes_or_signal == io::iocp_signal::task_completed) {
-                        auto task = reinterpret_cast<io::Task*>(event_results[i].lpOverlapped);
-
-                        //task->invoke_handler(event_results[i].lpCompletionKey);
-                    }
-                    else {
-                        auto io_event = CONTAINING_RECORD(event_results[i].lpOverlapped, io::IoEvent, overlapped);
-                        auto event_handler = reinterpret_cast<IoEventHandler*>(event_results[i].lpCompletionKey);
-
-                        //io_event->invoke_handler(*event_handler, transferred_bytes_or_signal, ERROR_SUCCESS);
-                    }
+                    event->on_event_complete(completion_key, transferred_bytes_or_signal);
                 }
                 catch (error::ErrorCode error_code) {
                     LOG(error) << "Exception was caught with " << error_code << ", buf supressed..";
@@ -104,7 +115,11 @@ namespace io
     void IoCompletionPort::spawn_event_thread()
     {
         event_threads.emplace_back(std::thread([](IoCompletionPort* io_service) {
+            bind_event_thread_to_numa_node();
             io_service->run_event_loop_forever();
+
+            // objects cached by this thread would be unavailable to other threads.
+            win::release_thread_caches();
             }, this
         ));
     }
@@ -279,17 +294,34 @@ namespace io
             &task->overlapped) != 0;
     }
 
+    bool RegisteredIO::post(io::ResumeEvent& event)
+    {
+        return ::PostQueuedCompletionStatus(completion_queue.iocp_handle(), 0, ULONG_PTR(0), &event.overlapped) != 0;
+    }
+
     void RegisteredIO::run_event_loop_forever()
     {
         io::IoEventResult event_results[max_dequeuing_io_event_results];
 
         auto& rio_api = net::rio_api();
 
+        static auto& num_of_events = metrics::counter("mmocraft_io_events_total", "Completion events handled by event threads.");
+        static auto& events_per_dequeue = metrics::histogram("mmocraft_io_events_per_dequeue", "Completion events dequeued at once.");
+        static auto& batch_duration = metrics::histogram("mmocraft_io_batch_duration_us", "Time to handle a batch of dequeued events.");
+
+        Executor::set_current(this);
+
         while (true) {
             auto num_results = dequeue_event_results(event_results, std::size(event_results));
             if (num_results < 0) // EOF
                 return;
 
+            util::update_coarse_monotonic_tick();
+
+            num_of_events.add(num_results);
+            events_per_dequeue.record(num_results);
+            metrics::ScopedTimer batch_timer{ batch_duration };
+
             for (int i = 0; i < num_results; i++) {
                 if (event_results[i].lpOverlapped == nullptr) {
                     CONSOLE_LOG(error) << "GetQueuedCompletionStatusEx() failed";
@@ -316,7 +348,11 @@ namespace io
     void RegisteredIO::spawn_event_thread()
     {
         event_threads.emplace_back(std::thread([](RegisteredIO* io_service) {
+            bind_event_thread_to_numa_node();
             io_service->run_event_loop_forever();
+
+            // objects cached by this thread would be unavailable to other threads.
+            win::release_thread_caches();
             }, this)
         );
     }
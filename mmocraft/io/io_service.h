@@ -4,6 +4,7 @@
 #include <thread>
 #include <memory>
 
+#include "io/executor.h"
 #include "io/task.h"
 #include "io/io_event.h"
 #include "logging/error.h"
@@ -31,7 +32,7 @@ namespace io
         virtual void spawn_event_thread() = 0;
     };
 
-    class IoCompletionPort : public IoServiceModel
+    class IoCompletionPort : public IoServiceModel, public io::Executor
     {
     public:
 
@@ -58,6 +59,8 @@ namespace io
 
         bool schedule_task(io::Task* task, void* task_handler_inst = nullptr);
 
+        bool post(io::ResumeEvent&) override;
+
         int dequeue_event_results(io::IoEventResult*, std::size_t max_results);
 
         void run_event_loop_forever(DWORD get_event_timeout_ms = INFINITE);
@@ -71,7 +74,7 @@ namespace io
         std::vector<std::thread> event_threads;
     };
 
-    class RegisteredIO final : public util::NonCopyable
+    class RegisteredIO final : public util::NonCopyable, public io::Executor
     {
     public:
         static constexpr std::size_t max_dequeuing_io_event_results = 128;
@@ -106,6 +109,8 @@ namespace io
 
         bool schedule_task(io::Task* task, void* task_handler = nullptr);
 
+        bool post(io::ResumeEvent&) override;
+
         void spawn_event_thread();
 
         void run_event_loop_forever();
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <coroutine>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "util/noncopyable.h"
+
+namespace io
+{
+    // SingleFlight lets concurrent lookups of the same key share one in-flight operation. (request coalescing)
+    //
+    //   if (auto shared_result = co_await flights.join(key))
+    //       use(*shared_result);                // a follower, resumed with the result of the leader.
+    //   else {
+    //       auto flight = flights.lead(key, fallback_result);
+    //       auto result = co_await lookup(key);  // the leader, must complete the flight.
+    //       flight.complete(result);
+    //   }
+    //
+    // followers are resumed by the thread which completes the flight.
+    // if the leader throws or its frame is destroyed before completing, the flight is completed with the fallback result.
+    template <typename Result>
+    class SingleFlight : util::NonCopyable, util::NonMovable
+    {
+        struct Follower
+        {
+            std::coroutine_handle<> coroutine;
+            std::optional<Result> result;
+        };
+
+    public:
+        class Leader : util::NonCopyable, util::NonMovable
+        {
+        public:
+            Leader(SingleFlight& flights, std::string_view key, Result fallback_result)
+                : _flights{ &flights }
+                , _key{ key }
+                , _fallback_result{ std::move(fallback_result) }
+            { }
+
+            ~Leader()
+            {
+                if (_flights)
+                    _flights->complete(_key, _fallback_result);
+            }
+
+            void complete(const Result& result)
+            {
+                if (auto flights = std::exchange(_flights, nullptr))
+                    flights->complete(_key, result);
+            }
+
+        private:
+            SingleFlight* _flights;
+            std::string _key;
+            Result _fallback_result;
+        };
+
+        auto join(std::string_view key)
+        {
+            struct JoinAwaiter
+            {
+                SingleFlight& flights;
+                std::string_view key;
+                Follower follower;
+
+                constexpr bool await_ready() const noexcept
+                {
+                    return false;
+                }
+
+                // continues without suspension if the coroutine leads the flight.
+                bool await_suspend(std::coroutine_handle<> coroutine)
+                {
+                    std::lock_guard<std::mutex> lock(flights.flight_lock);
+
+                    auto [it, is_leader] = flights.flights.try_emplace(std::string(key));
+                    if (is_leader)
+                        return false;
+
+                    follower.coroutine = coroutine;
+                    it->second.push_back(&follower);
+                    return true;
+                }
+
+                std::optional<Result> await_resume()
+                {
+                    return std::move(follower.result);
+                }
+            };
+
+            return JoinAwaiter{ *this, key };
+        }
+
+        // taken by the leader after join(). (not to leave the flight uncompleted)
+        Leader lead(std::string_view key, Result fallback_result)
+        {
+            return Leader{ *this, key, std::move(fallback_result) };
+        }
+
+        // invoked by the leader. resumes followers which joined the flight.
+        void complete(std::string_view key, const Result& result)
+        {
+            std::vector<Follower*> followers;
+            {
+                std::lock_guard<std::mutex> lock(flight_lock);
+                auto it = flights.find(std::string(key));
+                if (it == flights.end())
+                    return;
+
+                followers = std::move(it->second);
+                flights.erase(it);
+            }
+
+            for (auto follower : followers) {
+                follower->result = result;
+                follower->coroutine.resume();
+            }
+        }
+
+        std::size_t num_of_flights() const
+        {
+            std::lock_guard<std::mutex> lock(flight_lock);
+            return flights.size();
+        }
+
+    private:
+        mutable std::mutex flight_lock;
+        std::unordered_map<std::string, std::vector<Follower*>> flights;
+    };
+}
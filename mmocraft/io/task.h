@@ -3,6 +3,7 @@
 #include "io/io_event.h"
 #include "net/connection_key.h"
 #include "logging/logger.h"
+#include "metrics/trace.h"
 #include "util/time_util.h"
 
 namespace io
@@ -17,7 +18,18 @@ namespace io
             failed,
         };
 
-        Task(std::size_t interval) : interval_ms{ interval }
+        // tasks with higher priority are dispatched first.
+        // bulk tasks must be splited into short slices not to delay other tasks.
+        enum class Priority
+        {
+            critical,
+            normal,
+            bulk,
+        };
+
+        Task(std::size_t interval, Priority priority = Priority::normal)
+            : interval_ms{ interval }
+            , _priority{ priority }
         { }
 
         virtual ~Task() = default;
@@ -27,15 +39,61 @@ namespace io
             return _state;
         }
 
-        virtual bool ready() const
+        Priority priority() const
+        {
+            return _priority;
+        }
+
+        // the name given by the scheduler. (used by trace spans)
+        const char* name() const
+        {
+            return _name;
+        }
+
+        void set_name(const char* name)
+        {
+            _name = name;
+        }
+
+        // check whether the task has something to process.
+        virtual bool has_work() const
+        {
+            return true;
+        }
+
+        // number of queued works. (for metrics, 0 if the task doesn't have a queue)
+        virtual std::size_t num_of_pending_works() const
+        {
+            return 0;
+        }
+
+        // the tick when the task got work while it had none. (0 if not tracked)
+        // the scheduler measures lateness from it instead of the first time the task is observed due.
+        virtual std::size_t pending_since() const
+        {
+            return 0;
+        }
+
+        std::size_t cooldown_tick() const
         {
-            return _state == State::unused && cooldown_at < util::current_monotonic_tick();
+            return cooldown_at;
+        }
+
+        // the interval has elapsed and there is work. (regardless of the task is processing or not)
+        bool is_due(std::size_t now) const
+        {
+            return cooldown_at < now && has_work();
+        }
+
+        bool ready() const
+        {
+            return _state == State::unused && is_due(util::coarse_monotonic_tick());
         }
 
         void set_state(State state)
         {
             if (state == State::processing)
-                cooldown_at = interval_ms + util::current_monotonic_tick();
+                cooldown_at = interval_ms + util::coarse_monotonic_tick();
 
             _state = state;
         }
@@ -55,6 +113,8 @@ namespace io
         State _state = State::unused;
         std::size_t interval_ms = 0;
         std::size_t cooldown_at = 0;
+        Priority _priority = Priority::normal;
+        const char* _name = "task";
     };
     
     template <typename HandlerClass>
@@ -63,14 +123,16 @@ namespace io
     public:
         using handler_type = void (HandlerClass::* const)();
 
-        SimpleTask(handler_type handler, HandlerClass* handler_inst, std::size_t interval_ms = 0)
-            : io::Task{ interval_ms }
+        SimpleTask(handler_type handler, HandlerClass* handler_inst, std::size_t interval_ms = 0, Priority priority = Priority::normal)
+            : io::Task{ interval_ms, priority }
             , _handler{ handler }
             , _handler_inst{ handler_inst }
         { }
 
         virtual void on_event_complete(io::IoEventHandler* completion_key, DWORD transferred_bytes) override
         {
+            TRACE_SPAN(name());
+
             std::invoke(_handler,
                 _handler_inst ? *_handler_inst : *reinterpret_cast<HandlerClass*>(completion_key)
             );
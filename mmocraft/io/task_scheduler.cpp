@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "task_scheduler.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "logging/logger.h"
+#include "util/time_util.h"
+
+namespace io
+{
+    void TaskScheduler::add(io::Task* task, const char* name)
+    {
+        task->set_name(name);
+
+        auto labels = "{task=\"" + std::string(name) + '"' + (_metric_labels.empty() ? "" : ',' + _metric_labels) + '}';
+
+        entries.push_back({
+            .task = task,
+            .name = name,
+            .runs_metric = &metrics::counter("mmocraft_task_runs_total" + labels, "Dispatched runs of the task."),
+            .lateness_metric = &metrics::histogram("mmocraft_task_lateness_ms" + labels, "Delay from due to dispatch of the task."),
+            .queue_depth_metric = &metrics::histogram("mmocraft_task_queue_depth" + labels, "Pending works of the task at dispatch."),
+        });
+        candidates.reserve(entries.size());
+    }
+
+    void TaskScheduler::dispatch(io::IoCompletionPort& task_scheduler)
+    {
+        const auto now = util::coarse_monotonic_tick();
+
+        candidates.clear();
+        bool is_critical_task_overrunning = false;
+
+        for (auto& entry : entries) {
+            auto task = entry.task;
+
+            if (not task->is_due(now)) {
+                entry.due_since = 0;
+                continue;
+            }
+
+            // due since the work was enqueued, or the interval elapsed after that.
+            if (entry.due_since == 0) {
+                auto pending_since = task->pending_since();
+                entry.due_since = pending_since ? std::min(now, std::max(pending_since, task->cooldown_tick())) : now;
+            }
+
+            // the previous instance is still running after the interval.
+            if (task->status() != io::Task::State::unused) {
+                if (task->priority() == io::Task::Priority::critical)
+                    is_critical_task_overrunning = true;
+                continue;
+            }
+
+            candidates.push_back(&entry);
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b) {
+            return a->task->priority() != b->task->priority()
+                ? a->task->priority() < b->task->priority()
+                : a->due_since < b->due_since;
+        });
+
+        for (auto entry : candidates) {
+            // yield event threads to the critical tasks.
+            if (entry->task->priority() == io::Task::Priority::bulk && is_critical_task_overrunning)
+                continue;
+
+            const auto num_of_pending_works = entry->task->num_of_pending_works();
+
+            if (not task_scheduler.schedule_task(entry->task))
+                continue;
+
+            auto lateness = now - entry->due_since;
+            entry->runs_metric->add();
+            entry->lateness_metric->record(lateness);
+            entry->queue_depth_metric->record(num_of_pending_works);
+            auto& stats = entry->stats;
+
+            stats.num_of_runs++;
+            if (lateness) {
+                stats.num_of_late_runs++;
+                stats.total_lateness_ms += lateness;
+                stats.max_lateness_ms = std::max(stats.max_lateness_ms, lateness);
+            }
+
+            entry->due_since = 0;
+        }
+    }
+
+    bool TaskScheduler::has_foreground_work() const
+    {
+        const auto now = util::coarse_monotonic_tick();
+
+        return std::any_of(entries.begin(), entries.end(), [now](const Entry& entry) {
+            auto task = entry.task;
+            return task->priority() != io::Task::Priority::bulk
+                && (task->status() != io::Task::State::unused || task->is_due(now));
+        });
+    }
+
+    const TaskStatistics& TaskScheduler::statistics(const io::Task* task) const
+    {
+        auto it = std::find_if(entries.begin(), entries.end(), [task](const Entry& entry) {
+            return entry.task == task;
+        });
+
+        assert(it != entries.end());
+        return it->stats;
+    }
+
+    void TaskScheduler::log_statistics() const
+    {
+        for (const auto& entry : entries) {
+            auto& stats = entry.stats;
+            LOG(info) << "Task " << entry.name << ": runs=" << stats.num_of_runs
+                << " late=" << stats.num_of_late_runs
+                << " mean_lateness=" << (stats.num_of_late_runs ? stats.total_lateness_ms / stats.num_of_late_runs : 0) << "ms"
+                << " max_lateness=" << stats.max_lateness_ms << "ms";
+        }
+    }
+
+    void TaskScheduler::reset_statistics()
+    {
+        for (auto& entry : entries)
+            entry.stats = TaskStatistics{};
+    }
+}
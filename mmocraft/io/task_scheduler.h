@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "io/task.h"
+#include "io/io_service.h"
+#include "metrics/metrics.h"
+#include "util/noncopyable.h"
+
+namespace io
+{
+    struct TaskStatistics
+    {
+        std::size_t num_of_runs = 0;
+        std::size_t num_of_late_runs = 0;
+        std::size_t total_lateness_ms = 0;
+        std::size_t max_lateness_ms = 0;
+    };
+
+    // TaskScheduler dispatches due tasks in order of priority, then how long they have waited.
+    // 
+    // Note: running tasks can't be preempted. instead, bulk tasks are splited into slices
+    //       and are not dispatched while critical tasks are overrunning.
+    class TaskScheduler : util::NonCopyable, util::NonMovable
+    {
+    public:
+        // metric_labels are attached to metrics of tasks. e.g. world="0"
+        TaskScheduler(std::string_view metric_labels = "")
+            : _metric_labels{ metric_labels }
+        { }
+
+        void add(io::Task*, const char* name);
+
+        // must be invoked by a single thread (server tick).
+        void dispatch(io::IoCompletionPort&);
+
+        // check whether critical or normal tasks are due or running. (may be invoked by event threads)
+        // bulk tasks continue their next slice right away only while it is false.
+        bool has_foreground_work() const;
+
+        const TaskStatistics& statistics(const io::Task*) const;
+
+        void log_statistics() const;
+
+        void reset_statistics();
+
+    private:
+        struct Entry
+        {
+            io::Task* task = nullptr;
+            const char* name = nullptr;
+
+            // when the task became due. (0 if not due)
+            std::size_t due_since = 0;
+
+            TaskStatistics stats;
+
+            metrics::Counter* runs_metric = nullptr;
+            metrics::Histogram* lateness_metric = nullptr;
+            metrics::Histogram* queue_depth_metric = nullptr;
+        };
+
+        std::string _metric_labels;
+
+        std::vector<Entry> entries;
+
+        std::vector<Entry*> candidates;
+    };
+}
@@ -33,6 +33,7 @@ namespace
         // Packet handling
         arr[error::code::packet::handle_error]    = "handle_error";
         arr[error::code::packet::handle_chat_message_error] = "Couldn't handle chat message. Please try reconnect.";
+        arr[error::code::packet::duplicate_handshake] = "Handshake is already done";
 
         // Packet result
         arr[error::code::packet::player_login_fail] = "Incorrect username or password";
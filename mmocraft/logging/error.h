@@ -40,6 +40,7 @@ namespace error
             constexpr ErrorCode handle_error = 3201;
             constexpr ErrorCode handle_suucess = 3202;
             constexpr ErrorCode handle_chat_message_error = 3203;
+            constexpr ErrorCode duplicate_handshake = 3204;
 
             constexpr ErrorCode player_login_fail = 3301;
             constexpr ErrorCode player_not_exist = 3302;
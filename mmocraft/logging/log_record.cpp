@@ -0,0 +1,213 @@
+#include "pch.h"
+#include "log_record.h"
+
+#include <charconv>
+#include <cstring>
+#include <ctime>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    class ArgReader
+    {
+    public:
+        ArgReader(const std::byte* data, std::size_t size)
+            : _data{ data }
+            , _end{ data + size }
+        { }
+
+        bool empty() const
+        {
+            return _data == _end;
+        }
+
+        template <typename T>
+        bool read(T& value)
+        {
+            if (std::size_t(_end - _data) < sizeof(T))
+                return false;
+            std::memcpy(&value, _data, sizeof(T));
+            _data += sizeof(T);
+            return true;
+        }
+
+        bool read(std::string_view& value)
+        {
+            std::uint16_t length = 0;
+            if (not read(length) || std::size_t(_end - _data) < length)
+                return false;
+            value = { reinterpret_cast<const char*>(_data), length };
+            _data += length;
+            return true;
+        }
+
+    private:
+        const std::byte* _data;
+        const std::byte* _end;
+    };
+
+    template <typename T>
+    void append_number(T value, std::string& out)
+    {
+        char buf[32];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, end);
+    }
+
+    void append_timestamp(std::uint64_t timestamp_us, std::string& out)
+    {
+        // records are mostly in the same second, so the date and time part is cached.
+        thread_local std::time_t cached_seconds = -1;
+        thread_local char cached_date_time[32];
+        thread_local std::size_t cached_length = 0;
+
+        auto seconds = std::time_t(timestamp_us / 1'000'000);
+        if (seconds != cached_seconds) {
+            std::tm time{};
+#ifdef _WIN32
+            ::gmtime_s(&time, &seconds);
+#else
+            ::gmtime_r(&seconds, &time);
+#endif
+            cached_length = std::strftime(cached_date_time, sizeof(cached_date_time), "%Y-%m-%d %H:%M:%S", &time);
+            cached_seconds = seconds;
+        }
+        out.append(cached_date_time, cached_length);
+
+        auto milliseconds = unsigned(timestamp_us / 1000 % 1000);
+        const char millisecond_digits[] = { '.', char('0' + milliseconds / 100), char('0' + milliseconds / 10 % 10), char('0' + milliseconds % 10) };
+        out.append(millisecond_digits, sizeof(millisecond_digits));
+    }
+
+    bool append_arg(ArgReader& reader, std::string& out)
+    {
+        logging::arg_type type;
+        if (not reader.read(type))
+            return false;
+
+        switch (type) {
+        case logging::arg_type::boolean:
+        {
+            bool value;
+            if (not reader.read(value)) return false;
+            out.append(value ? "1" : "0");
+            return true;
+        }
+        case logging::arg_type::character:
+        {
+            char value;
+            if (not reader.read(value)) return false;
+            out.push_back(value);
+            return true;
+        }
+        case logging::arg_type::int64:
+        {
+            std::int64_t value;
+            if (not reader.read(value)) return false;
+            append_number(value, out);
+            return true;
+        }
+        case logging::arg_type::uint64:
+        {
+            std::uint64_t value;
+            if (not reader.read(value)) return false;
+            append_number(value, out);
+            return true;
+        }
+        case logging::arg_type::float64:
+        {
+            double value;
+            if (not reader.read(value)) return false;
+            append_number(value, out);
+            return true;
+        }
+        case logging::arg_type::string:
+        {
+            std::string_view value;
+            if (not reader.read(value)) return false;
+            out.append(value);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+}
+
+namespace logging
+{
+    const char* level_prefix(std::uint8_t level)
+    {
+        static const char* prefixes[log_level::count] = { "[Debug]", "[Info]", "[Warn]", "[Error]", "[Fatal]" };
+        return level < log_level::count ? prefixes[level] : "[Unknown]";
+    }
+
+    void format_record(const RecordHeader& header, std::string_view source_file, const std::byte* args, std::size_t args_size, std::string& out)
+    {
+        out.append(level_prefix(header.level));
+        out.push_back(' ');
+        append_timestamp(header.timestamp_us, out);
+        out.append(" #");
+        append_number(header.thread_id, out);
+        out.push_back(' ');
+        out.append(source_file);
+        out.push_back('(');
+        append_number(header.line, out);
+        out.push_back(':');
+        append_number(header.column, out);
+        out.append(") : ");
+
+        ArgReader reader{ args, args_size };
+        while (not reader.empty()) {
+            if (not append_arg(reader, out)) {
+                out.append("<corrupted record>");
+                break;
+            }
+        }
+    }
+
+    bool decode_log_file(std::istream& binary_log, std::ostream& text_log)
+    {
+        char magic[binary_log_magic.size()];
+        if (not binary_log.read(magic, sizeof(magic)) || binary_log_magic != std::string_view(magic, sizeof(magic)))
+            return false;
+
+        std::unordered_map<std::uint64_t, std::string> source_files;
+        std::vector<std::byte> args;
+        std::string line;
+
+        RecordHeader header;
+        while (binary_log.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            if (header.size < sizeof(header) || header.size > max_record_size)
+                return false;
+
+            args.resize(aligned_record_size(header.size) - sizeof(header));
+            if (not binary_log.read(reinterpret_cast<char*>(args.data()), args.size()))
+                return false;
+
+            auto args_size = header.size - sizeof(header);
+
+            if (header.level == source_file_record) {
+                ArgReader reader{ args.data(), args_size };
+                std::uint64_t source_file = 0;
+                std::string_view file_name;
+                if (reader.read(source_file) && reader.read(file_name))
+                    source_files[source_file] = file_name;
+                continue;
+            }
+
+            if (header.level == padding_record)
+                continue;
+
+            auto found = source_files.find(header.source_file);
+            line.clear();
+            format_record(header, found != source_files.end() ? found->second : "?", args.data(), args_size, line);
+            text_log << line << '\n';
+        }
+
+        return true;
+    }
+}
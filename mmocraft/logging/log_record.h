@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace logging
+{
+    namespace log_level
+    {
+        enum value
+        {
+            debug,
+            info,
+            warn,
+            error,
+            fatal,
+
+            count,
+        };
+    }
+
+    enum class log_sink : std::uint8_t
+    {
+        file,
+        console,
+    };
+
+    enum class arg_type : std::uint8_t
+    {
+        boolean,
+        character,
+        int64,
+        uint64,
+        float64,
+        string,     // uint16 length + characters
+    };
+
+    // A log record is a header followed by binary arguments, which are formatted by the log thread.
+    // The same layout is written to binary log files, so the offline decoder shares the formatter.
+    struct RecordHeader
+    {
+        std::uint32_t size;         // including the header.
+        std::uint8_t level;
+        log_sink sink;
+        std::uint16_t column;
+        std::uint32_t line;
+        std::uint32_t thread_id;
+        std::uint64_t timestamp_us; // since the unix epoch.
+        std::uint64_t source_file;  // address of the source file name. (process-local id)
+    };
+
+    static_assert(sizeof(RecordHeader) == 32);
+
+    // special levels of records which are not log lines.
+    constexpr std::uint8_t padding_record = 0xFF;           // skip to the end of the ring.
+    constexpr std::uint8_t source_file_record = 0xFE;       // binary file only: source_file id -> file name.
+
+    constexpr std::size_t max_record_size = 512;            // longer messages are truncated.
+    constexpr std::size_t record_alignment = 8;
+
+    constexpr std::string_view binary_log_magic{ "MCLOG\x01\0\0", 8 };
+
+    constexpr std::size_t aligned_record_size(std::size_t size)
+    {
+        return (size + record_alignment - 1) & ~(record_alignment - 1);
+    }
+
+    const char* level_prefix(std::uint8_t level);
+
+    // append a text line of the record. (without the line break)
+    void format_record(const RecordHeader&, std::string_view source_file, const std::byte* args, std::size_t args_size, std::string& out);
+
+    // convert a binary log file to text. returns false if the stream is not a binary log.
+    bool decode_log_file(std::istream& binary_log, std::ostream& text_log);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "logging/log_record.h"
+#include "util/noncopyable.h"
+
+namespace logging
+{
+    // LogRing is a single-producer single-consumer ring of log records.
+    // Every thread writes into its own ring, and the log thread consumes all rings.
+    // Records are contiguous in the ring. a padding record fills the end of the ring if a record doesn't fit.
+    class LogRing : util::NonCopyable, util::NonMovable
+    {
+    public:
+        // capacity must be a power of two.
+        explicit LogRing(std::size_t capacity)
+            : _capacity{ capacity }
+            , _buffer{ new std::byte[capacity] }
+        { }
+
+        // producer only. returns false if the ring is full.
+        bool try_write(const std::byte* record, std::size_t size)
+        {
+            const auto record_size = aligned_record_size(size);
+            auto write_pos = _write_pos.load(std::memory_order_relaxed);
+            const auto read_pos = _read_pos.load(std::memory_order_acquire);
+
+            auto offset = write_pos & (_capacity - 1);
+            const auto tail_room = _capacity - offset;
+            const auto required = record_size + (tail_room < record_size ? tail_room : 0);
+            if (_capacity - (write_pos - read_pos) < required)
+                return false;
+
+            if (tail_room < record_size) {
+                RecordHeader padding{ .size = std::uint32_t(tail_room), .level = padding_record };
+                std::memcpy(&_buffer[offset], &padding, sizeof(padding.size) + sizeof(padding.level));
+                write_pos += tail_room;
+                offset = 0;
+            }
+
+            std::memcpy(&_buffer[offset], record, size);
+            _write_pos.store(write_pos + record_size, std::memory_order_release);
+            return true;
+        }
+
+        // consumer only. invoke handler(const RecordHeader&, const std::byte* record) for each record.
+        template <typename Handler>
+        std::size_t consume(Handler&& handler)
+        {
+            auto read_pos = _read_pos.load(std::memory_order_relaxed);
+            const auto write_pos = _write_pos.load(std::memory_order_acquire);
+
+            std::size_t num_of_records = 0;
+            while (read_pos != write_pos) {
+                auto record = &_buffer[read_pos & (_capacity - 1)];
+
+                RecordHeader header;
+                std::memcpy(&header, record, sizeof(header.size) + sizeof(header.level));
+                if (header.level != padding_record) {
+                    std::memcpy(&header, record, sizeof(header));
+                    handler(header, record);
+                    num_of_records++;
+                }
+
+                read_pos += aligned_record_size(header.size);
+            }
+
+            _read_pos.store(read_pos, std::memory_order_release);
+            return num_of_records;
+        }
+
+        std::size_t capacity() const
+        {
+            return _capacity;
+        }
+
+        // approximate number of bytes waiting for the consumer.
+        std::size_t size() const
+        {
+            return std::size_t(_write_pos.load(std::memory_order_relaxed) - _read_pos.load(std::memory_order_relaxed));
+        }
+
+        bool empty() const
+        {
+            return _read_pos.load(std::memory_order_relaxed) == _write_pos.load(std::memory_order_acquire);
+        }
+
+        // set when the producer thread exits. the ring is removed after drained.
+        void detach()
+        {
+            _detached.store(true, std::memory_order_release);
+        }
+
+        bool is_detached() const
+        {
+            return _detached.load(std::memory_order_acquire);
+        }
+
+    private:
+        const std::size_t _capacity;
+        std::unique_ptr<std::byte[]> _buffer;
+
+        alignas(64) std::atomic<std::uint64_t> _write_pos{ 0 };
+        alignas(64) std::atomic<std::uint64_t> _read_pos{ 0 };
+        std::atomic<bool> _detached{ false };
+    };
+}
@@ -1,21 +1,310 @@
 #include "pch.h"
 #include "logger.h"
 
-#include <map>
+#include <chrono>
+#include <condition_variable>
 #include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "logging/error.h"
+#include "logging/log_ring.h"
 #include "system_initializer.h"
 
 namespace fs = std::filesystem;
 
 namespace
 {
-    std::ofstream general_log_stream;
-    std::ofstream error_log_stream;
+    constexpr std::size_t thread_ring_size = 256 * 1024;
+
+    constexpr auto idle_flush_interval = std::chrono::milliseconds(10);
+
+    std::uint64_t current_timestamp_us()
+    {
+        return std::uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    std::uint32_t current_thread_id()
+    {
+        static std::atomic<std::uint32_t> num_of_threads{ 0 };
+        thread_local const std::uint32_t thread_id = ++num_of_threads;
+        return thread_id;
+    }
+
+    std::string_view source_file_name(std::string_view path)
+    {
+        auto pos = path.find_last_of("/\\");
+        return pos == std::string_view::npos ? path : path.substr(pos + 1);
+    }
+
+    // LogBackend owns the log thread, which formats records of all thread rings and writes them in batches.
+    class LogBackend
+    {
+    public:
+        ~LogBackend()
+        {
+            stop();
+        }
+
+        bool is_running() const
+        {
+            return _running.load(std::memory_order_acquire);
+        }
+
+        void start(std::string_view log_dir, std::string_view log_filename, bool binary_format)
+        {
+            if (is_running())
+                return;
+
+            if (not fs::exists(log_dir))
+                fs::create_directories(log_dir);
+
+            auto open_mode = binary_format ? std::ofstream::out | std::ofstream::binary : std::ofstream::out;
+            auto general_log_path = fs::path(log_dir) / log_filename;
+            auto error_log_path = fs::path(log_dir) / ("error_" + std::string(log_filename));
+
+            general_log_stream.open(general_log_path, open_mode);
+            if (not general_log_stream.is_open())
+                CONSOLE_LOG(fatal) << "Fail to open file: " << general_log_path;
+
+            error_log_stream.open(error_log_path, open_mode);
+            if (not error_log_stream.is_open())
+                CONSOLE_LOG(fatal) << "Fail to open file: " << error_log_path;
+
+            // the files are truncated, so file names have to be written again.
+            _emitted_source_files.clear();
+
+            _binary_format = binary_format;
+            if (_binary_format) {
+                general_log_stream.write(logging::binary_log_magic.data(), logging::binary_log_magic.size());
+                error_log_stream.write(logging::binary_log_magic.data(), logging::binary_log_magic.size());
+            }
+
+            _running.store(true, std::memory_order_release);
+            _log_thread = std::thread([this] { run(); });
+        }
+
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_wakeup_lock);
+                if (not _running.exchange(false, std::memory_order_acq_rel))
+                    return;
+            }
+            _wakeup.notify_one();
+
+            if (_log_thread.joinable())
+                _log_thread.join();
+
+            general_log_stream.close();
+            error_log_stream.close();
+        }
+
+        // producer side.
+        void write(const std::byte* record, std::size_t size)
+        {
+            auto& ring = thread_ring();
+            const auto level = reinterpret_cast<const logging::RecordHeader*>(record)->level;
+
+            while (not ring.try_write(record, size)) {
+                // errors are never dropped. wait until the log thread makes room.
+                if (level < logging::log_level::error || not is_running()) {
+                    _num_of_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                _wakeup.notify_one();
+                std::this_thread::yield();
+            }
+
+            // don't wait for the idle interval if the ring is filling up.
+            if (level >= logging::log_level::error || ring.size() > ring.capacity() / 2)
+                _wakeup.notify_one();
+        }
+
+        // used before the log thread starts or after it stops.
+        void write_synchronously(const std::byte* record, std::size_t size)
+        {
+            auto& header = *reinterpret_cast<const logging::RecordHeader*>(record);
+
+            std::string line;
+            logging::format_record(header, source_file_name(reinterpret_cast<const char*>(header.source_file)),
+                record + sizeof(header), size - sizeof(header), line);
+
+            std::lock_guard<std::mutex> lock(_sync_write_lock);
+            std::cout << line << std::endl;
+        }
+
+        std::size_t num_of_dropped() const
+        {
+            return _num_of_dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct RingHandle
+        {
+            std::shared_ptr<logging::LogRing> ring;
+
+            ~RingHandle()
+            {
+                if (ring)
+                    ring->detach();
+            }
+        };
+
+        logging::LogRing& thread_ring()
+        {
+            thread_local RingHandle handle;
+            if (not handle.ring) {
+                handle.ring = std::make_shared<logging::LogRing>(thread_ring_size);
 
-    logging::LogLevelDescriptor log_level_descriptors[logging::log_level::value::count];
+                std::lock_guard<std::mutex> lock(_rings_lock);
+                _rings.push_back(handle.ring);
+            }
+            return *handle.ring;
+        }
+
+        void run()
+        {
+            while (is_running()) {
+                if (drain() == 0) {
+                    std::unique_lock<std::mutex> lock(_wakeup_lock);
+                    _wakeup.wait_for(lock, idle_flush_interval);
+                }
+            }
+            drain();
+        }
+
+        std::size_t drain()
+        {
+            std::vector<std::shared_ptr<logging::LogRing>> rings;
+            {
+                std::lock_guard<std::mutex> lock(_rings_lock);
+                // rings of exited threads are removed after drained.
+                std::erase_if(_rings, [](const auto& ring) { return ring->is_detached() && ring->empty(); });
+                rings = _rings;
+            }
+
+            std::size_t num_of_records = 0;
+            for (auto& ring : rings) {
+                num_of_records += ring->consume([this](const logging::RecordHeader& header, const std::byte* record) {
+                    if (_binary_format && header.sink == logging::log_sink::file)
+                        append_binary(header, record);
+                    else
+                        append_text(header, record);
+                });
+            }
+
+            if (auto num_of_dropped = _num_of_dropped.load(std::memory_order_relaxed); num_of_dropped != _num_of_reported_drops) {
+                _console_buffer.append("[Warn] ").append(std::to_string(num_of_dropped - _num_of_reported_drops))
+                               .append(" log records were dropped\n");
+                _num_of_reported_drops = num_of_dropped;
+            }
+
+            flush_buffer(_general_buffer, general_log_stream);
+            flush_buffer(_error_buffer, error_log_stream);
+            flush_buffer(_console_buffer, std::cout);
+
+            return num_of_records;
+        }
+
+        std::string& buffer_of(const logging::RecordHeader& header)
+        {
+            if (header.sink == logging::log_sink::console)
+                return _console_buffer;
+            return header.level >= logging::log_level::error ? _error_buffer : _general_buffer;
+        }
+
+        void append_text(const logging::RecordHeader& header, const std::byte* record)
+        {
+            auto& source_file = _source_files[header.source_file];
+            if (source_file.empty())
+                source_file = source_file_name(reinterpret_cast<const char*>(header.source_file));
+
+            auto& buffer = buffer_of(header);
+            logging::format_record(header, source_file, record + sizeof(header), header.size - sizeof(header), buffer);
+            buffer.push_back('\n');
+        }
+
+        void append_binary(const logging::RecordHeader& header, const std::byte* record)
+        {
+            auto& buffer = buffer_of(header);
+
+            // the file name is written once per file, before the first record referring it.
+            // (tracked apart from the name cache, which text records fill as well)
+            if (_emitted_source_files.insert(header.source_file).second) {
+                auto& source_file = _source_files[header.source_file];
+                if (source_file.empty())
+                    source_file = source_file_name(reinterpret_cast<const char*>(header.source_file));
+
+                append_source_file_record(header.source_file, source_file, _general_buffer);
+                append_source_file_record(header.source_file, source_file, _error_buffer);
+            }
+
+            buffer.append(reinterpret_cast<const char*>(record), logging::aligned_record_size(header.size));
+        }
+
+        static void append_source_file_record(std::uint64_t source_file, std::string_view file_name, std::string& buffer)
+        {
+            auto name_length = std::uint16_t(std::min(file_name.size(), logging::max_record_size - sizeof(logging::RecordHeader) - 16));
+
+            logging::RecordHeader header{};
+            header.size = std::uint32_t(sizeof(header) + sizeof(source_file) + sizeof(name_length) + name_length);
+            header.level = logging::source_file_record;
+
+            buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+            buffer.append(reinterpret_cast<const char*>(&source_file), sizeof(source_file));
+            buffer.append(reinterpret_cast<const char*>(&name_length), sizeof(name_length));
+            buffer.append(file_name.data(), name_length);
+            buffer.append(logging::aligned_record_size(header.size) - header.size, '\0');
+        }
+
+        static void flush_buffer(std::string& buffer, std::ostream& stream)
+        {
+            if (buffer.empty())
+                return;
+            stream.write(buffer.data(), std::streamsize(buffer.size()));
+            stream.flush();
+            buffer.clear();
+        }
+
+        std::atomic<bool> _running{ false };
+        bool _binary_format = false;
+        std::thread _log_thread;
+
+        std::mutex _wakeup_lock;
+        std::condition_variable _wakeup;
+
+        std::mutex _rings_lock;
+        std::vector<std::shared_ptr<logging::LogRing>> _rings;
+
+        std::mutex _sync_write_lock;
+        std::atomic<std::size_t> _num_of_dropped{ 0 };
+
+        // accessed by the log thread only.
+        std::ofstream general_log_stream;
+        std::ofstream error_log_stream;
+        std::string _general_buffer;
+        std::string _error_buffer;
+        std::string _console_buffer;
+        std::unordered_map<std::uint64_t, std::string> _source_files;
+        std::unordered_set<std::uint64_t> _emitted_source_files;
+        std::size_t _num_of_reported_drops = 0;
+    };
+
+    LogBackend& log_backend()
+    {
+        static LogBackend backend;
+        return backend;
+    }
 }
 
 namespace logging
@@ -29,111 +318,86 @@ namespace logging
             {"ERROR", log_level::error},
             {"FATAL", log_level::fatal},
         };
-        
+
         if (log_level_map.find(log_level) == log_level_map.end())
             return log_level::info; // Default
 
         return log_level_map.at(log_level);
     }
 
-    void initialize_system(std::string_view log_dir, std::string_view log_filename)
+    void initialize_system(std::string_view log_dir, std::string_view log_filename, bool binary_format)
     {
         setlocale(LC_ALL, ""); // user-default ANSI code page obtained from the operating system
 
-        // Initialize log level descriptors.
-        log_level_descriptors[log_level::debug].prefix_string = "[Debug]";
-        log_level_descriptors[log_level::info].prefix_string = "[Info]";
-        log_level_descriptors[log_level::warn].prefix_string = "[Warn]";
-        log_level_descriptors[log_level::error].prefix_string = "[Error]";
-        log_level_descriptors[log_level::fatal].prefix_string = "[Fatal]";
-
-        log_level_descriptors[log_level::debug].outstream = &general_log_stream;
-        log_level_descriptors[log_level::info].outstream = &general_log_stream;
-        log_level_descriptors[log_level::warn].outstream = &general_log_stream;
-        log_level_descriptors[log_level::error].outstream = &error_log_stream;
-        log_level_descriptors[log_level::fatal].outstream = &error_log_stream;
-
-        // Open file stream for logging.
-        if (not fs::exists(log_dir))
-            fs::create_directories(log_dir);
-
-        {
-            fs::path general_log_path(log_dir);
-            general_log_path /= log_filename;
-            general_log_stream.open(general_log_path, std::ofstream::out);
-            if (not general_log_stream.is_open())
-                CONSOLE_LOG(fatal) << "Fail to open file: " << general_log_path;
-        }
-
-        {
-            fs::path error_log_path(log_dir);
-            error_log_path /= "error_" + std::string(log_filename);
-            error_log_stream.open(error_log_path, std::ofstream::out);
-            if (not error_log_stream.is_open())
-                CONSOLE_LOG(fatal) << "Fail to open file: " << error_log_path;
-        }
+        log_backend().start(log_dir, log_filename, binary_format);
 
         setup::add_termination_handler([]() {
-            general_log_stream.close();
-            error_log_stream.close();
+            log_backend().stop();
         });
     }
 
-    /*  Logger Class */
-
-    Logger::Logger(log_level::value level, const std::source_location &location)
-        : _level{ level }
+    void shutdown_system()
     {
-        set_line_prefix(location);
+        log_backend().stop();
     }
 
-    Logger::~Logger()
+    std::size_t num_of_dropped_records()
     {
-        if (_level == log_level::fatal)
-            std::exit(0);
+        return log_backend().num_of_dropped();
     }
 
-    void Logger::set_line_prefix(const std::source_location& location)
-    {
-        _buffer << log_level_descriptors[_level].prefix_string << ' '
-            << std::filesystem::path(location.file_name()).filename() << '('
-            << location.line() << ':'
-            << location.column() << ") : ";
-    }
-
-    ConsoleLogger::ConsoleLogger(log_level::value level, const std::source_location& location)
-        : Logger{level, location}
-    { }
+    /*  Logger Class */
 
-    ConsoleLogger::~ConsoleLogger()
+    Logger::Logger(log_level::value level, log_sink sink, const std::source_location &location)
     {
-        flush();
+        new (_record) RecordHeader{
+            .level = std::uint8_t(level),
+            .sink = sink,
+            .column = std::uint16_t(location.column()),
+            .line = std::uint32_t(location.line()),
+            .thread_id = current_thread_id(),
+            .timestamp_us = current_timestamp_us(),
+            .source_file = reinterpret_cast<std::uint64_t>(location.file_name()),
+        };
     }
 
-    void ConsoleLogger::flush()
+    Logger::~Logger()
     {
-        std::cout << buffer_view() << std::endl;
+        if (_truncated)
+            append_string("...");
 
-        clear_buffer();
-    }
+        header().size = std::uint32_t(_size);
 
-    FileLogger::FileLogger(log_level::value level, const std::source_location& location)
-        : Logger{ level, location }
-    { }
+        auto& backend = log_backend();
+        if (backend.is_running())
+            backend.write(_record, _size);
+        else
+            backend.write_synchronously(_record, _size);
 
-    FileLogger::~FileLogger()
-    {
-        flush();
+        if (log_level() == log_level::fatal) {
+            backend.stop();
+            std::exit(0);
+        }
     }
 
-    void FileLogger::flush()
+    void Logger::append_string(std::string_view value)
     {
-        {
-            const std::lock_guard<std::mutex> lock(log_level_descriptors[log_level()].flush_mutex);
-            *log_level_descriptors[log_level()].outstream << buffer_view() << std::endl;
+        constexpr std::size_t string_header_size = sizeof(arg_type) + sizeof(std::uint16_t);
+        if (_size + string_header_size >= max_record_size) {
+            _truncated = true;
+            return;
         }
 
-        clear_buffer();
+        auto length = std::min(value.size(), max_record_size - _size - string_header_size);
+        if (length < value.size())
+            _truncated = true;
+
+        auto type = arg_type::string;
+        auto length16 = std::uint16_t(length);
+        std::memcpy(&_record[_size], &type, sizeof(type));
+        std::memcpy(&_record[_size + sizeof(type)], &length16, sizeof(length16));
+        std::memcpy(&_record[_size + string_header_size], value.data(), length);
+        _size += string_header_size + length;
     }
 
     ConsoleLogger console_debug(const std::source_location& location) {
@@ -201,4 +465,4 @@ namespace logging
             }
         }
     }
-}
\ No newline at end of file
+}
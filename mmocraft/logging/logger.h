@@ -1,117 +1,149 @@
 #pragma once
 
+#include <concepts>
+#include <cstring>
 #include <iostream>
 #include <sstream>
-#include <fstream>
 #include <source_location>
-#include <mutex>
+#include <string_view>
+#include <type_traits>
 
 #include "win/win_type.h"
 #include <sql.h>
 #include <sqlext.h>
 
+#include "logging/log_record.h"
 #include "util/common_util.h"
 
 #define ENABLE_FILE_LOGGING true
 #define ENALBE_CONSOLE_LOGGING true
 
-#define LOG(level) if (ENABLE_FILE_LOGGING) logging::##level()
-#define CONSOLE_LOG(level) if (ENALBE_CONSOLE_LOGGING) logging::console_##level()
+// levels below the minimum are discarded at compile time. (0: debug, 1: info, 2: warn, 3: error, 4: fatal)
+#ifndef MIN_LOG_LEVEL
+#define MIN_LOG_LEVEL 0
+#endif
 
-#define LOG_IF(level, cond) if ((cond) && ENABLE_FILE_LOGGING) logging::##level()
-#define CONSOLE_LOG_IF(level, cond) if ((cond) && ENALBE_CONSOLE_LOGGING) logging::console_##level()
+#define LOG(level) if constexpr (logging::is_enabled(logging::log_level::level, ENABLE_FILE_LOGGING)) logging::level()
+#define CONSOLE_LOG(level) if constexpr (logging::is_enabled(logging::log_level::level, ENALBE_CONSOLE_LOGGING)) logging::console_##level()
+
+#define LOG_IF(level, cond) if constexpr (logging::is_enabled(logging::log_level::level, ENABLE_FILE_LOGGING)) if (cond) logging::level()
+#define CONSOLE_LOG_IF(level, cond) if constexpr (logging::is_enabled(logging::log_level::level, ENALBE_CONSOLE_LOGGING)) if (cond) logging::console_##level()
 
 namespace logging
 {
-    namespace log_level
+    constexpr bool is_enabled(log_level::value level, bool enable_logging)
     {
-        enum value
-        {
-            debug,
-            info,
-            warn,
-            error,
-            fatal,
-
-            count,
-        };
+        return enable_logging && level >= MIN_LOG_LEVEL;
     }
 
-    struct LogLevelDescriptor
-    {
-        const char* prefix_string = "[Info]";
-        std::ostream* outstream = &std::cout;
-        std::mutex flush_mutex;
-    };
-
     log_level::value to_log_level(std::string log_level);
 
-    void initialize_system(std::string_view log_dir, std::string_view log_filename);
+    // start the log thread. logs before the initialization are written to stdout synchronously.
+    // binary_format: write binary records which are decoded by decode_log_file(). (smaller and faster)
+    void initialize_system(std::string_view log_dir, std::string_view log_filename, bool binary_format = false);
+
+    // write all pending logs and stop the log thread.
+    void shutdown_system();
+
+    // number of records dropped because the ring of the thread was full.
+    std::size_t num_of_dropped_records();
 
+    template <typename T>
+    concept has_output_operator = requires (std::ostream& os, const T& value) { operator<<(os, value); };
+
+    // Logger encodes streamed values into a binary record, which is formatted by the log thread.
     class Logger : util::NonCopyable, util::NonMovable
     {
     public:
-        Logger(log_level::value, const std::source_location&);
+        Logger(log_level::value, log_sink, const std::source_location&);
+
+        ~Logger();
 
-        virtual ~Logger();
-        
         template <typename T>
-        void append(T&& value)
+        Logger& operator<<(const T& value)
         {
-            _buffer << std::forward<T>(value);
+            append(value);
+            return *this;
         }
 
-        // template member function should be in the header.
         template <typename T>
-        Logger& operator<<(T&& value)
+        void append(const T& value)
         {
-            _buffer << std::forward<T>(value);
-            return *this;
+            using U = std::remove_cvref_t<T>;
+
+            if constexpr (std::is_same_v<U, bool>)
+                append_value(arg_type::boolean, value);
+            else if constexpr (std::is_same_v<U, char>)
+                append_value(arg_type::character, value);
+            else if constexpr (std::is_enum_v<U> && not has_output_operator<U>)
+                append(std::underlying_type_t<U>(value));
+            else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>)
+                append_value(arg_type::int64, std::int64_t(value));
+            else if constexpr (std::is_integral_v<U>)
+                append_value(arg_type::uint64, std::uint64_t(value));
+            else if constexpr (std::is_floating_point_v<U>)
+                append_value(arg_type::float64, double(value));
+            else if constexpr (std::is_pointer_v<U> && std::is_convertible_v<const T&, std::string_view>)
+                append_string(value ? std::string_view(value) : std::string_view("(null)"));
+            else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+                append_string(value);
+            else {
+                // slow path for types which have only the stream operator.
+                std::ostringstream stream;
+                stream << value;
+                append_string(stream.str());
+            }
         }
 
-        std::string_view buffer_view() const
+        log_level::value log_level() const
         {
-            return _buffer.view();
+            return log_level::value(header().level);
         }
 
-        void clear_buffer()
+    private:
+        template <typename T>
+        void append_value(arg_type type, const T& value)
         {
-            _buffer.str(std::string());
-            _buffer.clear();
+            if (_size + sizeof(type) + sizeof(value) > max_record_size) {
+                _truncated = true;
+                return;
+            }
+            std::memcpy(&_record[_size], &type, sizeof(type));
+            std::memcpy(&_record[_size + sizeof(type)], &value, sizeof(value));
+            _size += sizeof(type) + sizeof(value);
         }
 
-        log_level::value log_level() const
+        void append_string(std::string_view);
+
+        RecordHeader& header()
         {
-            return _level;
+            return *reinterpret_cast<RecordHeader*>(_record);
         }
 
-        virtual void flush() = 0;
-
-    private:
-        void set_line_prefix(const std::source_location&);
+        const RecordHeader& header() const
+        {
+            return *reinterpret_cast<const RecordHeader*>(_record);
+        }
 
-        log_level::value _level;
-        std::stringstream _buffer;
+        alignas(RecordHeader) std::byte _record[max_record_size];
+        std::size_t _size = sizeof(RecordHeader);
+        bool _truncated = false;
     };
 
     class ConsoleLogger : public Logger
     {
     public:
-        ConsoleLogger(log_level::value, const std::source_location&);
-
-        ~ConsoleLogger();
-
-        virtual void flush() override;
+        ConsoleLogger(log_level::value level, const std::source_location& location)
+            : Logger{ level, log_sink::console, location }
+        { }
     };
 
     class FileLogger : public Logger
     {
     public:
-        FileLogger(log_level::value, const std::source_location&);
-
-        ~FileLogger();
-
-        virtual void flush() override;
+        FileLogger(log_level::value level, const std::source_location& location)
+            : Logger{ level, log_sink::file, location }
+        { }
     };
 
     // Console log functions
@@ -122,7 +154,7 @@ namespace logging
     ConsoleLogger console_warn(const std::source_location& location = std::source_location::current());
 
     ConsoleLogger console_error(const std::source_location &location = std::source_location::current());
-    
+
     ConsoleLogger console_fatal(const std::source_location &location = std::source_location::current());
 
     // File log functions
@@ -133,8 +165,8 @@ namespace logging
     FileLogger warn(const std::source_location& location = std::source_location::current());
 
     FileLogger error(const std::source_location& location = std::source_location::current());
-    
+
     FileLogger fatal(const std::source_location& location = std::source_location::current());
 
     void logging_sql_error(SQLSMALLINT handle_type, SQLHANDLE handle, RETCODE error_code);
-}
\ No newline at end of file
+}
@@ -1,12 +1,15 @@
 #include "pch.h"
+#include <fstream>
 #include <iostream>
 #include <locale>
+#include <string_view>
 
 #include "config/config.h"
 #include "util/deferred_call.h"
 #include "net/game_server.h"
 #include "database/query.h"
 #include "logging/error.h"
+#include "logging/log_record.h"
 #include "system_initializer.h"
 
 #include <couchbase/cluster.hxx>
@@ -15,7 +18,15 @@
 int main(int argc, char* argv[])
 {
 	if (argc != 3) {
-		std::cout << "Usage: " << argv[0] << " ROUTE_SERVER_IP ROUTE_SERVER_PORT";
+		std::cout << "Usage: " << argv[0] << " ROUTE_SERVER_IP ROUTE_SERVER_PORT\n"
+			      << "       " << argv[0] << " --decode-log BINARY_LOG_FILE";
+		return 0;
+	}
+
+	if (std::string_view(argv[1]) == "--decode-log") {
+		std::ifstream binary_log(argv[2], std::ios::binary);
+		if (not logging::decode_log_file(binary_log, std::cout))
+			std::cerr << "Not a binary log file: " << argv[2] << std::endl;
 		return 0;
 	}
 
@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    // splits "name{labels}" into "name" and "labels".
+    std::pair<std::string_view, std::string_view> split_labels(std::string_view name)
+    {
+        auto pos = name.find('{');
+        if (pos == std::string_view::npos || name.back() != '}')
+            return { name, {} };
+        return { name.substr(0, pos), name.substr(pos + 1, name.size() - pos - 2) };
+    }
+
+    void append_sample(std::string& out, std::string_view family, std::string_view suffix,
+                       std::string_view labels, std::string_view extra_label, std::uint64_t value)
+    {
+        out.append(family).append(suffix);
+        if (not labels.empty() || not extra_label.empty()) {
+            out.push_back('{');
+            out.append(labels);
+            if (not labels.empty() && not extra_label.empty())
+                out.push_back(',');
+            out.append(extra_label);
+            out.push_back('}');
+        }
+        out.push_back(' ');
+        out.append(std::to_string(value));
+        out.push_back('\n');
+    }
+}
+
+namespace metrics
+{
+    std::size_t current_shard()
+    {
+        static std::atomic<std::size_t> num_of_threads{ 0 };
+        thread_local const std::size_t shard = num_of_threads.fetch_add(1, std::memory_order_relaxed) % num_of_shards;
+        return shard;
+    }
+
+    std::uint64_t Counter::value() const
+    {
+        std::uint64_t sum = 0;
+        for (const auto& shard : shards)
+            sum += shard.value.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    Histogram::Snapshot Histogram::snapshot() const
+    {
+        Snapshot snapshot;
+        for (const auto& shard : shards) {
+            for (std::size_t i = 0; i < num_of_buckets; i++) {
+                auto count = shard.buckets[i].load(std::memory_order_relaxed);
+                snapshot.buckets[i] += count;
+                snapshot.count += count;
+            }
+            snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+
+    std::uint64_t Histogram::Snapshot::percentile(double percentile) const
+    {
+        if (count == 0)
+            return 0;
+
+        auto target = std::uint64_t(std::clamp(percentile, 0.0, 100.0) / 100 * double(count));
+        std::uint64_t accumulated = 0;
+        for (std::size_t i = 0; i < num_of_buckets; i++) {
+            accumulated += buckets[i];
+            if (accumulated > target || accumulated == count)
+                return bucket_upper_bound(i);
+        }
+        return bucket_upper_bound(num_of_buckets - 1);
+    }
+
+    std::uint64_t Histogram::Snapshot::count_less_or_equal(std::uint64_t value) const
+    {
+        std::uint64_t accumulated = 0;
+        for (std::size_t i = 0; i < num_of_buckets && bucket_upper_bound(i) <= value; i++)
+            accumulated += buckets[i];
+        return accumulated;
+    }
+
+    Histogram::Snapshot Histogram::Snapshot::operator-(const Snapshot& earlier) const
+    {
+        Snapshot diff;
+        for (std::size_t i = 0; i < num_of_buckets; i++)
+            diff.buckets[i] = buckets[i] - earlier.buckets[i];
+        diff.count = count - earlier.count;
+        diff.sum = sum - earlier.sum;
+        return diff;
+    }
+
+    Registry::Entry& Registry::find_or_add(std::string_view name, std::string_view help, Type type)
+    {
+        std::lock_guard<std::mutex> lock(entries_lock);
+
+        auto found = std::find_if(entries.begin(), entries.end(), [name](const auto& entry) {
+            return entry->name == name;
+        });
+        if (found != entries.end()) {
+            // the caller would dereference a metric of another type.
+            if ((*found)->type != type)
+                throw std::invalid_argument("Metric '" + std::string(name) + "' is registered with another type");
+            return **found;
+        }
+
+        auto& entry = *entries.emplace_back(new Entry{ .name = std::string(name), .help = std::string(help), .type = type });
+        switch (type) {
+        case Type::counter:
+            entry.counter = std::make_unique<Counter>();
+            break;
+        case Type::gauge:
+            entry.gauge = std::make_unique<Gauge>();
+            break;
+        case Type::histogram:
+            entry.histogram = std::make_unique<Histogram>();
+            break;
+        }
+        return entry;
+    }
+
+    Counter& Registry::counter(std::string_view name, std::string_view help)
+    {
+        return *find_or_add(name, help, Type::counter).counter;
+    }
+
+    Gauge& Registry::gauge(std::string_view name, std::string_view help)
+    {
+        return *find_or_add(name, help, Type::gauge).gauge;
+    }
+
+    Histogram& Registry::histogram(std::string_view name, std::string_view help)
+    {
+        return *find_or_add(name, help, Type::histogram).histogram;
+    }
+
+    std::string Registry::export_text() const
+    {
+        std::vector<const Entry*> sorted_entries;
+        {
+            std::lock_guard<std::mutex> lock(entries_lock);
+            for (const auto& entry : entries)
+                sorted_entries.push_back(entry.get());
+        }
+
+        // samples of a family must be grouped together.
+        std::stable_sort(sorted_entries.begin(), sorted_entries.end(), [](const Entry* a, const Entry* b) {
+            return split_labels(a->name).first < split_labels(b->name).first;
+        });
+
+        std::string out;
+        std::string_view prev_family;
+
+        for (auto entry : sorted_entries) {
+            auto [family, labels] = split_labels(entry->name);
+
+            if (family != prev_family) {
+                static const char* type_names[] = { "counter", "gauge", "histogram" };
+                out.append("# HELP ").append(family).append(" ").append(entry->help).append("\n");
+                out.append("# TYPE ").append(family).append(" ").append(type_names[int(entry->type)]).append("\n");
+                prev_family = family;
+            }
+
+            switch (entry->type) {
+            case Type::counter:
+                append_sample(out, family, "", labels, "", entry->counter->value());
+                break;
+            case Type::gauge:
+            {
+                auto value = entry->gauge->value();
+                out.append(entry->name).append(" ").append(std::to_string(value)).append("\n");
+                break;
+            }
+            case Type::histogram:
+            {
+                auto snapshot = entry->histogram->snapshot();
+
+                // power of two bucket boundaries up to the largest recorded value.
+                auto max_value = snapshot.percentile(100);
+                for (unsigned bits = 0; bits <= Histogram::max_value_bits; bits++) {
+                    auto upper_bound = (std::uint64_t(1) << bits) - 1;
+                    auto le_label = "le=\"" + std::to_string(upper_bound) + "\"";
+                    append_sample(out, family, "_bucket", labels, le_label, snapshot.count_less_or_equal(upper_bound));
+                    if (upper_bound >= max_value)
+                        break;
+                }
+                append_sample(out, family, "_bucket", labels, "le=\"+Inf\"", snapshot.count);
+                append_sample(out, family, "_sum", labels, "", snapshot.sum);
+                append_sample(out, family, "_count", labels, "", snapshot.count);
+                break;
+            }
+            }
+        }
+
+        return out;
+    }
+
+    Registry& registry()
+    {
+        static Registry global_registry;
+        return global_registry;
+    }
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util/noncopyable.h"
+
+namespace metrics
+{
+    // hot metrics are updated by many threads. each thread updates its own shard to avoid cache line bouncing.
+    constexpr std::size_t num_of_shards = 16;
+
+    std::size_t current_shard();
+
+    class Counter : util::NonCopyable, util::NonMovable
+    {
+    public:
+        void add(std::uint64_t n = 1)
+        {
+            shards[current_shard()].value.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        std::uint64_t value() const;
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::atomic<std::uint64_t> value{ 0 };
+        };
+
+        std::array<Shard, num_of_shards> shards;
+    };
+
+    class Gauge : util::NonCopyable, util::NonMovable
+    {
+    public:
+        void set(std::int64_t value)
+        {
+            _value.store(value, std::memory_order_relaxed);
+        }
+
+        void add(std::int64_t n)
+        {
+            _value.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        std::int64_t value() const
+        {
+            return _value.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<std::int64_t> _value{ 0 };
+    };
+
+    // Histogram with log-linear buckets. (like HdrHistogram)
+    // values below 2^sub_bucket_bits are exact, and every power of two range above is split into 2^sub_bucket_bits buckets,
+    // so the relative error is at most 1 / 2^sub_bucket_bits.
+    class Histogram : util::NonCopyable, util::NonMovable
+    {
+    public:
+        static constexpr unsigned sub_bucket_bits = 3;
+        static constexpr std::size_t num_of_sub_buckets = 1 << sub_bucket_bits;
+        static constexpr unsigned max_value_bits = 40;  // larger values are counted in the last bucket.
+        static constexpr std::size_t num_of_buckets = (max_value_bits - sub_bucket_bits + 1) * num_of_sub_buckets;
+        static constexpr std::size_t num_of_histogram_shards = 4;
+
+        struct Snapshot
+        {
+            std::array<std::uint64_t, num_of_buckets> buckets{};
+            std::uint64_t count = 0;
+            std::uint64_t sum = 0;
+
+            // upper bound of the bucket which contains the given percentile (0 ~ 100).
+            std::uint64_t percentile(double) const;
+
+            // number of values which are less than or equal to the value. (the value must be a bucket boundary)
+            std::uint64_t count_less_or_equal(std::uint64_t value) const;
+
+            std::uint64_t mean() const
+            {
+                return count ? sum / count : 0;
+            }
+
+            // values recorded after the earlier snapshot of the same histogram.
+            Snapshot operator-(const Snapshot& earlier) const;
+        };
+
+        static constexpr std::size_t bucket_index(std::uint64_t value)
+        {
+            if (value < num_of_sub_buckets)
+                return std::size_t(value);
+
+            auto exponent = unsigned(std::bit_width(value)) - 1;
+            if (exponent >= max_value_bits)
+                return num_of_buckets - 1;
+
+            auto shift = exponent - sub_bucket_bits;
+            auto sub_bucket = std::size_t(value >> shift) & (num_of_sub_buckets - 1);
+            return (shift + 1) * num_of_sub_buckets + sub_bucket;
+        }
+
+        // the largest value of the bucket.
+        static constexpr std::uint64_t bucket_upper_bound(std::size_t index)
+        {
+            if (index < num_of_sub_buckets)
+                return index;
+
+            auto shift = unsigned(index / num_of_sub_buckets - 1);
+            auto sub_bucket = index % num_of_sub_buckets;
+            return ((num_of_sub_buckets + sub_bucket + 1) << shift) - 1;
+        }
+
+        void record(std::uint64_t value)
+        {
+            auto& shard = shards[current_shard() % num_of_histogram_shards];
+            shard.buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+            shard.sum.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        Snapshot snapshot() const;
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::array<std::atomic<std::uint64_t>, num_of_buckets> buckets{};
+            std::atomic<std::uint64_t> sum{ 0 };
+        };
+
+        std::array<Shard, num_of_histogram_shards> shards;
+    };
+
+    // ScopedTimer records the elapsed microseconds of the scope.
+    class ScopedTimer : util::NonCopyable, util::NonMovable
+    {
+    public:
+        explicit ScopedTimer(Histogram& histogram)
+            : _histogram{ histogram }
+            , started_at{ std::chrono::steady_clock::now() }
+        { }
+
+        ~ScopedTimer()
+        {
+            auto elapsed = std::chrono::steady_clock::now() - started_at;
+            _histogram.record(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+        }
+
+    private:
+        Histogram& _histogram;
+        std::chrono::steady_clock::time_point started_at;
+    };
+
+    // Registry owns all metrics. metrics are registered once (usually into a static reference) and never removed.
+    // name may have labels in the Prometheus syntax. e.g. mmocraft_task_runs_total{task="sync_block"}
+    // registering a name again returns the same metric. (throws std::invalid_argument if it is of another type)
+    class Registry : util::NonCopyable, util::NonMovable
+    {
+    public:
+        Counter& counter(std::string_view name, std::string_view help);
+
+        Gauge& gauge(std::string_view name, std::string_view help);
+
+        Histogram& histogram(std::string_view name, std::string_view help);
+
+        // Prometheus text exposition format. (histograms are exported with power of two buckets)
+        std::string export_text() const;
+
+    private:
+        enum class Type
+        {
+            counter,
+            gauge,
+            histogram,
+        };
+
+        struct Entry
+        {
+            std::string name;
+            std::string help;
+            Type type;
+
+            std::unique_ptr<Counter> counter;
+            std::unique_ptr<Gauge> gauge;
+            std::unique_ptr<Histogram> histogram;
+        };
+
+        Entry& find_or_add(std::string_view name, std::string_view help, Type);
+
+        mutable std::mutex entries_lock;
+        std::vector<std::unique_ptr<Entry>> entries;
+    };
+
+    Registry& registry();
+
+    inline Counter& counter(std::string_view name, std::string_view help)
+    {
+        return registry().counter(name, help);
+    }
+
+    inline Gauge& gauge(std::string_view name, std::string_view help)
+    {
+        return registry().gauge(name, help);
+    }
+
+    inline Histogram& histogram(std::string_view name, std::string_view help)
+    {
+        return registry().histogram(name, help);
+    }
+}
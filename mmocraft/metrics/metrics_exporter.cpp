@@ -0,0 +1,75 @@
+#include "pch.h"
+#include "metrics_exporter.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+
+#include "logging/logger.h"
+#include "metrics/metrics.h"
+
+namespace fs = std::filesystem;
+
+namespace metrics
+{
+    Exporter::Exporter()
+        : udp_sock{ net::socket_protocol_id::udp_v4 }
+    { }
+
+    void Exporter::configure(const config::Configuration_Metrics& conf)
+    {
+        file_path = conf.export_path();
+        udp_ip = conf.export_udp_ip();
+        udp_port = int(conf.export_udp_port());
+    }
+
+    void Exporter::export_snapshot()
+    {
+        if (not is_enabled())
+            return;
+
+        auto text = registry().export_text();
+
+        if (not file_path.empty() && not write_file(text))
+            LOG(error) << "Fail to export metrics to " << file_path;
+
+        if (not udp_ip.empty() && not send_datagrams(text))
+            LOG(error) << "Fail to export metrics to " << udp_ip << ':' << udp_port;
+    }
+
+    bool Exporter::write_file(const std::string& text) const
+    {
+        // readers never see a partially written snapshot.
+        auto temp_path = file_path + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if (not file.write(text.data(), std::streamsize(text.size())))
+                return false;
+        }
+
+        std::error_code error;
+        fs::rename(temp_path, file_path, error);
+        return not error;
+    }
+
+    bool Exporter::send_datagrams(const std::string& text)
+    {
+        std::string_view remaining{ text };
+
+        while (not remaining.empty()) {
+            auto size = remaining.size();
+            if (size > max_datagram_size) {
+                // split at a line boundary.
+                auto line_end = remaining.rfind('\n', max_datagram_size - 1);
+                size = line_end == std::string_view::npos ? max_datagram_size : line_end + 1;
+            }
+
+            if (not udp_sock.send_to(udp_ip.c_str(), udp_port, remaining.data(), size))
+                return false;
+
+            remaining.remove_prefix(size);
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+
+#include "net/socket.h"
+#include "proto/generated/config.pb.h"
+#include "util/noncopyable.h"
+
+namespace metrics
+{
+    // Exporter writes snapshots of the registry in the Prometheus text format
+    // to a file (replaced atomically, e.g. for the node exporter textfile collector) and/or a local UDP endpoint.
+    class Exporter : util::NonCopyable, util::NonMovable
+    {
+    public:
+        // a datagram carries whole lines up to this size.
+        static constexpr std::size_t max_datagram_size = 8 * 1024;
+
+        Exporter();
+
+        void configure(const config::Configuration_Metrics&);
+
+        bool is_enabled() const
+        {
+            return not file_path.empty() || not udp_ip.empty();
+        }
+
+        void export_snapshot();
+
+    private:
+        bool write_file(const std::string& text) const;
+
+        bool send_datagrams(const std::string& text);
+
+        std::string file_path;
+
+        std::string udp_ip;
+        int udp_port = 0;
+        net::Socket udp_sock;
+    };
+}
@@ -0,0 +1,183 @@
+#include "pch.h"
+#include "trace.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Event
+    {
+        std::string_view name;
+        std::uint64_t begin_tsc;
+        std::uint64_t end_tsc;
+        std::int64_t arg;
+    };
+
+    // ThreadBuffer is written by the owner thread only. the dumper reads the published events. (size)
+    struct ThreadBuffer
+    {
+        std::uint32_t thread_id = 0;
+        std::atomic<std::uint64_t> session{ 0 };
+        std::atomic<std::size_t> size{ 0 };
+        std::atomic<std::size_t> num_of_dropped{ 0 };
+        std::unique_ptr<Event[]> events{ new Event[metrics::trace::max_events_per_thread] };
+    };
+
+    struct Session
+    {
+        std::uint64_t id = 0;
+
+        std::uint64_t begin_tsc = 0;
+        std::uint64_t end_tsc = 0;
+        std::chrono::steady_clock::time_point begin_time;
+        std::chrono::steady_clock::time_point end_time;
+    };
+
+    // protects buffers and the session.
+    std::mutex trace_lock;
+
+    // buffers are kept after the owner thread exits. (threads are long-lived)
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    Session session;
+
+    std::atomic<std::uint64_t> current_session_id{ 0 };
+
+    ThreadBuffer& thread_buffer()
+    {
+        thread_local ThreadBuffer* buffer = [] {
+            std::lock_guard<std::mutex> lock(trace_lock);
+            auto& new_buffer = *buffers.emplace_back(std::make_unique<ThreadBuffer>());
+            new_buffer.thread_id = std::uint32_t(buffers.size());
+            return &new_buffer;
+        }();
+        return *buffer;
+    }
+
+    void append_json_string(std::string& out, std::string_view str)
+    {
+        out.push_back('"');
+        for (auto ch : str) {
+            if (ch == '"' || ch == '\\')
+                out.push_back('\\');
+            if (unsigned(ch) >= 0x20)
+                out.push_back(ch);
+        }
+        out.push_back('"');
+    }
+}
+
+namespace metrics::trace
+{
+    void start()
+    {
+        std::lock_guard<std::mutex> lock(trace_lock);
+
+        session.id++;
+        session.begin_time = std::chrono::steady_clock::now();
+        session.begin_tsc = util::read_tsc();
+        session.end_tsc = 0;
+
+        current_session_id.store(session.id, std::memory_order_relaxed);
+        is_tracing.store(true, std::memory_order_release);
+    }
+
+    void stop()
+    {
+        std::lock_guard<std::mutex> lock(trace_lock);
+        if (not is_tracing.load(std::memory_order_relaxed))
+            return;
+
+        is_tracing.store(false, std::memory_order_relaxed);
+        session.end_tsc = util::read_tsc();
+        session.end_time = std::chrono::steady_clock::now();
+    }
+
+    void record(std::string_view name, std::uint64_t begin_tsc, std::uint64_t end_tsc, std::int64_t arg)
+    {
+        if (not is_tracing.load(std::memory_order_acquire))
+            return;
+
+        auto& buffer = thread_buffer();
+
+        // reset the buffer on the first event of a new session.
+        auto session_id = current_session_id.load(std::memory_order_relaxed);
+        if (buffer.session.load(std::memory_order_relaxed) != session_id) {
+            buffer.size.store(0, std::memory_order_relaxed);
+            buffer.num_of_dropped.store(0, std::memory_order_relaxed);
+            buffer.session.store(session_id, std::memory_order_release);
+        }
+
+        auto size = buffer.size.load(std::memory_order_relaxed);
+        if (size == max_events_per_thread) {
+            buffer.num_of_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        buffer.events[size] = { .name = name, .begin_tsc = begin_tsc, .end_tsc = end_tsc, .arg = arg };
+        buffer.size.store(size + 1, std::memory_order_release);
+    }
+
+    std::size_t num_of_dropped_events()
+    {
+        std::lock_guard<std::mutex> lock(trace_lock);
+
+        std::size_t num_of_dropped = 0;
+        for (const auto& buffer : buffers)
+            if (buffer->session.load(std::memory_order_acquire) == session.id)
+                num_of_dropped += buffer->num_of_dropped.load(std::memory_order_relaxed);
+        return num_of_dropped;
+    }
+
+    bool write_chrome_trace(std::ostream& os)
+    {
+        std::lock_guard<std::mutex> lock(trace_lock);
+        if (is_tracing.load(std::memory_order_relaxed) || session.end_tsc == 0)
+            return false;
+
+        // convert TSC ticks to microseconds with the frequency measured during the session.
+        auto session_us = std::chrono::duration<double, std::micro>(session.end_time - session.begin_time).count();
+        auto session_ticks = double(session.end_tsc - session.begin_tsc);
+        auto us_per_tick = session_ticks > 0 ? session_us / session_ticks : 0.0;
+
+        auto to_us = [&](std::uint64_t tsc) {
+            return tsc > session.begin_tsc ? double(tsc - session.begin_tsc) * us_per_tick : 0.0;
+        };
+
+        std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool is_first_event = true;
+
+        for (const auto& buffer : buffers) {
+            if (buffer->session.load(std::memory_order_acquire) != session.id)
+                continue;
+
+            auto size = buffer->size.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < size; i++) {
+                const auto& event = buffer->events[i];
+                auto begin_us = to_us(event.begin_tsc);
+
+                out.append(is_first_event ? "\n" : ",\n");
+                is_first_event = false;
+
+                out.append("{\"name\":");
+                append_json_string(out, event.name);
+                out.append(",\"ph\":\"X\",\"pid\":1,\"tid\":").append(std::to_string(buffer->thread_id));
+                out.append(",\"ts\":").append(std::to_string(begin_us));
+                out.append(",\"dur\":").append(std::to_string(to_us(event.end_tsc) - begin_us));
+                if (event.arg != no_arg)
+                    out.append(",\"args\":{\"arg\":").append(std::to_string(event.arg)).append("}");
+                out.push_back('}');
+            }
+
+            // flush per thread not to hold the whole trace in memory.
+            os << out;
+            out.clear();
+        }
+
+        os << out << "\n]}\n";
+        return bool(os);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+#include "util/noncopyable.h"
+#include "util/time_util.h"
+
+// Scoped trace spans. spans are recorded only while tracing is started. (a relaxed load otherwise)
+// name must outlive the trace session. (usually a string literal)
+#define TRACE_SPAN(name) \
+    metrics::trace::Span TRACE_CONCAT(trace_span_, __COUNTER__){ name }
+
+#define TRACE_SPAN_ARG(name, arg) \
+    metrics::trace::Span TRACE_CONCAT(trace_span_, __COUNTER__){ name, std::int64_t(arg) }
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+namespace metrics::trace
+{
+    // each thread keeps the first events of a session. the rest are dropped.
+    constexpr std::size_t max_events_per_thread = 1 << 16;
+
+    constexpr std::int64_t no_arg = INT64_MIN;
+
+    inline std::atomic<bool> is_tracing{ false };
+
+    inline bool is_enabled()
+    {
+        return is_tracing.load(std::memory_order_relaxed);
+    }
+
+    // starts a new session. events of the previous session are discarded.
+    void start();
+
+    void stop();
+
+    // writes the events of the last session in the Chrome trace event format. (open with Perfetto or chrome://tracing)
+    // must be invoked after stop().
+    bool write_chrome_trace(std::ostream&);
+
+    std::size_t num_of_dropped_events();
+
+    void record(std::string_view name, std::uint64_t begin_tsc, std::uint64_t end_tsc, std::int64_t arg);
+
+    class Span : util::NonCopyable, util::NonMovable
+    {
+    public:
+        explicit Span(std::string_view name, std::int64_t arg = no_arg)
+            : _name{ name }
+            , _arg{ arg }
+            , begin_tsc{ is_enabled() ? util::read_tsc() : 0 }
+        { }
+
+        ~Span()
+        {
+            if (begin_tsc)
+                record(_name, begin_tsc, util::read_tsc(), _arg);
+        }
+
+    private:
+        std::string_view _name;
+        std::int64_t _arg;
+        std::uint64_t begin_tsc;
+    };
+}
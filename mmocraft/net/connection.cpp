@@ -5,6 +5,7 @@
 
 #include "config/config.h"
 #include "logging/error.h"
+#include "metrics/metrics.h"
 #include "net/tcp_server.h"
 #include "net/connection_environment.h"
 
@@ -50,8 +51,10 @@ namespace net
 
     bool Connection::is_safe_delete(std::size_t current_tick) const
     {
+        // the player must not be deleted while it is linked in the state queue of a world.
         return not _is_online
-            && current_tick >= last_offline_tick + REQUIRED_MILLISECONDS_FOR_SECURE_DELETION;
+            && current_tick >= last_offline_tick + REQUIRED_MILLISECONDS_FOR_SECURE_DELETION
+            && not (_player && _player->is_state_queued());
     }
 
     bool Connection::try_interact_with_client()
@@ -123,7 +126,7 @@ namespace net
         return data_cur - data_begin; // num of total parsed bytes.
     }
 
-    void Connection::on_handshake_success()
+    void Connection::on_handshake_success(unsigned map_volume)
     {
         assert(_player != nullptr);
         const auto& conf = config::get_config();
@@ -135,7 +138,10 @@ namespace net
 
         net::PacketSetPlayerID set_player_id_packet(_player->game_id());
 
-        net::PacketLevelInit level_init_packet;
+        // FastMap clients receive the map volume in advance instead of the level data prefix.
+        net::PacketLevelInit level_init_packet = _player->is_supported_extension(net::packet_type_id::level_initialize)
+            ? net::PacketLevelInit(net::PacketFieldType::Int(map_volume))
+            : net::PacketLevelInit();
 
         connection_io->send_packet(handshake_packet);
         connection_io->send_packet(set_player_id_packet);
@@ -268,11 +274,21 @@ namespace net
 
     void ConnectionIO::flush_send(net::ConnectionEnvironment& connection_env)
     {
+        static auto& flush_duration = metrics::histogram("mmocraft_flush_send_duration_us", "Time to flush send buffers of all connections.");
+        static auto& send_buffer_bytes = metrics::histogram("mmocraft_send_buffer_bytes", "Pending bytes of a send buffer at flush.");
+        static auto& busy_send_buffers = metrics::counter("mmocraft_send_io_busy_total", "Flushes skipped because the previous send was in flight.");
+
+        metrics::ScopedTimer flush_timer{ flush_duration };
+
         auto flush_message = [](Connection& conn) {
             auto connection_io = conn.io();
 
-            if (not connection_io->is_send_io_busy())
+            if (not connection_io->is_send_io_busy()) {
+                send_buffer_bytes.record(connection_io->io_send_event->event_data()->size());
                 connection_io->post_send_event();
+            }
+            else
+                busy_send_buffers.add();
 
             connection_io->flush_multicast_send();
         };
@@ -289,6 +305,9 @@ namespace net
             multicast_events.swap(ready_multicast_events);
         }
 
+        static auto& multicast_sends = metrics::counter("mmocraft_multicast_sends_total", "Multicast send events posted.");
+        multicast_sends.add(multicast_events.size());
+
         for (auto event : multicast_events) {
             if (not event->post_rio_event(io_service, connection_id))
                 free_multicast_event(event);
@@ -134,7 +134,7 @@ namespace net
             return _player.get();
         }
 
-        void set_offline(std::size_t current_tick = util::current_monotonic_tick());
+        void set_offline(std::size_t current_tick = util::coarse_monotonic_tick());
 
         inline bool is_online() const
         {
@@ -146,13 +146,13 @@ namespace net
             return _is_kicked;
         }
 
-        bool is_expired(std::size_t current_tick = util::current_monotonic_tick()) const;
+        bool is_expired(std::size_t current_tick = util::coarse_monotonic_tick()) const;
 
-        bool is_safe_delete(std::size_t current_tick = util::current_monotonic_tick()) const;
+        bool is_safe_delete(std::size_t current_tick = util::coarse_monotonic_tick()) const;
 
         bool try_interact_with_client();
 
-        void update_last_interaction_time(std::size_t current_tick = util::current_monotonic_tick())
+        void update_last_interaction_time(std::size_t current_tick = util::coarse_monotonic_tick())
         {
             last_interaction_tick = current_tick;
         }
@@ -170,7 +170,7 @@ namespace net
             _player = std::move(player);
         }
 
-        void on_handshake_success();
+        void on_handshake_success(unsigned map_volume);
 
         /**
          *  Event Handler Interface
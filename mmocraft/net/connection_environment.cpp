@@ -106,4 +106,17 @@ namespace net
         }
 
     }
+
+    void ConnectionEnvironment::select_players(game::WorldID world_id, bool(*filter)(const game::Player*), std::vector<game::Player*>& found)
+    {
+        for (std::size_t i = 0; i < connection_table.size(); i++) {
+            auto& entry = connection_table[i];
+            if (entry.will_delete)
+                continue;
+
+            auto player = entry.connection->associated_player();
+            if (player && player->world_id() == world_id && filter(player))
+                found.push_back(player);
+        }
+    }
 }
\ No newline at end of file
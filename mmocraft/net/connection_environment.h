@@ -87,6 +87,9 @@ namespace net
 
         void select_players(bool(*filter)(const game::Player*), std::vector<game::Player*>&);
 
+        // select players in the world only.
+        void select_players(game::WorldID, bool(*filter)(const game::Player*), std::vector<game::Player*>&);
+
     private:
         static std::atomic<std::uint32_t> connection_id_counter;
         
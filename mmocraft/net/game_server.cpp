@@ -1,14 +1,17 @@
 #include "pch.h"
 #include "game_server.h"
 
+#include <algorithm>
 #include <array>
 #include <cstring>
 #include <filesystem>
+#include <fstream>
 
 #include "config/config.h"
 #include "config/constants.h"
 #include "logging/error.h"
 #include "database/query.h"
+#include "metrics/trace.h"
 
 namespace
 {
@@ -29,6 +32,7 @@ namespace
     std::array<io::DetachedTask(net::GameServer::*)(net::MessageRequest&), 0x100> message_handler_table = [] {
         std::array<io::DetachedTask(net::GameServer::*)(net::MessageRequest&), 0x100> arr{};
         arr[net::message_id::packet_handshake] = &net::GameServer::handle_handshake_response_message;
+        arr[net::message_id::chat_command_response] = &net::GameServer::handle_chat_command_response_message;
         return arr;
     }();
 }
@@ -40,20 +44,54 @@ namespace net
         , io_service { max_clients, num_of_event_threads }
         , tcp_server{ *this, connection_env, io_service }
         , udp_server{ *this }
-
-        , world{ connection_env }
         
         , interval_tasks{ this }
+        , tick_loop{ game_server_tick_budget::tick_interval_ms }
     {
         interval_tasks.schedule(util::interval_task_tag_id::announce_server,
             &GameServer::announce_server,
             util::MilliSecond(config::task::announce_server_period)
         );
+
+        interval_tasks.schedule(util::interval_task_tag_id::report_tick_statistics,
+            &GameServer::report_tick_statistics,
+            util::MilliSecond(config::task::report_tick_statistics_period)
+        );
+
+        interval_tasks.schedule(util::interval_task_tag_id::flush_player_gamedata,
+            &GameServer::flush_player_gamedata,
+            util::MilliSecond(config::task::flush_player_gamedata_period)
+        );
+
+        const auto& conf = config::get_config();
+
+        metrics_exporter.configure(conf.metrics());
+        if (metrics_exporter.is_enabled()) {
+            auto export_period = conf.metrics().export_interval_ms() ? int(conf.metrics().export_interval_ms())
+                                                                     : config::task::export_metrics_period;
+            interval_tasks.schedule(util::interval_task_tag_id::export_metrics,
+                &GameServer::export_metrics,
+                util::MilliSecond(export_period)
+            );
+        }
+
+        auto create_world = [this](const config::Configuration_World& world_conf) {
+            auto world_id = game::WorldID(worlds.size());
+            auto num_of_task_threads = std::max(world_conf.num_of_task_threads(), 1u);
+            worlds.emplace_back(std::make_unique<game::World>(world_id, connection_env, num_of_task_threads));
+        };
+
+        create_world(conf.world());
+        for (const auto& world_conf : conf.extra_worlds())
+            create_world(world_conf);
+
+        CONSOLE_LOG_IF(fatal, worlds.size() >= game::invalid_world_id) << "Too many worlds.";
     }
 
     error::ResultCode GameServer::handle_packet(net::Connection& conn, const std::byte* packet_data)
     {
         auto [packet_id, packet_size] = PacketStructure::parse_packet(packet_data);
+        TRACE_SPAN_ARG("handle_packet", packet_id);
 
         if (auto handler = packet_handler_db[packet_id])
             return (this->*handler)(conn, { packet_data, std::size_t(packet_size) });
@@ -66,12 +104,18 @@ namespace net
     {
         net::PacketHandshake packet(packet_data.data());
 
+        // the player may be linked in the state queue of the world, so it must not be replaced.
+        if (conn.associated_player())
+            return error::code::packet::duplicate_handshake;
+
         conn.set_player(std::make_unique<game::Player>(
             conn.connection_key(),
             packet.username
         ));
 
         if (auto player = conn.associated_player()) {
+            worlds[game::default_world_id]->register_player(*player);
+
             if (packet.has_cpe_support())
                 player->prepare_state_transition(game::PlayerState::ex_handshaking, game::PlayerState::ex_handshaked);
             else
@@ -114,7 +158,7 @@ namespace net
         net::PacketSetBlockClient packet(packet_data.data());
 
         auto block_id = packet.block_creation_mode() == game::block_creation_mode::set ? packet.block_id : game::block_id::air;
-        if (not world.try_change_block({ packet.x, packet.y, packet.z }, block_id))
+        if (not world_of(conn).try_change_block({ packet.x, packet.y, packet.z }, block_id))
             goto REVERT_BLOCK;
 
         return error::code::success;
@@ -142,12 +186,24 @@ namespace net
     {
         net::PacketChatMessage packet(packet_data.data());
 
+        // world commands are handled by the game server.
+        if (packet.message == "/world" || packet.message.starts_with("/world ")) {
+            handle_world_command(conn, packet.message);
+            return error::code::success;
+        }
+
+        if (packet.message.starts_with("/trace ")) {
+            handle_trace_command(conn, packet.message);
+            return error::code::success;
+        }
+
         if (not packet.is_commmand_message())
-            world.try_add_common_chat(packet_data);
+            world_of(conn).try_add_common_chat(packet_data);
 
-        // send chat message to the login server.
+        // send chat message to the chat server.
         protocol::ChatCommandRequest chat_command_msg;
         chat_command_msg.mutable_message()->append(packet.message);
+        chat_command_msg.set_sender_connection_key(conn.connection_key().raw());
         if (auto player = conn.associated_player())
             chat_command_msg.mutable_sender_player_name()->append(player->username());
 
@@ -203,6 +259,9 @@ namespace net
         if (not request.parse_message(msg))
             co_return;
 
+        // connections and players are touched by event threads only, not by udp and database threads.
+        co_await io::resume_on(io_service);
+
         auto connection_key = msg.connection_key();
 
         if (auto conn = connection_env.try_acquire_connection(connection_key)) {
@@ -211,6 +270,7 @@ namespace net
             if (msg.error_code() == error::code::packet::player_not_exist) {
                 player->set_player_type(game::player_type_id::guest);
                 player->transit_state();
+                notify_player_login(*player, connection_key);
                 co_return;
             }
             else if (msg.error_code() != error::code::success) {
@@ -220,13 +280,23 @@ namespace net
 
             player->set_player_type(game::player_type_id(msg.player_type()));
             player->set_uuid(msg.player_uuid());
+            notify_player_login(*player, connection_key);
 
             // Disconnect already logged in player.
             if (auto prev_conn = connection_env.try_acquire_connection(msg.prev_connection_key()))
                 prev_conn->kick(error::code::packet::player_already_login);
         }
 
-        // Load player game data.
+        // Load player game data. (the cache has data which may not be saved yet)
+        if (auto cached_gamedata = ::database::player_gamedata_cache().find(msg.player_uuid())) {
+            if (auto conn = connection_env.try_acquire_connection(connection_key)) {
+                auto player = conn->associated_player();
+                player->set_gamedata(*cached_gamedata);
+                player->transit_state();
+            }
+            co_return;
+        }
+
         auto [err, result] = co_await ::database::CouchbaseCore::get_document(::database::CollectionPath::player_gamedata, msg.player_uuid());
 
         if (auto conn = connection_env.try_acquire_connection(connection_key)) {
@@ -246,8 +316,38 @@ namespace net
         }
     }
 
+    io::DetachedTask GameServer::handle_chat_command_response_message(MessageRequest& request)
+    {
+        protocol::ChatCommandResponse msg;
+        if (not request.parse_message(msg))
+            co_return;
+
+        co_await io::resume_on(io_service);
+
+        if (auto conn = connection_env.try_acquire_connection(msg.receiver_connection_key())) {
+            net::PacketChatMessage packet(msg.message());
+            conn->io()->send_packet(packet);
+        }
+    }
+
+    void GameServer::notify_player_login(const game::Player& player, net::ConnectionKey connection_key)
+    {
+        auto& conf = config::get_config();
+
+        protocol::PlayerLoginRequest login_msg;
+        login_msg.mutable_username()->append(player.username());
+        login_msg.set_connection_key(connection_key.raw());
+        login_msg.mutable_game_server()->set_ip(conf.udp_server().ip());
+        login_msg.mutable_game_server()->set_port(conf.udp_server().port());
+
+        net::MessageRequest request(net::message_id::player_login, login_msg);
+        udp_server.communicator().send_to(request, protocol::server_type_id::chat);
+    }
+
     void GameServer::tick()
     {
+        TRACE_SPAN("GameServer::tick");
+
         ConnectionIO::flush_send(connection_env);
         ConnectionIO::flush_receive(connection_env);
 
@@ -278,10 +378,6 @@ namespace net
         comm.fetch_server_address(protocol::server_type_id::login);
         comm.fetch_server_address(protocol::server_type_id::chat);
 
-        // Create working directories
-        if (not std::filesystem::exists(conf.world().save_dir()))
-            std::filesystem::create_directories(conf.world().save_dir());
-
         return true;
     }
 
@@ -297,35 +393,179 @@ namespace net
         // start network I/O system.
         tcp_server.start_network_io_service(conf.tcp_server().ip(), conf.tcp_server().port(), conf.system().num_of_processors() * 2);
 
-        // load world map.
-        world.load_filesystem_world(conf.world().save_dir());
+        // load world maps.
+        worlds[game::default_world_id]->load_filesystem_world(conf.world());
+        for (int i = 0; i < conf.extra_worlds_size(); i++)
+            worlds[i + 1]->load_filesystem_world(conf.extra_worlds(i));
+
+        tick_loop.add_phase("interval_tasks", game_server_tick_budget::interval_tasks_us,
+            [this] { interval_tasks.process_tasks(); });
+        tick_loop.add_phase("flush_io", game_server_tick_budget::flush_io_us,
+            [this] { this->tick(); });
+        tick_loop.add_phase("world_tick", game_server_tick_budget::world_tick_us,
+            [this] { 
+                for (auto& world : worlds)
+                    world->tick();
+            });
+        tick_loop.add_phase("world_dispatch", game_server_tick_budget::world_dispatch_us,
+            [this] {
+                for (auto& world : worlds)
+                    world->dispatch_tasks();
+            });
+
+        tick_loop.run();
+    }
 
-        while (1) {
-            std::size_t start_tick = util::current_monotonic_tick();
+    void GameServer::report_tick_statistics()
+    {
+        tick_loop.log_statistics();
+        tick_loop.reset_statistics();
 
-            interval_tasks.process_tasks();
+        for (auto& world : worlds)
+            world->report_task_statistics();
+    }
 
-            this->tick();
+    void GameServer::export_metrics()
+    {
+        metrics_exporter.export_snapshot();
+    }
 
-            world.tick(io_service);
+    void GameServer::flush_player_gamedata()
+    {
+        database::player_gamedata_cache().flush();
+    }
+
+    game::World& GameServer::world_of(net::Connection& conn)
+    {
+        auto player = conn.associated_player();
+        auto world_id = player ? player->world_id() : game::default_world_id;
+
+        return world_id < worlds.size() ? *worlds[world_id] : *worlds[game::default_world_id];
+    }
+
+    game::World* GameServer::find_world(std::string_view name)
+    {
+        for (auto& world : worlds) {
+            if (world->name() == name)
+                return world.get();
+        }
+        return nullptr;
+    }
+
+    void GameServer::handle_world_command(net::Connection& conn, std::string_view command)
+    {
+        auto player = conn.associated_player();
+        if (not player)
+            return;
+
+        auto reply = [&conn](std::string_view message) {
+            net::PacketChatMessage reply_packet(message);
+            conn.io()->send_packet(reply_packet);
+        };
+
+        // "/world" lists all worlds.
+        auto world_name = command.size() > 7 ? command.substr(7) : std::string_view{};
+        if (world_name.empty()) {
+            std::string world_list = "Worlds:";
+            for (auto& world : worlds)
+                world_list.append(" ").append(world->name());
+
+            reply(world_list);
+            return;
+        }
+
+        auto target_world = find_world(world_name);
+        if (not target_world) {
+            reply("Unknown world");
+            return;
+        }
+
+        // only spawned players can move to another world.
+        if (player->state() != game::PlayerState::spawned || player->world_id() == target_world->world_id())
+            return;
+
+        // the world moves the player on its tick, not to race with the state transitions.
+        world_of(conn).request_world_transfer(*player, *target_world);
+    }
+
+    void GameServer::handle_trace_command(net::Connection& conn, std::string_view command)
+    {
+        auto player = conn.associated_player();
+        if (not player || player->player_type() != game::player_type_id::admin)
+            return;
+
+        auto reply = [&conn](std::string_view message) {
+            net::PacketChatMessage reply_packet(message);
+            conn.io()->send_packet(reply_packet);
+        };
+
+        auto action = command.substr(7);
 
-            std::size_t end_tick = util::current_monotonic_tick();
+        // the last session is being written, so a new one would discard its events.
+        if (is_trace_exporting.load(std::memory_order_acquire)) {
+            reply("The trace file is being written");
+            return;
+        }
+
+        if (action == "start") {
+            metrics::trace::start();
+            reply("Tracing started");
+            return;
+        }
 
-            if (auto diff = end_tick - start_tick; diff < 100)
-                util::sleep_ms(std::max(100 - diff, std::size_t(30)));
+        if (action != "stop" || not metrics::trace::is_enabled()) {
+            reply("Usage: /trace start|stop");
+            return;
         }
+
+        metrics::trace::stop();
+
+        // writing the file takes a while, so it is done off the event thread not to stall connections.
+        is_trace_exporting.store(true, std::memory_order_relaxed);
+        trace_export_thread = std::jthread([this, connection_key = conn.connection_key()] {
+            export_trace(connection_key);
+        });
+    }
+
+    void GameServer::export_trace(net::ConnectionKey requester)
+    {
+        auto reply = [this, requester](std::string_view message) {
+            if (auto connection_io = connection_env.try_acquire_connection_io(requester)) {
+                net::PacketChatMessage reply_packet(message);
+                connection_io->send_packet(reply_packet);
+            }
+        };
+
+        auto trace_path = std::filesystem::path(config::get_config().metrics().trace_dir())
+            / ("trace_" + std::to_string(util::current_timestmap()) + ".json");
+
+        std::ofstream trace_file(trace_path, std::ios::binary);
+        if (not trace_file || not metrics::trace::write_chrome_trace(trace_file)) {
+            CONSOLE_LOG(error) << "Fail to write trace file: " << trace_path.string();
+            is_trace_exporting.store(false, std::memory_order_release);
+            reply("Fail to write the trace file");
+            return;
+        }
+        trace_file.close();
+
+        LOG(info) << "Trace file is written: " << trace_path.string()
+                  << " (dropped events: " << metrics::trace::num_of_dropped_events() << ')';
+        is_trace_exporting.store(false, std::memory_order_release);
+        reply("Trace file is written: " + trace_path.filename().string());
     }
 
     void GameServer::on_disconnect(net::Connection& conn)
     {
         if (auto player = conn.associated_player()) {
-            // notify logout event to the login server.
+            // notify logout event to the login and chat server.
             if (player->state() >= game::PlayerState::handshaked) {
                 protocol::PlayerLogoutRequest logout_msg;
                 logout_msg.mutable_username()->append(player->username());
+                logout_msg.set_connection_key(conn.connection_key().raw());
 
                 net::MessageRequest request(net::message_id::player_logout, logout_msg);
                 udp_server.communicator().send_to(request, protocol::server_type_id::login);
+                udp_server.communicator().send_to(request, protocol::server_type_id::chat);
             }
         }
     }
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
 #include "game/world.h"
 
 #include "net/connection.h"
@@ -10,6 +15,9 @@
 
 #include "database/couchbase_core.h"
 
+#include "metrics/metrics_exporter.h"
+
+#include "util/fixed_rate_loop.h"
 #include "util/interval_task.h"
 
 namespace net
@@ -18,6 +26,14 @@ namespace net
         constexpr std::size_t chat_message        = 1 * 1000; // 1 seconds.
     }
 
+    namespace game_server_tick_budget {
+        constexpr std::size_t tick_interval_ms    = 100;
+        constexpr std::size_t interval_tasks_us   = 5 * 1000;
+        constexpr std::size_t flush_io_us         = 30 * 1000;
+        constexpr std::size_t world_tick_us       = 10 * 1000;
+        constexpr std::size_t world_dispatch_us   = 5 * 1000;
+    }
+
     class GameServer : public net::PacketHandler, net::MessageHandler
     {
     public:
@@ -31,6 +47,12 @@ namespace net
 
         void announce_server();
 
+        void report_tick_statistics();
+
+        void export_metrics();
+
+        void flush_player_gamedata();
+
         bool initialize(const char* router_ip, int router_port);
 
         void serve_forever(const char* router_ip, int router_port);
@@ -59,14 +81,32 @@ namespace net
 
         error::ResultCode handle_ext_entry_packet(net::Connection&, util::byte_view packet_data);
 
+        // "/world <name>" moves the player to another world.
+        void handle_world_command(net::Connection&, std::string_view command);
+
+        // "/trace start|stop" captures trace spans into a Chrome trace file. (admin only)
+        void handle_trace_command(net::Connection&, std::string_view command);
+
+        // writes the last trace session to a file and replies to the requester. (runs on trace_export_thread)
+        void export_trace(net::ConnectionKey requester);
+
         /* Message handlers */
 
         virtual bool handle_message(net::MessageRequest&) override;
 
         io::DetachedTask handle_handshake_response_message(MessageRequest&);
 
+        io::DetachedTask handle_chat_command_response_message(MessageRequest&);
+
     private:
 
+        // notifies the chat server where the player is, so whispers can be routed.
+        void notify_player_login(const game::Player&, net::ConnectionKey);
+
+        game::World& world_of(net::Connection&);
+
+        game::World* find_world(std::string_view name);
+
         net::ConnectionEnvironment connection_env;
 
         io::RegisteredIO io_service;
@@ -74,8 +114,18 @@ namespace net
         net::TcpServer tcp_server;
         net::UdpServer udp_server;
 
-        game::World world;
+        // worlds[world id]. the first one is the default world.
+        std::vector<std::unique_ptr<game::World>> worlds;
+
+        metrics::Exporter metrics_exporter;
 
         util::IntervalTaskScheduler<GameServer> interval_tasks;
+
+        util::FixedRateLoop tick_loop;
+
+        std::atomic<bool> is_trace_exporting{ false };
+
+        // declared last to be joined before the other members are destroyed.
+        std::jthread trace_export_thread;
     };
 }
\ No newline at end of file
@@ -21,6 +21,10 @@ namespace net
             packet_handshake,
             player_logout,
 
+            // Chat server message (appended, not to renumber the ids above)
+            chat_command_response,
+            player_login,
+
             size,
         };
     }
@@ -195,45 +195,70 @@ namespace net
 
     bool PacketLevelInit::serialize(io::IoEventData& event_data) const
     {
-        std::byte buf[packet_size];
+        std::byte buf[fast_map_packet_size];
 
         std::byte* buf_start = buf;
         PacketStructure::write_byte(buf_start, id);
+
+        if (fast_map)
+            PacketStructure::write_int(buf_start, map_volume);
         
-        return event_data.push(buf, sizeof(buf));
+        return event_data.push(buf, fast_map ? fast_map_packet_size : packet_size);
     }
 
-    std::size_t PacketLevelDataChunk::serialize(std::unique_ptr<std::byte[]>& serialized_data)
+    std::size_t PacketLevelDataChunk::serialize(std::unique_ptr<std::byte[]>& data)
     {
-        auto data_capacity = max_chunk_count * (chunk_size + 4) + 7; // LevelData + LevelFinalize 
-        serialized_data.reset(new std::byte[data_capacity]);
+        while (not serialize_chunks(max_chunk_count));
 
-        std::byte* buf_start = serialized_data.get();
+        return release(data);
+    }
+
+    bool PacketLevelDataChunk::serialize_chunks(std::size_t max_num_of_chunks)
+    {
+        if (not serialized_data) {
+            auto data_capacity = max_chunk_count * (chunk_size + 4) + 7; // LevelData + LevelFinalize
+            serialized_data.reset(new std::byte[data_capacity]);
+        }
+
+        for (std::size_t i = 0; i < max_num_of_chunks && not is_finished; i++) {
+            std::byte* buf_start = serialized_data.get() + serialized_size;
+
+            auto remain_bytes = compressor.deflate_n(buf_start + 3, chunk_size);
+            if (remain_bytes == chunk_size) {
+                // write level finalize information.
+                PacketStructure::write_byte(buf_start, packet_type_id::level_finalize);
+                PacketStructure::write_short(buf_start, x);
+                PacketStructure::write_short(buf_start, y);
+                PacketStructure::write_short(buf_start, z);
+
+                serialized_size = buf_start - serialized_data.get();
+                is_finished = true;
+                break;
+            }
 
-        auto remain_bytes = 0;
-        while ((remain_bytes = compressor.deflate_n(buf_start + 3, chunk_size)), remain_bytes != chunk_size) {
             PacketStructure::write_byte(buf_start, id);
 
             // write chunk length.
             PacketStructure::write_short(buf_start, PacketFieldType::Short(chunk_size - remain_bytes));
 
-            // write chunk data (already written)
+            // write chunk data (already written) and null padding.
+            std::memset(buf_start + chunk_size - remain_bytes, 0, remain_bytes);
             buf_start += chunk_size;
 
             // write percent complete
             PacketStructure::write_byte(buf_start, 0);
-        }
 
-        // add null padding
-        std::memset(buf_start - remain_bytes - 1, 0, remain_bytes != chunk_size ? remain_bytes : 0);
+            serialized_size = buf_start - serialized_data.get();
+        }
 
-        // write level finalize information.
-        PacketStructure::write_byte(buf_start, packet_type_id::level_finalize);
-        PacketStructure::write_short(buf_start, x);
-        PacketStructure::write_short(buf_start, y);
-        PacketStructure::write_short(buf_start, z);
+        return is_finished;
+    }
 
-        return buf_start - serialized_data.get();
+    std::size_t PacketLevelDataChunk::release(std::unique_ptr<std::byte[]>& data)
+    {
+        assert(is_finished);
+        data = std::move(serialized_data);
+        return serialized_size;
     }
 
     bool PacketSetBlockClient::serialize(io::IoEventData& event_data) const
@@ -396,9 +421,9 @@ namespace net
     }
 
     PacketLevelDataChunk::PacketLevelDataChunk
-        (std::byte* block_data, unsigned block_data_size, PacketFieldType::Short width, PacketFieldType::Short height, PacketFieldType::Short length)
+        (std::byte* block_data, unsigned block_data_size, PacketFieldType::Short width, PacketFieldType::Short height, PacketFieldType::Short length, bool fast_map)
         : Packet{ packet_type_id::level_datachunk }
-        , compressor{ block_data, block_data_size }
+        , compressor{ block_data, block_data_size, fast_map }
         , x{ width }, y{ height }, z{ length }
     {
         max_chunk_count = (compressor.deflate_bound() - 1) / chunk_size + 1;
@@ -108,11 +108,22 @@ namespace net
     {
         static constexpr net::packet_type_id::value packet_id = net::packet_type_id::level_initialize;
         static constexpr std::size_t packet_size = 1;
+        static constexpr std::size_t fast_map_packet_size = 5;
+
+        // FastMap extension appends the map volume instead of the level data prefix.
+        bool fast_map = false;
+        PacketFieldType::Int map_volume = 0;
 
         PacketLevelInit()
             : Packet{ packet_id }
         { }
 
+        PacketLevelInit(PacketFieldType::Int volume)
+            : Packet{ packet_id }
+            , fast_map{ true }
+            , map_volume{ volume }
+        { }
+
         bool serialize(io::IoEventData&) const;
     };
 
@@ -126,12 +137,24 @@ namespace net
         PacketFieldType::Short y;
         PacketFieldType::Short z;
 
-        PacketLevelDataChunk(std::byte* block_data, unsigned block_data_size, PacketFieldType::Short, PacketFieldType::Short, PacketFieldType::Short);
+        // fast_map: block data is compressed as raw deflate stream for FastMap extension clients.
+        PacketLevelDataChunk(std::byte* block_data, unsigned block_data_size, PacketFieldType::Short, PacketFieldType::Short, PacketFieldType::Short,
+                             bool fast_map = false);
 
         std::size_t serialize(std::unique_ptr<std::byte[]>&);
+
+        // resumable serialization. returns true if all chunks and level finalize packet are serialized.
+        bool serialize_chunks(std::size_t max_num_of_chunks);
+
+        // take serialized data after serialize_chunks() returns true.
+        std::size_t release(std::unique_ptr<std::byte[]>&);
         
     private:
         util::Compressor compressor;
+
+        std::unique_ptr<std::byte[]> serialized_data;
+        std::size_t serialized_size = 0;
+        bool is_finished = false;
     };
 
     struct PacketSetBlockClient : Packet
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "packet_extension.h"
 
+#include <algorithm>
+#include <cstring>
 #include <unordered_map>
 
 namespace
@@ -14,8 +16,10 @@ namespace
     };
 
     const std::unordered_map<std::string_view, CpeInfo> supported_cpe_map = {
-        {"MessageTypes", {net::packet_type_id::ext_message, 1}},
-        {"TwoWayPing",   {net::packet_type_id::two_way_ping, 1}}
+        {"MessageTypes",    {net::packet_type_id::ext_message, 1}},
+        {"TwoWayPing",      {net::packet_type_id::two_way_ping, 1}},
+        {"BulkBlockUpdate", {net::packet_type_id::bulk_block_update, 1}},
+        {"FastMap",         {net::packet_type_id::level_initialize, 1}}
     };
 }
 
@@ -102,4 +106,41 @@ namespace net
 
         return event_data.push(buf, sizeof(buf));
     }
+
+    std::size_t PacketBulkBlockUpdate::serialize(const std::vector<game::BlockHistoryRecord>& records, int map_width, int map_length, std::unique_ptr<std::byte[]>& serialized_data)
+    {
+        const auto num_of_packets = (records.size() + max_block_count - 1) / max_block_count;
+        const auto data_size = num_of_packets * packet_size;
+        serialized_data.reset(new std::byte[data_size]);
+
+        std::byte* buf_start = serialized_data.get();
+
+        for (std::size_t offset = 0; offset < records.size(); offset += max_block_count) {
+            const auto block_count = std::min(records.size() - offset, max_block_count);
+
+            std::byte* index_buf = buf_start + 2;
+            std::byte* block_buf = index_buf + max_block_count * sizeof(PacketFieldType::Int);
+
+            PacketStructure::write_byte(buf_start, packet_id);
+            PacketStructure::write_byte(buf_start, PacketFieldType::Byte(block_count - 1));
+
+            for (std::size_t i = 0; i < block_count; i++) {
+                auto& record = records[offset + i];
+                int x = _byteswap_ushort(record.x);
+                int y = _byteswap_ushort(record.y);
+                int z = _byteswap_ushort(record.z);
+
+                PacketStructure::write_int(index_buf, PacketFieldType::Int((y * map_length + z) * map_width + x));
+                *block_buf++ = record.block_id;
+            }
+
+            // the client reads only (block count) entries, but unused fields are zeroed.
+            std::memset(index_buf, 0, (max_block_count - block_count) * sizeof(PacketFieldType::Int));
+            std::memset(block_buf, 0, max_block_count - block_count);
+
+            buf_start += packet_size - 2;
+        }
+
+        return data_size;
+    }
 }
\ No newline at end of file
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <string_view>
+#include <vector>
+
 #include "packet.h"
+#include "game/history_buffer.h"
 
 namespace net
 {
@@ -50,6 +54,16 @@ namespace net
         void parse(const std::byte* buf_start);
     };
 
+    struct PacketBulkBlockUpdate : Packet
+    {
+        static constexpr net::packet_type_id::value packet_id = packet_type_id::bulk_block_update;
+        static constexpr std::size_t packet_size = 1282;
+        static constexpr std::size_t max_block_count = 256;
+
+        // serialize set block records into the least number of bulk block update packets.
+        static std::size_t serialize(const std::vector<game::BlockHistoryRecord>&, int map_width, int map_length, std::unique_ptr<std::byte[]>&);
+    };
+
     struct PacketTwoWayPing : Packet
     {
         static constexpr net::packet_type_id::value packet_id = packet_type_id::two_way_ping;
@@ -102,12 +116,12 @@ namespace net
 
         void set_request_time()
         {
-            request_time = util::current_time_ns();
+            request_time = util::fine_time_ns();
         }
 
         std::size_t get_rtt_ns() const
         {
-            return util::current_time_ns() - request_time;
+            return util::fine_time_ns() - request_time;
         }
 
         void parse(const std::byte* buf_start);
@@ -77,6 +77,15 @@ namespace net
             return request.flush_send();
         }
 
+        // sends to a server which is not registered. (e.g. one of game servers)
+        bool send_to(net::MessageRequest& request, const net::IPAddress& server_address)
+        {
+            request.set_requester(_source.get_handle());
+            request.set_request_address(server_address);
+
+            return request.flush_send();
+        }
+
         static auto send_message_reliably(const net::MessageRequest&, int retry_count = std::numeric_limits<int>::max())
             -> std::pair<bool, net::MessageRequest>;
 
@@ -31,7 +31,7 @@ namespace net
 
     net::ConnectionKey TcpServer::new_connection(win::UniqueSocket &&client_sock)
     {
-        auto connection_key = ConnectionKey(connection_env.get_unused_connection_id(), util::current_monotonic_tick32());
+        auto connection_key = ConnectionKey(connection_env.get_unused_connection_id(), std::uint32_t(util::coarse_monotonic_tick()));
 
         std::unique_ptr<net::Connection> connection_ptr(new net::Connection(
             packet_handle_server,
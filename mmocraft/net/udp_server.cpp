@@ -5,6 +5,8 @@
 #include "config/config.h"
 #include "config/constants.h"
 #include "logging/logger.h"
+#include "metrics/metrics.h"
+#include "util/time_util.h"
 
 namespace net
 {
@@ -60,6 +62,8 @@ namespace net
             if (not request.read_message())
                 continue;
 
+            util::update_coarse_monotonic_tick();
+
             // handle message and send reply.
             handle_message(request);
         }
@@ -67,12 +71,20 @@ namespace net
 
     bool UdpServer::handle_message(net::MessageRequest& request)
     {
+        static auto& num_of_messages = metrics::counter("mmocraft_udp_messages_total", "UDP messages received.");
+        static auto& num_of_failures = metrics::counter("mmocraft_udp_message_failures_total", "UDP messages which were not handled.");
+        static auto& handle_duration = metrics::histogram("mmocraft_udp_message_duration_us", "Time to handle a UDP message.");
+
+        num_of_messages.add();
+        metrics::ScopedTimer handle_timer{ handle_duration };
+
         // invoke common message handlers first.
 
         auto common_handler_success = _communicator.handle_common_message(request);
 
         if (not common_handler_success.value_or(true)) {
             CONSOLE_LOG(error) << "Common handler failed" << request.message_id();
+            num_of_failures.add();
             return false;
         }
 
@@ -82,6 +94,7 @@ namespace net
             return true;
 
         CONSOLE_LOG(error) << "Fail to handle message: " << request.message_id();
+        num_of_failures.add();
         return false;
     }
 }
\ No newline at end of file
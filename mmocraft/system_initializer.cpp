@@ -10,6 +10,8 @@
 #include "net/server_communicator.h"
 #include "database/couchbase_core.h"
 #include "logging/logger.h"
+#include "util/time_util.h"
+#include "win/virtual_memory.h"
 
 namespace
 {
@@ -46,6 +48,8 @@ namespace setup
 
         net::Socket::initialize_system();
 
+        util::calibrate_fine_clock();
+
         // Load config from the route server.
         if (not net::ServerCommunicator::load_remote_config(router_ip, router_port, protocol::server_type_id::game, config::get_config()))
             return;
@@ -53,7 +57,12 @@ namespace setup
         auto& conf = config::get_config();
         config::set_default_configuration(*conf.mutable_system());
 
-        logging::initialize_system(conf.log().log_dir(), conf.log().log_filename());
+        win::set_default_memory_options({
+            .huge_pages = conf.system().huge_pages(),
+            .numa_node = conf.system().bind_numa_node() ? int(conf.system().numa_node()) : win::any_numa_node
+        });
+
+        logging::initialize_system(conf.log().log_dir(), conf.log().log_filename(), conf.log().binary_format());
 
         database::CouchbaseCore::connect_server_with_login(conf.player_database());
     }
@@ -28,7 +28,7 @@ namespace util
         return dest;
     }
 
-    Compressor::Compressor(std::byte* block_data, unsigned block_data_size)
+    Compressor::Compressor(std::byte* block_data, unsigned block_data_size, bool raw_deflate)
     {
         zstm.zalloc = Z_NULL;
         zstm.zfree = Z_NULL;
@@ -36,12 +36,20 @@ namespace util
         zstm.next_in = reinterpret_cast<z_const Bytef*>(block_data);
         zstm.avail_in = ::uInt(block_data_size);
 
-        if (deflateInit2(&zstm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 | MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+        const int window_bits = raw_deflate ? -MAX_WBITS : 16 | MAX_WBITS;
+
+        if (deflateInit2(&zstm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
             return;
 
         max_compressed_size = deflateBound(&zstm, zstm.avail_in);
     }
 
+    Compressor::~Compressor()
+    {
+        if (max_compressed_size)
+            deflateEnd(&zstm);
+    }
+
     unsigned Compressor::deflate_n(std::byte* dest, unsigned avail_size)
     {
         zstm.next_out = reinterpret_cast<z_const Bytef*>(dest);
@@ -11,7 +11,10 @@ namespace util
     class Compressor
     {
     public:
-        Compressor(std::byte* data, unsigned data_size);
+        // raw_deflate: produce a raw deflate stream without gzip header and trailer.
+        Compressor(std::byte* data, unsigned data_size, bool raw_deflate = false);
+
+        ~Compressor();
 
         std::size_t deflate_bound() const
         {
@@ -0,0 +1,170 @@
+#include "pch.h"
+#include "fixed_rate_loop.h"
+
+#include <cassert>
+#include <string>
+#include <thread>
+
+#include "logging/logger.h"
+#include "metrics/trace.h"
+#include "util/time_util.h"
+
+namespace
+{
+    std::size_t to_microseconds(util::FixedRateLoop::clock::duration duration)
+    {
+        return std::size_t(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    }
+}
+
+namespace util
+{
+    FixedRateLoop::FixedRateLoop(std::size_t tick_interval_ms)
+        : tick_interval{ std::chrono::milliseconds(tick_interval_ms) }
+        , tick_duration_metric{ metrics::histogram("mmocraft_tick_duration_us", "Time spent in a tick.") }
+        , tick_duration_baseline{ tick_duration_metric.snapshot() }
+    {
+        waitable_timer = ::CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+        // high resolution timer is not supported before Windows 10 1803.
+        if (waitable_timer == NULL)
+            waitable_timer = ::CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+    }
+
+    FixedRateLoop::~FixedRateLoop()
+    {
+        if (waitable_timer)
+            ::CloseHandle(waitable_timer);
+    }
+
+    void FixedRateLoop::add_phase(std::string_view name, std::size_t budget_us, std::function<void()>&& func)
+    {
+        assert(_num_of_phases < max_num_of_phases);
+
+        auto& phase = phases[_num_of_phases++];
+        phase.name = name;
+        phase.budget_us = budget_us;
+        phase.func = std::move(func);
+
+        auto labels = "{phase=\"" + std::string(name) + "\"}";
+        phase.duration_metric = &metrics::histogram("mmocraft_tick_phase_duration_us" + labels, "Time spent in the tick phase.");
+        phase.overruns_metric = &metrics::counter("mmocraft_tick_phase_overruns_total" + labels, "Ticks in which the phase exceeded its budget.");
+        phase.duration_baseline = phase.duration_metric->snapshot();
+    }
+
+    void FixedRateLoop::run()
+    {
+        _is_running.store(true, std::memory_order_relaxed);
+
+        auto next_tick_at = now();
+
+        while (_is_running.load(std::memory_order_relaxed)) {
+            run_tick();
+
+            next_tick_at += tick_interval;
+
+            const auto current = now();
+            if (current < next_tick_at) {
+                sleep_until(next_tick_at);
+                continue;
+            }
+
+            // the tick overran. run next ticks immediately to catch up,
+            // but drop the backlog if it is too long to recover.
+            _num_of_overrun_ticks.fetch_add(1, std::memory_order_relaxed);
+
+            if (auto lag_ticks = std::size_t((current - next_tick_at) / tick_interval); lag_ticks > max_catch_up_ticks) {
+                _num_of_dropped_ticks.fetch_add(lag_ticks, std::memory_order_relaxed);
+                next_tick_at = current;
+            }
+        }
+    }
+
+    void FixedRateLoop::run_tick()
+    {
+        TRACE_SPAN("tick");
+        util::update_coarse_monotonic_tick();
+
+        const auto tick_start_at = now();
+        auto phase_start_at = tick_start_at;
+
+        for (std::size_t index = 0; index < _num_of_phases; index++) {
+            auto& phase = phases[index];
+            TRACE_SPAN(phase.name);
+
+            try {
+                phase.func();
+            }
+            catch (...) {
+                LOG(error) << "Exception occured at tick phase " << phase.name;
+            }
+
+            const auto phase_end_at = now();
+            const auto elapsed_us = to_microseconds(phase_end_at - phase_start_at);
+
+            phase.duration_metric->record(elapsed_us);
+            if (phase.budget_us && elapsed_us > phase.budget_us) {
+                phase.num_of_overruns.fetch_add(1, std::memory_order_relaxed);
+                phase.overruns_metric->add();
+            }
+
+            phase_start_at = phase_end_at;
+        }
+
+        tick_duration_metric.record(to_microseconds(phase_start_at - tick_start_at));
+        _num_of_ticks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void FixedRateLoop::sleep_until(clock::time_point deadline)
+    {
+        // sleep coarsely, then spin the rest.
+        if (auto sleep_duration = deadline - clock::now() - spin_duration; sleep_duration > clock::duration::zero()) {
+            // relative time in 100 nanoseconds.
+            LARGE_INTEGER due_time;
+            due_time.QuadPart = -LONGLONG(std::chrono::duration_cast<std::chrono::nanoseconds>(sleep_duration).count() / 100);
+
+            if (waitable_timer && ::SetWaitableTimer(waitable_timer, &due_time, 0, NULL, NULL, FALSE))
+                ::WaitForSingleObject(waitable_timer, INFINITE);
+            else
+                std::this_thread::sleep_for(sleep_duration);
+        }
+
+        while (clock::now() < deadline)
+            std::this_thread::yield();
+    }
+
+    void FixedRateLoop::log_statistics() const
+    {
+        const auto ticks = tick_durations();
+        LOG(info) << "Tick statistics: ticks=" << num_of_ticks()
+            << " overruns=" << num_of_overrun_ticks()
+            << " dropped=" << num_of_dropped_ticks()
+            << " mean=" << ticks.mean() << "us"
+            << " p99=" << ticks.percentile(99) << "us"
+            << " max=" << ticks.percentile(100) << "us";
+
+        for (std::size_t index = 0; index < _num_of_phases; index++) {
+            auto& phase = phases[index];
+            const auto durations = phase_durations(index);
+            LOG(info) << "  phase " << phase.name << ": budget=" << phase.budget_us << "us"
+                << " overruns=" << phase.num_of_overruns.load(std::memory_order_relaxed)
+                << " mean=" << durations.mean() << "us"
+                << " p50=" << durations.percentile(50) << "us"
+                << " p99=" << durations.percentile(99) << "us"
+                << " max=" << durations.percentile(100) << "us";
+        }
+    }
+
+    void FixedRateLoop::reset_statistics()
+    {
+        for (std::size_t index = 0; index < _num_of_phases; index++) {
+            phases[index].duration_baseline = phases[index].duration_metric->snapshot();
+            phases[index].num_of_overruns.store(0, std::memory_order_relaxed);
+        }
+
+        tick_duration_baseline = tick_duration_metric.snapshot();
+        _num_of_ticks.store(0, std::memory_order_relaxed);
+        _num_of_overrun_ticks.store(0, std::memory_order_relaxed);
+        _num_of_dropped_ticks.store(0, std::memory_order_relaxed);
+    }
+}
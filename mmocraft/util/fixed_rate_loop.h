@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string_view>
+
+#include "metrics/metrics.h"
+#include "util/noncopyable.h"
+#include "win/win_type.h"
+
+namespace util
+{
+    // FixedRateLoop runs registered phases in order at a fixed tick rate.
+    // 
+    // - ticks are scheduled at absolute deadlines, so the tick rate dose not drift with load.
+    // - sleeps with a high resolution waitable timer and spins the last moment for precision.
+    // - overrun ticks are caught up immediately (up to max_catch_up_ticks, the rest are dropped).
+    // - each phase has its own time budget and records durations into a metrics histogram.
+    class FixedRateLoop : util::NonCopyable, util::NonMovable
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        static constexpr std::size_t max_num_of_phases = 8;
+        static constexpr std::size_t max_catch_up_ticks = 4;
+        static constexpr auto spin_duration = std::chrono::microseconds(1000);
+
+        struct Phase
+        {
+            std::string_view name;
+            std::size_t budget_us = 0;
+            std::function<void()> func;
+
+            std::atomic<std::size_t> num_of_overruns{ 0 };
+
+            metrics::Histogram* duration_metric = nullptr;
+            metrics::Counter* overruns_metric = nullptr;
+
+            // the metrics are shared by loops and never reset, so statistics are taken since the baseline.
+            metrics::Histogram::Snapshot duration_baseline;
+        };
+
+        FixedRateLoop(std::size_t tick_interval_ms);
+
+        virtual ~FixedRateLoop();
+
+        void add_phase(std::string_view name, std::size_t budget_us, std::function<void()>&& func);
+
+        // run phases forever. (or until stop() is invoked)
+        void run();
+
+        void stop()
+        {
+            _is_running.store(false, std::memory_order_relaxed);
+        }
+
+        /* Statistics */
+
+        std::size_t num_of_phases() const
+        {
+            return _num_of_phases;
+        }
+
+        const Phase& phase(std::size_t index) const
+        {
+            return phases[index];
+        }
+
+        // durations (microseconds) since the last reset_statistics().
+        metrics::Histogram::Snapshot phase_durations(std::size_t index) const
+        {
+            return phases[index].duration_metric->snapshot() - phases[index].duration_baseline;
+        }
+
+        metrics::Histogram::Snapshot tick_durations() const
+        {
+            return tick_duration_metric.snapshot() - tick_duration_baseline;
+        }
+
+        std::size_t num_of_ticks() const
+        {
+            return _num_of_ticks.load(std::memory_order_relaxed);
+        }
+
+        std::size_t num_of_overrun_ticks() const
+        {
+            return _num_of_overrun_ticks.load(std::memory_order_relaxed);
+        }
+
+        std::size_t num_of_dropped_ticks() const
+        {
+            return _num_of_dropped_ticks.load(std::memory_order_relaxed);
+        }
+
+        void log_statistics() const;
+
+        void reset_statistics();
+
+    protected:
+        // the time source of the loop. (overridden by tests to run ticks on a manual clock)
+        virtual clock::time_point now() const
+        {
+            return clock::now();
+        }
+
+        virtual void sleep_until(clock::time_point);
+
+    private:
+        void run_tick();
+
+        const clock::duration tick_interval;
+
+        std::array<Phase, max_num_of_phases> phases;
+        std::size_t _num_of_phases = 0;
+
+        metrics::Histogram& tick_duration_metric;
+        metrics::Histogram::Snapshot tick_duration_baseline;
+
+        std::atomic<std::size_t> _num_of_ticks{ 0 };
+        std::atomic<std::size_t> _num_of_overrun_ticks{ 0 };
+        std::atomic<std::size_t> _num_of_dropped_ticks{ 0 };
+
+        std::atomic<bool> _is_running{ false };
+
+        win::Handle waitable_timer = NULL;
+    };
+}
@@ -24,6 +24,10 @@ namespace util
 
             // Interval server task
             announce_server,
+            report_tick_statistics,
+            export_metrics,
+            flush_player_gamedata,
+            flush_chat_log,
 
             // Size of enum.
             count
@@ -71,7 +75,7 @@ namespace util
             interval_tasks.push_back({
                 .tag {tag},
                 .period = std::size_t(period),
-                .expired_at = util::current_monotonic_tick() + std::size_t(period),
+                .expired_at = util::coarse_monotonic_tick() + std::size_t(period),
                 .func = func
             });
         }
@@ -83,7 +87,7 @@ namespace util
                 if (tag != interval_task_tag_id::invalid && task.tag != tag)
                     continue;
 
-                if (util::current_monotonic_tick() < task.expired_at)
+                if (util::coarse_monotonic_tick() < task.expired_at)
                     continue;
 
                 invoke_task(task);
@@ -100,11 +104,11 @@ namespace util
                 else
                     std::invoke(task.func);
 
-                task.expired_at = util::current_monotonic_tick() + task.period;
+                task.expired_at = util::coarse_monotonic_tick() + task.period;
             }
             catch (...) {
                 LOG(error) << "Exception occured at " << int(task.tag) << " (Task deferred)";
-                task.expired_at = util::current_monotonic_tick() + (task.period << 2);
+                task.expired_at = util::coarse_monotonic_tick() + (task.period << 2);
             }
         }
 
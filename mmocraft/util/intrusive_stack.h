@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+
+namespace util
+{
+    struct IntrusiveStackNode
+    {
+        // atomic because pop() may read a node which is being pushed again by another thread.
+        std::atomic<IntrusiveStackNode*> next{ nullptr };
+
+        // a copied element is not linked to any containers.
+        IntrusiveStackNode() = default;
+        IntrusiveStackNode(const IntrusiveStackNode&) noexcept { }
+        IntrusiveStackNode& operator=(const IntrusiveStackNode&) noexcept { return *this; }
+    };
+
+    // IntrusiveStack is a lock-free stack whose link is embedded in the element (T derives from IntrusiveStackNode),
+    // so push and pop never allocate.
+    // The head is a tagged pointer (48bit address + 16bit tag) to detect ABA on pop.
+    // Note: a popped node may be read by a concurrent pop, so the memory of nodes must not be returned to the OS
+    //       while the stack is in use. (reusing it, e.g. by an object pool, is fine)
+    template <typename T>
+    class IntrusiveStack
+    {
+        static_assert(std::is_base_of_v<IntrusiveStackNode, T>);
+        static_assert(sizeof(void*) == sizeof(std::uint64_t), "tagged pointer requires 64bit address");
+
+        static constexpr int tag_shift = 48;
+        static constexpr std::uint64_t address_mask = (std::uint64_t(1) << tag_shift) - 1;
+
+    public:
+        void push(T* value)
+        {
+            push_chain(value, value);
+        }
+
+        // push the nodes linked from first to last at once.
+        void push_chain(T* first, T* last)
+        {
+            IntrusiveStackNode* last_node = last;
+            auto head = _head.load(std::memory_order_relaxed);
+            do {
+                last_node->next.store(to_node(head), std::memory_order_relaxed);
+            } while (not _head.compare_exchange_weak(head, make_head(first, head),
+                std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // returns nullptr if empty.
+        T* pop()
+        {
+            auto head = _head.load(std::memory_order_acquire);
+            while (auto node = to_node(head)) {
+                auto next = node->next.load(std::memory_order_relaxed);
+                if (_head.compare_exchange_weak(head, make_head(next, head),
+                    std::memory_order_acquire, std::memory_order_acquire)) {
+                    return static_cast<T*>(node);
+                }
+            }
+            return nullptr;
+        }
+
+        // detach all nodes. the nodes are linked in LIFO order through next.
+        T* pop_all()
+        {
+            auto head = _head.load(std::memory_order_relaxed);
+            while (not _head.compare_exchange_weak(head, make_head(nullptr, head),
+                std::memory_order_acquire, std::memory_order_relaxed));
+            return static_cast<T*>(to_node(head));
+        }
+
+        static T* next_of(T* value)
+        {
+            return static_cast<T*>(value->IntrusiveStackNode::next.load(std::memory_order_relaxed));
+        }
+
+        bool empty() const
+        {
+            return to_node(_head.load(std::memory_order_relaxed)) == nullptr;
+        }
+
+    private:
+        static IntrusiveStackNode* to_node(std::uint64_t head)
+        {
+            return reinterpret_cast<IntrusiveStackNode*>(head & address_mask);
+        }
+
+        // every update of the head increases the tag.
+        static std::uint64_t make_head(IntrusiveStackNode* node, std::uint64_t prev_head)
+        {
+            auto address = reinterpret_cast<std::uint64_t>(node);
+            assert((address & ~address_mask) == 0);
+            return address | (((prev_head >> tag_shift) + 1) << tag_shift);
+        }
+
+        std::atomic<std::uint64_t> _head{ 0 };
+    };
+}
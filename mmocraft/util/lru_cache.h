@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "util/noncopyable.h"
+#include "util/shard_array.h"
+#include "util/time_util.h"
+
+namespace util
+{
+    // ShardedLruCache maps string keys to values, evicting the least recently used one when a shard is full.
+    // entries expire after the ttl (by the coarse monotonic tick), so changes by other servers are picked up eventually.
+    // keys are spread over shards by hash, and each shard has its own lock. (thread-safe)
+    template <typename Value>
+    class ShardedLruCache : util::NonCopyable, util::NonMovable
+    {
+    public:
+        ShardedLruCache(std::size_t capacity, std::size_t ttl_ms, std::size_t num_of_shards = 16)
+            : _ttl_ms{ ttl_ms }
+            , shard_capacity{ std::max<std::size_t>(capacity / num_of_shards, 1) }
+            , shards{ num_of_shards }
+        { }
+
+        std::optional<Value> get(std::string_view key)
+        {
+            auto& shard = shards.shard_of(key);
+            std::lock_guard<std::mutex> lock(shard.lock);
+
+            auto it = shard.index.find(key);
+            if (it == shard.index.end())
+                return std::nullopt;
+
+            auto entry = it->second;
+            if (entry->expired_at <= util::coarse_monotonic_tick()) {
+                shard.index.erase(it);
+                shard.entries.erase(entry);
+                return std::nullopt;
+            }
+
+            shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+            return entry->value;
+        }
+
+        void put(std::string_view key, Value value)
+        {
+            auto& shard = shards.shard_of(key);
+            std::lock_guard<std::mutex> lock(shard.lock);
+
+            auto expired_at = util::coarse_monotonic_tick() + _ttl_ms;
+
+            if (auto it = shard.index.find(key); it != shard.index.end()) {
+                auto entry = it->second;
+                entry->value = std::move(value);
+                entry->expired_at = expired_at;
+                shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+                return;
+            }
+
+            if (shard.entries.size() >= shard_capacity) {
+                shard.index.erase(shard.entries.back().key);
+                shard.entries.pop_back();
+            }
+
+            shard.entries.push_front({ std::string(key), std::move(value), expired_at });
+            shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+        }
+
+        bool erase(std::string_view key)
+        {
+            auto& shard = shards.shard_of(key);
+            std::lock_guard<std::mutex> lock(shard.lock);
+
+            auto it = shard.index.find(key);
+            if (it == shard.index.end())
+                return false;
+
+            shard.entries.erase(it->second);
+            shard.index.erase(it);
+            return true;
+        }
+
+        // includes expired entries which are not evicted yet.
+        std::size_t size() const
+        {
+            std::size_t size = 0;
+            for (auto& shard : shards) {
+                std::lock_guard<std::mutex> lock(shard.lock);
+                size += shard.entries.size();
+            }
+            return size;
+        }
+
+    private:
+        struct Entry
+        {
+            std::string key;
+            Value value;
+            std::size_t expired_at;
+        };
+
+        struct Shard
+        {
+            mutable std::mutex lock;
+            std::list<Entry> entries;   // the most recently used first.
+            std::unordered_map<std::string_view, typename std::list<Entry>::iterator> index;    // keys are viewed from entries.
+        };
+
+        const std::size_t _ttl_ms;
+        const std::size_t shard_capacity;
+
+        util::ShardArray<Shard> shards;
+    };
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <type_traits>
+
+#include "util/noncopyable.h"
+
+namespace util
+{
+    struct MpscQueueNode
+    {
+        std::atomic<MpscQueueNode*> next{ nullptr };
+
+        // a copied element is not linked to any containers.
+        MpscQueueNode() = default;
+        MpscQueueNode(const MpscQueueNode&) noexcept { }
+        MpscQueueNode& operator=(const MpscQueueNode&) noexcept { return *this; }
+    };
+
+    // MpscQueue is an intrusive multi-producer single-consumer FIFO queue. (Dmitry Vyukov's algorithm)
+    // push is wait-free (a single exchange) and neither push nor pop allocates.
+    // Note: pop() may return nullptr while a producer is in the middle of push(),
+    //       the consumer should retry later in that case.
+    template <typename T>
+    class MpscQueue : util::NonCopyable, util::NonMovable
+    {
+        static_assert(std::is_base_of_v<MpscQueueNode, T>);
+
+    public:
+        MpscQueue()
+            : _head{ &_stub }
+            , _tail{ &_stub }
+        { }
+
+        // thread-safe
+        void push(T* value)
+        {
+            push_node(value);
+        }
+
+        // consumer only.
+        T* pop()
+        {
+            auto tail = _tail;
+            auto next = tail->next.load(std::memory_order_acquire);
+
+            // skip the stub.
+            if (tail == &_stub) {
+                if (next == nullptr)
+                    return nullptr;
+                _tail = tail = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+
+            if (next) {
+                _tail = next;
+                return static_cast<T*>(tail);
+            }
+
+            // a producer has exchanged the head but not linked it yet.
+            if (tail != _head.load(std::memory_order_acquire))
+                return nullptr;
+
+            // tail is the last node. put the stub behind it so that tail can be detached.
+            push_node(&_stub);
+
+            next = tail->next.load(std::memory_order_acquire);
+            if (next) {
+                _tail = next;
+                return static_cast<T*>(tail);
+            }
+            return nullptr;
+        }
+
+        // thread-safe, but only a hint for other than the consumer.
+        bool empty() const
+        {
+            return _head.load(std::memory_order_relaxed) == &_stub;
+        }
+
+    private:
+        void push_node(MpscQueueNode* node)
+        {
+            node->next.store(nullptr, std::memory_order_relaxed);
+            auto prev = _head.exchange(node, std::memory_order_acq_rel);
+            prev->next.store(node, std::memory_order_release);
+        }
+
+        MpscQueueNode _stub;
+
+        alignas(64) std::atomic<MpscQueueNode*> _head;
+
+        alignas(64) MpscQueueNode* _tail;
+    };
+}
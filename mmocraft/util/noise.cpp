@@ -0,0 +1,248 @@
+#include "pch.h"
+#include "noise.h"
+
+// SSE4.1 (_mm_mullo_epi32, _mm_floor_ps) is not part of the x64 baseline,
+// so the SIMD path is compiled for it and taken only if the CPU supports it.
+#if defined(_M_X64) || defined(__x86_64__)
+#define MMOCRAFT_NOISE_SSE41
+#include <smmintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SSE41_TARGET
+#else
+#define SSE41_TARGET __attribute__((target("sse4.1")))
+#endif
+#endif
+
+namespace
+{
+    float fade(float t)
+    {
+        return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+    }
+
+    float lerp(float t, float a, float b)
+    {
+        return a + t * (b - a);
+    }
+
+    // the gradient is one of the diagonal directions selected by the hash bits.
+    float grad2(std::uint32_t h, float dx, float dz)
+    {
+        return (h & 1 ? -dx : dx) + (h & 2 ? -dz : dz);
+    }
+
+    float grad3(std::uint32_t h, float dx, float dy, float dz)
+    {
+        return (h & 1 ? -dx : dx) + (h & 2 ? -dy : dy) + (h & 4 ? -dz : dz);
+    }
+
+#ifdef MMOCRAFT_NOISE_SSE41
+    SSE41_TARGET __m128 fade4(__m128 t)
+    {
+        auto t3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+        auto inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f));
+        return _mm_mul_ps(t3, inner);
+    }
+
+    SSE41_TARGET __m128 lerp4(__m128 t, __m128 a, __m128 b)
+    {
+        return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+    }
+
+    // negates v if the given hash bit is set.
+    SSE41_TARGET __m128 flip_sign4(__m128i h, int bit, __m128 v)
+    {
+        auto sign = _mm_slli_epi32(_mm_srli_epi32(h, bit), 31);
+        return _mm_xor_ps(v, _mm_castsi128_ps(sign));
+    }
+
+    SSE41_TARGET __m128i hash4(__m128i x, __m128i y, __m128i z, __m128i seed)
+    {
+        auto h = _mm_xor_si128(
+            _mm_xor_si128(_mm_mullo_epi32(x, _mm_set1_epi32(0x27d4eb2d)), _mm_mullo_epi32(y, _mm_set1_epi32(0x165667b1))),
+            _mm_xor_si128(_mm_mullo_epi32(z, _mm_set1_epi32(int(0x9e3779b1u))), seed));
+        h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+        h = _mm_mullo_epi32(h, _mm_set1_epi32(0x2c1b3c6d));
+        return _mm_xor_si128(h, _mm_srli_epi32(h, 12));
+    }
+
+    SSE41_TARGET __m128 grad2_4(__m128i h, __m128 dx, __m128 dz)
+    {
+        return _mm_add_ps(flip_sign4(h, 0, dx), flip_sign4(h, 1, dz));
+    }
+
+    SSE41_TARGET __m128 grad3_4(__m128i h, __m128 dx, __m128 dy, __m128 dz)
+    {
+        return _mm_add_ps(_mm_add_ps(flip_sign4(h, 0, dx), flip_sign4(h, 1, dy)), flip_sign4(h, 2, dz));
+    }
+
+    // x + i * dx for the lanes starting at index i.
+    SSE41_TARGET __m128 lane_positions(float x, float dx, std::size_t i)
+    {
+        auto index = _mm_add_epi32(_mm_set1_epi32(int(i)), _mm_setr_epi32(0, 1, 2, 3));
+        return _mm_add_ps(_mm_set1_ps(x), _mm_mul_ps(_mm_cvtepi32_ps(index), _mm_set1_ps(dx)));
+    }
+
+    bool is_sse41_supported()
+    {
+        static const bool is_supported = [] {
+#ifdef _MSC_VER
+            int cpu_info[4];
+            __cpuid(cpu_info, 1);
+            return (cpu_info[2] & (1 << 19)) != 0;
+#else
+            return __builtin_cpu_supports("sse4.1") != 0;
+#endif
+        }();
+        return is_supported;
+    }
+
+    // returns the number of samples written. (a multiple of 4)
+    SSE41_TARGET std::size_t noise2_row_sse41(std::uint32_t seed_value, float x, float dx, float z, float* out, std::size_t n)
+    {
+        std::size_t i = 0;
+
+        const auto seed = _mm_set1_epi32(int(seed_value));
+        const auto zero = _mm_setzero_si128();
+        const auto one_i = _mm_set1_epi32(1);
+        const auto one = _mm_set1_ps(1.0f);
+
+        // z is the same for all lanes.
+        const float z_floor = std::floor(z);
+        const auto zi = _mm_set1_epi32(int(z_floor));
+        const auto zi1 = _mm_add_epi32(zi, one_i);
+        const auto fz = _mm_set1_ps(z - z_floor);
+        const auto fz1 = _mm_sub_ps(fz, one);
+        const auto v = fade4(fz);
+
+        for (; i + 4 <= n; i += 4) {
+            auto xs = lane_positions(x, dx, i);
+            auto x_floor = _mm_floor_ps(xs);
+            auto xi = _mm_cvttps_epi32(x_floor);
+            auto xi1 = _mm_add_epi32(xi, one_i);
+            auto fx = _mm_sub_ps(xs, x_floor);
+            auto fx1 = _mm_sub_ps(fx, one);
+
+            auto n00 = grad2_4(hash4(xi, zero, zi, seed), fx, fz);
+            auto n10 = grad2_4(hash4(xi1, zero, zi, seed), fx1, fz);
+            auto n01 = grad2_4(hash4(xi, zero, zi1, seed), fx, fz1);
+            auto n11 = grad2_4(hash4(xi1, zero, zi1, seed), fx1, fz1);
+
+            auto u = fade4(fx);
+            auto result = lerp4(v, lerp4(u, n00, n10), lerp4(u, n01, n11));
+            _mm_storeu_ps(out + i, _mm_mul_ps(result, _mm_set1_ps(0.5f)));
+        }
+
+        return i;
+    }
+
+    SSE41_TARGET std::size_t noise3_row_sse41(std::uint32_t seed_value, float x, float dx, float y, float z, float* out, std::size_t n)
+    {
+        std::size_t i = 0;
+
+        const auto seed = _mm_set1_epi32(int(seed_value));
+        const auto one_i = _mm_set1_epi32(1);
+        const auto one = _mm_set1_ps(1.0f);
+
+        // y and z are the same for all lanes.
+        const float y_floor = std::floor(y), z_floor = std::floor(z);
+        const auto yi = _mm_set1_epi32(int(y_floor)), yi1 = _mm_add_epi32(yi, one_i);
+        const auto zi = _mm_set1_epi32(int(z_floor)), zi1 = _mm_add_epi32(zi, one_i);
+        const auto fy = _mm_set1_ps(y - y_floor), fy1 = _mm_sub_ps(fy, one);
+        const auto fz = _mm_set1_ps(z - z_floor), fz1 = _mm_sub_ps(fz, one);
+        const auto v = fade4(fy), w = fade4(fz);
+
+        for (; i + 4 <= n; i += 4) {
+            auto xs = lane_positions(x, dx, i);
+            auto x_floor = _mm_floor_ps(xs);
+            auto xi = _mm_cvttps_epi32(x_floor);
+            auto xi1 = _mm_add_epi32(xi, one_i);
+            auto fx = _mm_sub_ps(xs, x_floor);
+            auto fx1 = _mm_sub_ps(fx, one);
+
+            auto n000 = grad3_4(hash4(xi, yi, zi, seed), fx, fy, fz);
+            auto n100 = grad3_4(hash4(xi1, yi, zi, seed), fx1, fy, fz);
+            auto n010 = grad3_4(hash4(xi, yi1, zi, seed), fx, fy1, fz);
+            auto n110 = grad3_4(hash4(xi1, yi1, zi, seed), fx1, fy1, fz);
+            auto n001 = grad3_4(hash4(xi, yi, zi1, seed), fx, fy, fz1);
+            auto n101 = grad3_4(hash4(xi1, yi, zi1, seed), fx1, fy, fz1);
+            auto n011 = grad3_4(hash4(xi, yi1, zi1, seed), fx, fy1, fz1);
+            auto n111 = grad3_4(hash4(xi1, yi1, zi1, seed), fx1, fy1, fz1);
+
+            auto u = fade4(fx);
+            auto nz0 = lerp4(v, lerp4(u, n000, n100), lerp4(u, n010, n110));
+            auto nz1 = lerp4(v, lerp4(u, n001, n101), lerp4(u, n011, n111));
+            _mm_storeu_ps(out + i, _mm_mul_ps(lerp4(w, nz0, nz1), _mm_set1_ps(0.5f)));
+        }
+
+        return i;
+    }
+#endif
+}
+
+namespace util
+{
+    float GradientNoise::noise2(float x, float z) const
+    {
+        const float x_floor = std::floor(x), z_floor = std::floor(z);
+        const int xi = int(x_floor), zi = int(z_floor);
+        const float fx = x - x_floor, fz = z - z_floor;
+
+        const float n00 = grad2(hash(xi, 0, zi), fx, fz);
+        const float n10 = grad2(hash(xi + 1, 0, zi), fx - 1.0f, fz);
+        const float n01 = grad2(hash(xi, 0, zi + 1), fx, fz - 1.0f);
+        const float n11 = grad2(hash(xi + 1, 0, zi + 1), fx - 1.0f, fz - 1.0f);
+
+        const float u = fade(fx), v = fade(fz);
+        return lerp(v, lerp(u, n00, n10), lerp(u, n01, n11)) * 0.5f;
+    }
+
+    float GradientNoise::noise3(float x, float y, float z) const
+    {
+        const float x_floor = std::floor(x), y_floor = std::floor(y), z_floor = std::floor(z);
+        const int xi = int(x_floor), yi = int(y_floor), zi = int(z_floor);
+        const float fx = x - x_floor, fy = y - y_floor, fz = z - z_floor;
+
+        const float n000 = grad3(hash(xi, yi, zi), fx, fy, fz);
+        const float n100 = grad3(hash(xi + 1, yi, zi), fx - 1.0f, fy, fz);
+        const float n010 = grad3(hash(xi, yi + 1, zi), fx, fy - 1.0f, fz);
+        const float n110 = grad3(hash(xi + 1, yi + 1, zi), fx - 1.0f, fy - 1.0f, fz);
+        const float n001 = grad3(hash(xi, yi, zi + 1), fx, fy, fz - 1.0f);
+        const float n101 = grad3(hash(xi + 1, yi, zi + 1), fx - 1.0f, fy, fz - 1.0f);
+        const float n011 = grad3(hash(xi, yi + 1, zi + 1), fx, fy - 1.0f, fz - 1.0f);
+        const float n111 = grad3(hash(xi + 1, yi + 1, zi + 1), fx - 1.0f, fy - 1.0f, fz - 1.0f);
+
+        const float u = fade(fx), v = fade(fy), w = fade(fz);
+        const float nz0 = lerp(v, lerp(u, n000, n100), lerp(u, n010, n110));
+        const float nz1 = lerp(v, lerp(u, n001, n101), lerp(u, n011, n111));
+        return lerp(w, nz0, nz1) * 0.5f;
+    }
+
+    void GradientNoise::noise2_row(float x, float dx, float z, float* out, std::size_t n) const
+    {
+        std::size_t i = 0;
+
+#ifdef MMOCRAFT_NOISE_SSE41
+        if (is_sse41_supported())
+            i = noise2_row_sse41(_seed, x, dx, z, out, n);
+#endif
+
+        for (; i < n; i++)
+            out[i] = noise2(x + float(int(i)) * dx, z);
+    }
+
+    void GradientNoise::noise3_row(float x, float dx, float y, float z, float* out, std::size_t n) const
+    {
+        std::size_t i = 0;
+
+#ifdef MMOCRAFT_NOISE_SSE41
+        if (is_sse41_supported())
+            i = noise3_row_sse41(_seed, x, dx, y, z, out, n);
+#endif
+
+        for (; i < n; i++)
+            out[i] = noise3(x + float(int(i)) * dx, y, z);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+namespace util
+{
+    // Seeded gradient noise. gradients are taken from an integer hash instead of a permutation table,
+    // so that rows of samples are evaluated with SIMD lanes (4 samples at a time).
+    class GradientNoise
+    {
+    public:
+        explicit GradientNoise(std::uint32_t seed)
+            : _seed{ seed }
+        { }
+
+        // roughly in [-1, 1].
+        float noise2(float x, float z) const;
+
+        float noise3(float x, float y, float z) const;
+
+        // out[i] = noise2(x + i * dx, z)
+        void noise2_row(float x, float dx, float z, float* out, std::size_t n) const;
+
+        // out[i] = noise3(x + i * dx, y, z)
+        void noise3_row(float x, float dx, float y, float z, float* out, std::size_t n) const;
+
+        std::uint32_t hash(int x, int y, int z) const
+        {
+            std::uint32_t h = (std::uint32_t(x) * 0x27d4eb2du) ^ (std::uint32_t(y) * 0x165667b1u)
+                            ^ (std::uint32_t(z) * 0x9e3779b1u) ^ _seed;
+            h ^= h >> 15;
+            h *= 0x2c1b3c6du;
+            h ^= h >> 12;
+            return h;
+        }
+
+    private:
+        std::uint32_t _seed;
+    };
+}
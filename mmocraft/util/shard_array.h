@@ -0,0 +1,50 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+#include "util/noncopyable.h"
+
+namespace util
+{
+    // ShardArray holds a fixed number of shards, and picks one by the hash of a string key.
+    // shards usually have their own lock, so keys in different shards are accessed concurrently.
+    template <typename Shard>
+    class ShardArray : util::NonCopyable, util::NonMovable
+    {
+    public:
+        explicit ShardArray(std::size_t num_of_shards)
+            : _num_of_shards{ num_of_shards }
+            , shards{ new Shard[num_of_shards] }
+        { }
+
+        // rotated not to pick shards by the low bits which also pick buckets in the shard.
+        Shard& shard_of(std::string_view key) const
+        {
+            return shards[std::rotr(std::hash<std::string_view>{}(key), 16) % _num_of_shards];
+        }
+
+        std::size_t size() const
+        {
+            return _num_of_shards;
+        }
+
+        Shard* begin() const
+        {
+            return shards.get();
+        }
+
+        Shard* end() const
+        {
+            return shards.get() + _num_of_shards;
+        }
+
+    private:
+        const std::size_t _num_of_shards;
+
+        std::unique_ptr<Shard[]> shards;
+    };
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "util/noncopyable.h"
+#include "util/shard_array.h"
+
+namespace util
+{
+    // ShardedHashMap maps string keys to values.
+    // keys are spread over shards by hash, and each shard has its own lock. (thread-safe)
+    // values are returned by copy, so keep them small.
+    template <typename Value>
+    class ShardedHashMap : util::NonCopyable, util::NonMovable
+    {
+    public:
+        explicit ShardedHashMap(std::size_t num_of_shards = 16)
+            : shards{ num_of_shards }
+        { }
+
+        std::optional<Value> find(std::string_view key) const
+        {
+            auto& shard = shards.shard_of(key);
+            std::lock_guard<std::mutex> lock(shard.lock);
+
+            auto it = shard.entries.find(key);
+            if (it == shard.entries.end())
+                return std::nullopt;
+            return it->second;
+        }
+
+        void insert_or_assign(std::string_view key, Value value)
+        {
+            auto& shard = shards.shard_of(key);
+            std::lock_guard<std::mutex> lock(shard.lock);
+
+            if (auto it = shard.entries.find(key); it != shard.entries.end())
+                it->second = std::move(value);
+            else
+                shard.entries.emplace(std::string(key), std::move(value));
+        }
+
+        // erases the entry only if the predicate holds for its value. (e.g. not replaced by a newer one)
+        template <typename Predicate>
+        bool erase_if(std::string_view key, Predicate pred)
+        {
+            auto& shard = shards.shard_of(key);
+            std::lock_guard<std::mutex> lock(shard.lock);
+
+            auto it = shard.entries.find(key);
+            if (it == shard.entries.end() || not pred(it->second))
+                return false;
+
+            shard.entries.erase(it);
+            return true;
+        }
+
+        std::size_t size() const
+        {
+            std::size_t size = 0;
+            for (auto& shard : shards) {
+                std::lock_guard<std::mutex> lock(shard.lock);
+                size += shard.entries.size();
+            }
+            return size;
+        }
+
+    private:
+        struct KeyHash
+        {
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view key) const
+            {
+                return std::hash<std::string_view>{}(key);
+            }
+        };
+
+        struct Shard
+        {
+            mutable std::mutex lock;
+            std::unordered_map<std::string, Value, KeyHash, std::equal_to<>> entries;
+        };
+
+        util::ShardArray<Shard> shards;
+    };
+}
@@ -1,8 +1,56 @@
 #include "pch.h"
 #include "time_util.h"
 
+namespace
+{
+    struct FineClockCalibration
+    {
+        std::uint64_t base_tsc = 0;
+        double ns_per_tick = 1.0;
+    };
+
+    const FineClockCalibration& fine_clock_calibration()
+    {
+        static const FineClockCalibration calibration = [] {
+            using clock = std::chrono::steady_clock;
+
+            const auto begin_time = clock::now();
+            const auto begin_tsc = util::read_tsc();
+            while (clock::now() - begin_time < std::chrono::milliseconds(10)) { }
+            const auto end_tsc = util::read_tsc();
+            const auto end_time = clock::now();
+
+            auto elapsed_ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - begin_time).count());
+            return FineClockCalibration{
+                .base_tsc = begin_tsc,
+                .ns_per_tick = end_tsc > begin_tsc ? elapsed_ns / double(end_tsc - begin_tsc) : 1.0
+            };
+        }();
+        return calibration;
+    }
+}
+
 namespace util
 {
+    void update_coarse_monotonic_tick()
+    {
+        // event threads may store concurrently. never move the tick backward.
+        const auto now = current_monotonic_tick();
+        auto cached = cached_monotonic_tick.load(std::memory_order_relaxed);
+        while (cached < now && not cached_monotonic_tick.compare_exchange_weak(cached, now, std::memory_order_relaxed)) { }
+    }
+
+    std::uint64_t fine_time_ns()
+    {
+        const auto& calibration = fine_clock_calibration();
+        return std::uint64_t(double(read_tsc() - calibration.base_tsc) * calibration.ns_per_tick);
+    }
+
+    void calibrate_fine_clock()
+    {
+        fine_clock_calibration();
+    }
+
     void busy_wait(std::size_t ms)
     {
         auto start = current_monotonic_tick();
@@ -1,8 +1,16 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <ctime>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 #include "win/win_type.h"
 
 namespace util
@@ -18,6 +26,13 @@ namespace util
         return std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
     }
 
+    // unix time in milliseconds.
+    inline std::uint64_t current_timestamp_ms()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
     inline std::size_t current_time_ns()
     {
         return std::chrono::time_point_cast<std::chrono::nanoseconds>(
@@ -34,6 +49,37 @@ namespace util
         return std::size_t(::GetTickCount());
     }
 
+    /* Coarse clock */
+
+    // the monotonic tick cached by event loops (once per batch of completions) and the server tick.
+    // it may lag behind current_monotonic_tick() as long as a batch or a tick takes,
+    // so use it for deadlines and timeouts only. (task intervals, ping, connection expiry)
+    inline std::atomic<std::size_t> cached_monotonic_tick{ current_monotonic_tick() };
+
+    inline std::size_t coarse_monotonic_tick()
+    {
+        return cached_monotonic_tick.load(std::memory_order_relaxed);
+    }
+
+    void update_coarse_monotonic_tick();
+
+    /* Fine clock */
+
+    inline std::uint64_t read_tsc()
+    {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    // nanoseconds since the calibration, measured by the (invariant) TSC. for latencies. (ping rtt, time slices)
+    std::uint64_t fine_time_ns();
+
+    // measures the TSC frequency. (takes about 10ms, invoked by fine_time_ns() if not calibrated yet)
+    void calibrate_fine_clock();
+
     inline auto sleep_ms(std::size_t ms)
     {
         ::Sleep(DWORD(ms));
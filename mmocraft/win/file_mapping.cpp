@@ -1,21 +1,118 @@
 #include "pch.h"
 #include "file_mapping.h"
 
+#include <bit>
+#include <utility>
+
 #include "logging/logger.h"
 
 namespace win
 {
     FileMapping::FileMapping()
     {
-        
+
     }
 
     FileMapping::~FileMapping()
     {
-        if (_mapping_address != NULL)
-            ::UnmapViewOfFile(_mapping_address);
+        close();
     }
 
+    FileMapping::FileMapping(FileMapping&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    FileMapping& FileMapping::operator=(FileMapping&& other) noexcept
+    {
+        if (this != &other) {
+            close();
+#ifdef _WIN32
+            _file_handle = std::move(other._file_handle);
+            _mapping_handle = std::move(other._mapping_handle);
+#else
+            _fd = std::exchange(other._fd, -1);
+#endif
+            _mapping_address = std::exchange(other._mapping_address, nullptr);
+            _mapping_size = std::exchange(other._mapping_size, 0);
+            dirty_chunks = std::move(other.dirty_chunks);
+            num_of_dirty_chunk_words = std::exchange(other.num_of_dirty_chunk_words, 0);
+        }
+        return *this;
+    }
+
+    void FileMapping::mark_dirty(std::size_t offset, std::size_t length)
+    {
+        if (length == 0 || offset >= _mapping_size)
+            return;
+
+        auto first_chunk = offset / dirty_chunk_size;
+        auto last_chunk = std::min(offset + length, _mapping_size) - 1;
+        last_chunk /= dirty_chunk_size;
+
+        for (auto chunk = first_chunk; chunk <= last_chunk; chunk++) {
+            auto bit = std::uint64_t(1) << (chunk % 64);
+            auto& word = dirty_chunks[chunk / 64];
+
+            // avoid the atomic read-modify-write if already marked.
+            if ((word.load(std::memory_order_relaxed) & bit) == 0)
+                word.fetch_or(bit, std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t FileMapping::flush_dirty()
+    {
+        std::size_t flushed_bytes = 0;
+        std::size_t run_begin = 0, run_length = 0;
+
+        auto flush_run = [&] {
+            if (run_length == 0)
+                return;
+
+            auto offset = run_begin * dirty_chunk_size;
+            auto length = std::min(run_length * dirty_chunk_size, _mapping_size - offset);
+
+            // re-mark the range to retry at the next flush.
+            if (flush_range(offset, length))
+                flushed_bytes += length;
+            else
+                mark_dirty(offset, length);
+
+            run_length = 0;
+        };
+
+        // coalesce adjacent dirty chunks into a single write back.
+        for (std::size_t index = 0; index < num_of_dirty_chunk_words; index++) {
+            auto word = dirty_chunks[index].exchange(0, std::memory_order_relaxed);
+
+            for (int bit = 0; bit < 64; bit++) {
+                auto chunk = index * 64 + bit;
+
+                if (word & (std::uint64_t(1) << bit)) {
+                    if (run_length == 0)
+                        run_begin = chunk;
+                    run_length++;
+                }
+                else
+                    flush_run();
+            }
+        }
+        flush_run();
+
+        return flushed_bytes;
+    }
+
+    void FileMapping::reset_dirty_chunks()
+    {
+        auto num_of_chunks = (_mapping_size + dirty_chunk_size - 1) / dirty_chunk_size;
+        num_of_dirty_chunk_words = (num_of_chunks + 63) / 64;
+
+        dirty_chunks.reset(new std::atomic<std::uint64_t>[num_of_dirty_chunk_words]);
+        for (std::size_t index = 0; index < num_of_dirty_chunk_words; index++)
+            dirty_chunks[index].store(0, std::memory_order_relaxed);
+    }
+
+#ifdef _WIN32
     void FileMapping::close() noexcept
     {
         if (_mapping_address != NULL) {
@@ -25,9 +122,10 @@ namespace win
 
         _mapping_handle.reset();
         _file_handle.reset();
+        _mapping_size = 0;
     }
 
-    bool FileMapping::open(const std::string& file_path)
+    bool FileMapping::open(const std::string& file_path, const FileMappingOptions& options)
     {
         _file_handle.reset(::CreateFileA(
             file_path.c_str(),
@@ -44,6 +142,12 @@ namespace win
             return false;
         }
 
+        LARGE_INTEGER file_size;
+        if (not ::GetFileSizeEx(_file_handle.get(), &file_size)) {
+            CONSOLE_LOG(error) << "Unable to get file size with " << ::GetLastError();
+            return false;
+        }
+
         auto mapping_handle = ::CreateFileMapping(
             _file_handle.get(),
             NULL,
@@ -67,11 +171,18 @@ namespace win
             0
         );
 
-        if (mapping_handle == NULL) {
+        if (_mapping_address == NULL) {
             CONSOLE_LOG(error) << "Unable to mapping file with " << ::GetLastError();
             return false;
         }
 
+        _mapping_size = std::size_t(file_size.QuadPart);
+        reset_dirty_chunks();
+
+        // Note: large pages can not back file mappings on Windows.
+        if (options.prefetch)
+            prefetch(0, _mapping_size);
+
         return true;
     }
 
@@ -80,4 +191,24 @@ namespace win
         if (not ::FlushViewOfFile(_mapping_address, n))
             CONSOLE_LOG(error) << "Unable to flush mapping.";
     }
-}
\ No newline at end of file
+
+    void FileMapping::prefetch(std::size_t offset, std::size_t length)
+    {
+        if (offset >= _mapping_size)
+            return;
+
+        WIN32_MEMORY_RANGE_ENTRY range{ data() + offset, std::min(length, _mapping_size - offset) };
+        if (not ::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &range, 0))
+            CONSOLE_LOG(warn) << "Unable to prefetch mapping with " << ::GetLastError();
+    }
+
+    bool FileMapping::flush_range(std::size_t offset, std::size_t length)
+    {
+        if (not ::FlushViewOfFile(data() + offset, length)) {
+            CONSOLE_LOG(error) << "Unable to flush mapping with " << ::GetLastError();
+            return false;
+        }
+        return true;
+    }
+#endif
+}
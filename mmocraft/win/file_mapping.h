@@ -1,21 +1,46 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
 #include "util/common_util.h"
+
+#ifdef _WIN32
 #include "win/win_type.h"
 #include "win/win_base_object.h"
 #include "win/smart_handle.h"
+#endif
 
 namespace win
 {
+    struct FileMappingOptions
+    {
+        // fault in all pages at open time for predictable warm-up.
+        bool prefetch = false;
+
+        // back the mapping with transparent huge pages to reduce TLB misses. (POSIX only)
+        bool huge_pages = false;
+    };
+
+#ifdef _WIN32
     class FileMapping final : public win::WinBaseObject<win::Handle>, util::NonCopyable
+#else
+    class FileMapping final : util::NonCopyable
+#endif
     {
     public:
+        // granularity of the dirty range tracking.
+        static constexpr std::size_t dirty_chunk_size = 64 * 1024;
+
         FileMapping();
         ~FileMapping();
 
-        FileMapping(FileMapping&&) = default;
-        FileMapping& operator=(FileMapping&&) = default;
+        FileMapping(FileMapping&&) noexcept;
+        FileMapping& operator=(FileMapping&&) noexcept;
 
+#ifdef _WIN32
         bool is_valid() const override
         {
             return _file_handle.is_valid() && _mapping_handle.is_valid() && _mapping_address != NULL;
@@ -27,19 +52,55 @@ namespace win
         }
 
         void close() noexcept override;
+#else
+        bool is_valid() const
+        {
+            return _fd >= 0 && _mapping_address != nullptr;
+        }
+
+        void close() noexcept;
+#endif
 
-        bool open(const std::string& file_path);
+        bool open(const std::string& file_path, const FileMappingOptions& = {});
 
+        // flush first n bytes (whole mapping if zero).
         void flush(std::size_t n = 0);
 
+        // hint that the range will be accessed soon.
+        void prefetch(std::size_t offset, std::size_t length);
+
+        // mark the range to be written back by flush_dirty(). (thread-safe)
+        void mark_dirty(std::size_t offset, std::size_t length = 1);
+
+        // write back only the dirty ranges. returns the number of written back bytes.
+        std::size_t flush_dirty();
+
         auto data()
         {
             return static_cast<std::byte*>(_mapping_address);
         }
 
+        std::size_t size() const
+        {
+            return _mapping_size;
+        }
+
     private:
+        bool flush_range(std::size_t offset, std::size_t length);
+
+        void reset_dirty_chunks();
+
+#ifdef _WIN32
         win::UniqueHandle _file_handle;
         win::UniqueHandle _mapping_handle;
-        void* _mapping_address = 0;
+#else
+        int _fd = -1;
+#endif
+        void* _mapping_address = nullptr;
+        std::size_t _mapping_size = 0;
+
+        // bitmap of dirty chunks.
+        std::unique_ptr<std::atomic<std::uint64_t>[]> dirty_chunks;
+        std::size_t num_of_dirty_chunk_words = 0;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "file_mapping.h"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logging/logger.h"
+
+namespace
+{
+    std::size_t page_size()
+    {
+        static const auto size = std::size_t(::sysconf(_SC_PAGESIZE));
+        return size;
+    }
+}
+
+namespace win
+{
+    void FileMapping::close() noexcept
+    {
+        if (_mapping_address != nullptr) {
+            ::munmap(_mapping_address, _mapping_size);
+            _mapping_address = nullptr;
+        }
+
+        if (_fd >= 0) {
+            ::close(_fd);
+            _fd = -1;
+        }
+        _mapping_size = 0;
+    }
+
+    bool FileMapping::open(const std::string& file_path, const FileMappingOptions& options)
+    {
+        close();
+
+        _fd = ::open(file_path.c_str(), O_RDWR | O_CLOEXEC);
+        if (_fd < 0) {
+            CONSOLE_LOG(error) << "Unable to open file: " << file_path;
+            return false;
+        }
+
+        struct stat file_stat;
+        if (::fstat(_fd, &file_stat) != 0 || file_stat.st_size == 0) {
+            CONSOLE_LOG(error) << "Unable to get file size: " << file_path;
+            return false;
+        }
+
+        int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+        // fault in all pages in a single call instead of one fault per page.
+        if (options.prefetch)
+            flags |= MAP_POPULATE;
+#endif
+
+        auto mapping_size = std::size_t(file_stat.st_size);
+        auto mapping_address = ::mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, flags, _fd, 0);
+        if (mapping_address == MAP_FAILED) {
+            CONSOLE_LOG(error) << "Unable to mapping file with " << std::strerror(errno);
+            return false;
+        }
+
+        _mapping_address = mapping_address;
+        _mapping_size = mapping_size;
+        reset_dirty_chunks();
+
+#ifdef MADV_HUGEPAGE
+        // Note: file backed huge pages require a filesystem supporting them. (e.g. tmpfs, ext4 with large folios)
+        if (options.huge_pages && ::madvise(_mapping_address, _mapping_size, MADV_HUGEPAGE) != 0)
+            CONSOLE_LOG(warn) << "Unable to use huge pages for mapping: " << std::strerror(errno);
+#endif
+
+#ifndef MAP_POPULATE
+        if (options.prefetch)
+            prefetch(0, _mapping_size);
+#endif
+
+        return true;
+    }
+
+    void FileMapping::flush(std::size_t n)
+    {
+        if (not flush_range(0, n ? std::min(n, _mapping_size) : _mapping_size))
+            CONSOLE_LOG(error) << "Unable to flush mapping.";
+    }
+
+    void FileMapping::prefetch(std::size_t offset, std::size_t length)
+    {
+        if (offset >= _mapping_size)
+            return;
+
+        // madvise requires a page aligned address.
+        auto aligned_offset = offset / page_size() * page_size();
+        length = std::min(length, _mapping_size - offset) + (offset - aligned_offset);
+
+        if (::madvise(data() + aligned_offset, length, MADV_WILLNEED) != 0)
+            CONSOLE_LOG(warn) << "Unable to prefetch mapping: " << std::strerror(errno);
+    }
+
+    bool FileMapping::flush_range(std::size_t offset, std::size_t length)
+    {
+        // msync requires a page aligned address.
+        auto aligned_offset = offset / page_size() * page_size();
+        length += offset - aligned_offset;
+
+        if (::msync(data() + aligned_offset, length, MS_SYNC) != 0) {
+            CONSOLE_LOG(error) << "Unable to flush mapping: " << std::strerror(errno);
+            return false;
+        }
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include "pch.h"
+#include "file_sync.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace win
+{
+#ifdef _WIN32
+    bool FileSync::open(const std::filesystem::path& path)
+    {
+        close();
+
+        // FlushFileBuffers requires the write access.
+        _file_handle.reset(::CreateFileW(
+            path.c_str(),
+            GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            NULL,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            NULL
+        ));
+        return _file_handle.is_valid();
+    }
+
+    bool FileSync::is_open() const
+    {
+        return _file_handle.is_valid();
+    }
+
+    void FileSync::close() noexcept
+    {
+        _file_handle.reset();
+    }
+
+    bool FileSync::sync()
+    {
+        return is_open() && ::FlushFileBuffers(_file_handle.get());
+    }
+#else
+    bool FileSync::open(const std::filesystem::path& path)
+    {
+        close();
+
+        _fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        return _fd >= 0;
+    }
+
+    bool FileSync::is_open() const
+    {
+        return _fd >= 0;
+    }
+
+    void FileSync::close() noexcept
+    {
+        if (_fd >= 0) {
+            ::close(_fd);
+            _fd = -1;
+        }
+    }
+
+    bool FileSync::sync()
+    {
+        return is_open() && ::fdatasync(_fd) == 0;
+    }
+#endif
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <filesystem>
+
+#include "util/noncopyable.h"
+
+#ifdef _WIN32
+#include "win/smart_handle.h"
+#endif
+
+namespace win
+{
+    // FileSync writes data of a file which is already handed to the OS back to the disk. (FlushFileBuffers / fsync)
+    // it is opened alongside a stream which doesn't expose its file handle. (e.g. std::ofstream)
+    class FileSync : util::NonCopyable
+    {
+    public:
+        FileSync() = default;
+
+        ~FileSync()
+        {
+            close();
+        }
+
+        // the file must exist.
+        bool open(const std::filesystem::path&);
+
+        bool is_open() const;
+
+        void close() noexcept;
+
+        // flush the stream before the sync.
+        bool sync();
+
+    private:
+#ifdef _WIN32
+        win::UniqueHandle _file_handle;
+#else
+        int _fd = -1;
+#endif
+    };
+}
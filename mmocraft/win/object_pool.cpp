@@ -1,10 +1,78 @@
 #include "pch.h"
 #include "object_pool.h"
 
+#include <vector>
+
 namespace win
 {
     // 255 object pools is enough to use during the program execution.
     constexpr int MAX_OBJECT_POOL_AMOUNT = 0xFF;
     std::atomic<std::uint8_t> num_of_free_object_pool{ MAX_OBJECT_POOL_AMOUNT };
     void* pool_table[MAX_OBJECT_POOL_AMOUNT + 1];
-}
\ No newline at end of file
+
+    namespace
+    {
+        static_assert(MAX_THREAD_CACHE_SLOTS == 64, "slots are tracked by a 64-bit mask.");
+
+        std::atomic<std::uint64_t> used_thread_cache_slots{ 0 };
+
+        struct ThreadCachedPool
+        {
+            void* pool;
+            void(*release_thread_cache)(void*);
+        };
+
+        // pools may be constructed during the static initialization.
+        struct ThreadCachedPoolTable
+        {
+            std::mutex lock;
+            std::vector<ThreadCachedPool> pools;
+        };
+
+        ThreadCachedPoolTable& thread_cached_pools()
+        {
+            static ThreadCachedPoolTable table;
+            return table;
+        }
+    }
+
+    std::size_t acquire_thread_cache_slot()
+    {
+        auto used_slots = used_thread_cache_slots.load(std::memory_order_relaxed);
+        while (~used_slots) {
+            auto slot = std::countr_one(used_slots);
+            if (used_thread_cache_slots.compare_exchange_weak(used_slots, used_slots | (1ULL << slot),
+                std::memory_order_acquire, std::memory_order_relaxed))
+                return slot;
+        }
+        return MAX_THREAD_CACHE_SLOTS;
+    }
+
+    void release_thread_cache_slot(std::size_t slot)
+    {
+        if (slot < MAX_THREAD_CACHE_SLOTS)
+            used_thread_cache_slots.fetch_and(~(1ULL << slot), std::memory_order_release);
+    }
+
+    void register_thread_cached_pool(void* pool, void(*release_thread_cache)(void*))
+    {
+        auto& table = thread_cached_pools();
+        std::lock_guard<std::mutex> lock(table.lock);
+        table.pools.push_back({ pool, release_thread_cache });
+    }
+
+    void deregister_thread_cached_pool(void* pool)
+    {
+        auto& table = thread_cached_pools();
+        std::lock_guard<std::mutex> lock(table.lock);
+        std::erase_if(table.pools, [pool](const ThreadCachedPool& entry) { return entry.pool == pool; });
+    }
+
+    void release_thread_caches()
+    {
+        auto& table = thread_cached_pools();
+        std::lock_guard<std::mutex> lock(table.lock);
+        for (auto& entry : table.pools)
+            entry.release_thread_cache(entry.pool);
+    }
+}
@@ -9,9 +9,11 @@
 #include <limits>
 #include <algorithm>
 #include <cassert>
-#include <intrin.h>
+#include <bit>
+#include <mutex>
+#include <thread>
 
-#include "win/win_type.h"
+#include "win/virtual_memory.h"
 #include "util/common_util.h"
 #include "logging/logger.h"
 
@@ -38,7 +40,8 @@ namespace win
     //	  - 모든 객체가 연속된 가상 주소 공간에 할당되어 노드 기반의 map 자료구조보다 fragmentation이 적음. (WSS 감소)
     //    - (?) 순차적 순회로 cache hit 비율 증가
     // 3. 메모리 효율성
-    //	  - VirtualAlloc으로 주소 공간만 예약해두기 때문에 물리 메모리 프레임 낭비를 최소화한다.
+    //	  - 주소 공간만 예약(VirtualAlloc/mmap)해두기 때문에 물리 메모리 프레임 낭비를 최소화한다.
+    //	  - commit 시 huge page와 NUMA node를 지정할 수 있다. (win/virtual_memory.h)
     // 4. (TODO) 메모리 확장 시 발생하는 오버헤드 측정 필요
     //    - VirtualAlloc으로 커밋 vs std::deque처럼 청크 구조 구현 (현재는 VirtualAlloc에 의존)
     // 
@@ -49,14 +52,53 @@ namespace win
     //	  - ObjectPool이 객체보다 먼저 해제되지 않된다.
     //		- (Decision) 대부분의 ObjectPool은 프로그램 종료까지 유지하므로 리스크가 있음에도 유지한다.
     // 2. thread-safe
-    //    - 기본적으로 클래스가 thread-safe하게 설계되지 않음.
-    //		- 아직까진 ObjectPool을 여러 스레드로 공유할 일이 없어 문제가 되지 않는다. 
-    //	  - 객체의 할당은 한 스레드에서 수행되지만, 반환은 다른 스레드 흐름에서 수행될 수 있어 조치가 필요하다.
-    //		- bitmap search로 해결
-    //		  - 탐색이 O(n) 시간을 갖지만, n이 보통 10000 정도라서 오히려 다른 방법(lock, lock-free 등)에 비해 빠를 거라 예상
-    //        - CPU 캐시의 도움으로 RAM 모델에서 예측한 시간보다 향상된 성능을 보여줄 거라 예상
-    //		  - (TODO) 성능 측정 필요
-    //    - (TODO) 나머지 thrad-safe 처리는 필요에 따라 추가 예정.
+    //    - 객체의 할당과 반환 모두 임의의 스레드에서 수행될 수 있다.
+    //		- 2단계 bitmap으로 해결
+    //		  - leaf word의 각 bit는 객체의 free 여부, summary word의 각 bit는 leaf word에 free 객체가 있을 수 있는지를 나타낸다.
+    //		  - summary word 하나가 leaf word 64개(객체 4096개)를 요약하므로 탐색이 사실상 O(1)이다.
+    //		  - 상태 전환은 atomic fetch_and/fetch_or로 수행한다.
+    //    - 용량 확장(commit)만 lock으로 보호한다.
+    // 3. thread cache (magazine)
+    //    - use_thread_cache가 켜진 풀은 스레드마다 free 객체 index의 stack(magazine)을 둔다.
+    //		- 할당/반환 fast path는 magazine에서 처리하고, bitmap과는 batch 단위로 주고받는다.
+    //		  - magazine은 경합이 없는 spin lock으로 보호한다. (pool이 빌 때만 다른 스레드가 잡는다)
+    //		- 다른 스레드가 반환한 객체는 할당한 스레드의 remote-free list로 돌아간다.
+    //		  - pool이 비면 다른 스레드의 remote-free list를 가져와(steal) 할당한다.
+    //		  - 그래도 비어 있으면 다른 스레드의 magazine을 bitmap으로 비워(drain) max_capacity개의 할당을 보장한다.
+    //	  - 스레드 종료 전 release_thread_caches()를 호출해 magazine에 남은 객체를 반환한다.
+    //	  - 스레드 슬롯은 스레드가 종료되면 재사용된다.
+
+    constexpr std::size_t MAX_THREAD_CACHE_SLOTS = 64;
+
+    // thread cache slots. a slot is released when its thread exits, and taken over by a new thread.
+    // (MAX_THREAD_CACHE_SLOTS if all slots are used by live threads)
+    std::size_t acquire_thread_cache_slot();
+
+    void release_thread_cache_slot(std::size_t slot);
+
+    inline std::size_t current_thread_cache_slot()
+    {
+        struct ThreadCacheSlot
+        {
+            const std::size_t slot = acquire_thread_cache_slot();
+
+            ~ThreadCacheSlot()
+            {
+                release_thread_cache_slot(slot);
+            }
+        };
+
+        thread_local const ThreadCacheSlot cache_slot;
+        return cache_slot.slot;
+    }
+
+    // pools which use thread caches are registered, so that a thread returns its caches of all pools before exit.
+    void register_thread_cached_pool(void* pool, void(*release_thread_cache)(void*));
+
+    void deregister_thread_cached_pool(void* pool);
+
+    // return cached objects of the current thread to all pools. (called on the event thread exit)
+    void release_thread_caches();
 
     template <typename T, std::size_t OBJECT_SIZE = sizeof(T)>
     class ObjectPool : util::NonCopyable, util::NonMovable
@@ -66,54 +108,94 @@ namespace win
         using index_type = std::uint32_t;
         using object_pointer = T*;
 
-        static constexpr int MEMORY_PROTECTION_LEVEL = PAGE_READWRITE;
         static constexpr int SIZE_TYPE_BIT_SIZE = sizeof(size_type) * 8;
         static constexpr size_type DEFAULT_CAPACITY = 512;
         static constexpr index_type INVALID_INDEX = std::numeric_limits<index_type>::max();
 
+        using bitmap_type = std::atomic<std::uint64_t>;
+
+        static constexpr size_type MAX_THREAD_CACHES = MAX_THREAD_CACHE_SLOTS;
+        static constexpr size_type MAGAZINE_SIZE = 64;
+        static constexpr size_type MAGAZINE_BATCH_SIZE = MAGAZINE_SIZE / 2;
+
         ObjectPool() = delete;
 
-        ObjectPool(size_type max_capacity)
+        ObjectPool(size_type max_capacity, bool use_thread_cache = false,
+                   const win::VirtualMemoryOptions& memory_options = win::default_memory_options())
             : _storage{ nullptr }
+            , _memory_options{ memory_options }
             , _capacity{ std::min(DEFAULT_CAPACITY, max_capacity) }
             , _max_capacity{ max_capacity }
-            , _bitmap_size{ 1 + max_capacity / SIZE_TYPE_BIT_SIZE }
-            , free_storage_bitmaps{ new size_type[_bitmap_size]}
+            , _bitmap_size{ 1 + _max_capacity / SIZE_TYPE_BIT_SIZE }
+            , _summary_size{ (_bitmap_size + SIZE_TYPE_BIT_SIZE - 1) / SIZE_TYPE_BIT_SIZE }
+            , free_storage_bitmaps{ new bitmap_type[_bitmap_size] }
+            , summary_bitmaps{ new bitmap_type[_summary_size] }
         {
             static_assert(OBJECT_SIZE >= sizeof(T));
 
-            _storage = static_cast<decltype(_storage)>(
-                ::VirtualAlloc(NULL, max_capacity * OBJECT_SIZE, MEM_RESERVE, MEMORY_PROTECTION_LEVEL)
-                );
+            _storage = static_cast<decltype(_storage)>(win::reserve_virtual_memory(_max_capacity * OBJECT_SIZE));
 
             if (_storage == nullptr)
                 throw ObjectPoolErrorCode::RESERVE_ERROR;
 
-            if (not ::VirtualAlloc(_storage, _capacity * OBJECT_SIZE, MEM_COMMIT, MEMORY_PROTECTION_LEVEL))
+            if (not win::commit_virtual_memory(_storage, _capacity * OBJECT_SIZE, _memory_options))
                 throw ObjectPoolErrorCode::COMMIT_ERROR;
 
-            std::fill_n(free_storage_bitmaps.get(), _bitmap_size, ~0);
+            // only indexes under the max capacity are free.
+            for (size_type i = 0; i < _bitmap_size; i++) {
+                auto first_index = i * SIZE_TYPE_BIT_SIZE;
+                auto num_of_objects = std::min<size_type>(SIZE_TYPE_BIT_SIZE, _max_capacity - std::min(first_index, _max_capacity));
+                free_storage_bitmaps[i].store(num_of_objects == SIZE_TYPE_BIT_SIZE ? ~0ULL : (1ULL << num_of_objects) - 1, std::memory_order_relaxed);
+            }
+
+            for (size_type i = 0; i < _summary_size; i++)
+                summary_bitmaps[i].store(0, std::memory_order_relaxed);
+
+            for (size_type i = 0; i < _bitmap_size; i++) {
+                if (free_storage_bitmaps[i].load(std::memory_order_relaxed))
+                    summary_bitmaps[i / SIZE_TYPE_BIT_SIZE].fetch_or(1ULL << (i % SIZE_TYPE_BIT_SIZE), std::memory_order_relaxed);
+            }
+
+            if (use_thread_cache) {
+                thread_caches.reset(new ThreadCache[MAX_THREAD_CACHES]);
+                object_owners.reset(new std::atomic<std::uint8_t>[_max_capacity]);
+                next_free_indexes.reset(new index_type[_max_capacity]);
+
+                for (size_type i = 0; i < _max_capacity; i++)
+                    object_owners[i].store(NO_OWNER, std::memory_order_relaxed);
+
+                register_thread_cached_pool(this, [](void* pool) {
+                    static_cast<ObjectPool*>(pool)->release_thread_cache();
+                });
+            }
         }
 
         ~ObjectPool()
         {
-            if (_storage != nullptr) {
-                if (not ::VirtualFree(_storage, 0, MEM_RELEASE))
-                    LOG(error) << "VirtualFree() failed with " << ::GetLastError();
-            }
+            if (thread_caches)
+                deregister_thread_cached_pool(this);
+
+            if (_storage != nullptr)
+                win::release_virtual_memory(_storage, _max_capacity * OBJECT_SIZE);
         }
 
         bool reserve(size_type new_capacity)
         {
-            if (_capacity >= new_capacity)
+            if (_capacity.load(std::memory_order_acquire) >= new_capacity)
+                return true;
+
+            std::lock_guard<std::mutex> lock(capacity_lock);
+
+            // the capacity may be extended by another thread.
+            if (_capacity.load(std::memory_order_relaxed) >= new_capacity)
                 return true;
 
             if (is_exceed_max_capacity())
                 return false;
 
             new_capacity = std::min(new_capacity, _max_capacity);
-            if (::VirtualAlloc(_storage, new_capacity * OBJECT_SIZE, MEM_COMMIT, MEMORY_PROTECTION_LEVEL)) {
-                _capacity = new_capacity;
+            if (win::commit_virtual_memory(_storage, new_capacity * OBJECT_SIZE, _memory_options)) {
+                _capacity.store(new_capacity, std::memory_order_release);
                 return true;
             }
 
@@ -138,27 +220,64 @@ namespace win
             return transition_to_free(index_type(object_ptr - get_object_storage(0)));
         }
 
-        size_type capacity()
+        size_type capacity() const
         {
-            return _capacity;
+            return _capacity.load(std::memory_order_relaxed);
+        }
+
+        // return cached objects of the current thread to the pool.
+        void release_thread_cache()
+        {
+            auto slot = current_thread_cache_slot();
+            if (not thread_caches || slot >= MAX_THREAD_CACHES)
+                return;
+
+            auto& cache = thread_caches[slot];
+            lock_cache(cache);
+            reclaim_remote_frees(cache, cache);
+
+            while (cache.size)
+                release_to_shared(cache.indexes[--cache.size]);
+            unlock_cache(cache);
         }
 
     protected:
+        static constexpr std::uint8_t SHARED_OWNER = 0xFE;
+        static constexpr std::uint8_t NO_OWNER = 0xFF;
+
+        struct alignas(64) ThreadCache
+        {
+            // taken by the owner thread, and by other threads only to drain the magazine.
+            std::atomic<bool> is_locked{ false };
+
+            size_type size = 0;
+            index_type indexes[MAGAZINE_SIZE];
+
+            // objects freed by other threads. (linked through next_free_indexes)
+            alignas(64) std::atomic<index_type> remote_free_head{ INVALID_INDEX };
+        };
 
         template <typename... Args>
         index_type new_object_internal(Args&&... args)
         {
-            auto object_index = get_free_object_index();
-            if (object_index >= _capacity && not extend_capacity(size_type(object_index) + 1))
+            auto object_index = thread_caches ? claim_cached_object_index() : claim_free_object_index();
+            if (object_index == INVALID_INDEX)
                 return INVALID_INDEX;
 
+            if (object_index >= _capacity.load(std::memory_order_acquire) && not extend_capacity(size_type(object_index) + 1)) {
+                if (thread_caches)
+                    object_owners[object_index].store(NO_OWNER, std::memory_order_relaxed);
+                release_to_shared(object_index);
+                return INVALID_INDEX;
+            }
+
             auto new_object_storage = get_object_storage(object_index);
             new (new_object_storage) T(std::forward<Args>(args)...);
             // manually construct using placement new.
             // new operator may simply returns its second argument unchanged.
             // ref. https://en.cppreference.com/w/cpp/language/new
 
-            return transition_to_ready(object_index);
+            return object_index;
         }
 
         auto get_object_storage(index_type object_index) const
@@ -168,54 +287,228 @@ namespace win
 
         inline bool is_exceed_max_capacity() const
         {
-            return _capacity >= _max_capacity;
+            return _capacity.load(std::memory_order_relaxed) >= _max_capacity;
         }
 
         bool extend_capacity(size_type minimum_capacity)
         {
-            return reserve(std::max(_capacity * 2, minimum_capacity));
+            return reserve(std::max(_capacity.load(std::memory_order_relaxed) * 2, minimum_capacity));
         }
 
-        index_type get_free_object_index() const
+        // find a free object through the summary bitmaps and mark it in use.
+        index_type claim_free_object_index()
         {
-            for (index_type i = 0; i < _bitmap_size; i++) {
-                if (auto mask = free_storage_bitmaps[i]) {
-                    unsigned long bit_index;
-                    _BitScanForward64(&bit_index, mask);
-                    return i * SIZE_TYPE_BIT_SIZE + bit_index;
+            for (size_type summary_index = 0; summary_index < _summary_size; summary_index++) {
+                auto& summary = summary_bitmaps[summary_index];
+
+                while (auto summary_mask = summary.load(std::memory_order_acquire)) {
+                    auto leaf_index = summary_index * SIZE_TYPE_BIT_SIZE + std::countr_zero(summary_mask);
+                    auto& leaf = free_storage_bitmaps[leaf_index];
+
+                    auto leaf_mask = leaf.load(std::memory_order_acquire);
+                    while (leaf_mask) {
+                        auto bit = 1ULL << std::countr_zero(leaf_mask);
+                        auto prev_mask = leaf.fetch_and(~bit, std::memory_order_acq_rel);
+
+                        if (prev_mask & bit) {
+                            if (prev_mask == bit)
+                                clear_summary_bit(leaf_index);
+                            return index_type(leaf_index * SIZE_TYPE_BIT_SIZE + std::countr_zero(bit));
+                        }
+                        // claimed by another thread.
+                        leaf_mask = prev_mask & ~bit;
+                    }
+
+                    clear_summary_bit(leaf_index);
                 }
             }
-            return std::numeric_limits<index_type>::max();
+            return INVALID_INDEX;
         }
 
-        index_type transition_to_ready(index_type object_index)
+        void clear_summary_bit(size_type leaf_index)
         {
-            auto bitmap = &free_storage_bitmaps[object_index / SIZE_TYPE_BIT_SIZE];
-            auto bitmap_index = object_index % SIZE_TYPE_BIT_SIZE;
+            auto& summary = summary_bitmaps[leaf_index / SIZE_TYPE_BIT_SIZE];
+            auto summary_bit = 1ULL << (leaf_index % SIZE_TYPE_BIT_SIZE);
 
-            *bitmap &= ~(1ULL << bitmap_index);
-            return object_index;
+            summary.fetch_and(~summary_bit);
+
+            // an object may be freed before the summary bit is cleared.
+            if (free_storage_bitmaps[leaf_index].load())
+                summary.fetch_or(summary_bit);
         }
 
         bool transition_to_free(index_type object_index)
+        {
+            return thread_caches ? release_to_cache(object_index) : release_to_shared(object_index);
+        }
+
+        bool release_to_shared(index_type object_index)
         {
             assert(object_index >= 0);
-            auto bitmap = &free_storage_bitmaps[object_index / SIZE_TYPE_BIT_SIZE];
-            auto bitmap_index = object_index % SIZE_TYPE_BIT_SIZE;
-            bool prev_state = *bitmap & (1ULL << bitmap_index);
+            auto leaf_index = object_index / SIZE_TYPE_BIT_SIZE;
+            auto bit = 1ULL << (object_index % SIZE_TYPE_BIT_SIZE);
 
-            *bitmap |= 1ULL << bitmap_index;
-            return prev_state == false; // check it was in use.
+            auto prev_mask = free_storage_bitmaps[leaf_index].fetch_or(bit);
+
+            auto& summary = summary_bitmaps[leaf_index / SIZE_TYPE_BIT_SIZE];
+            auto summary_bit = 1ULL << (leaf_index % SIZE_TYPE_BIT_SIZE);
+            if ((summary.load() & summary_bit) == 0)
+                summary.fetch_or(summary_bit);
+
+            return (prev_mask & bit) == 0; // check it was in use.
         }
 
-    private:
+        /* thread cache */
+
+        index_type claim_cached_object_index()
+        {
+            auto slot = current_thread_cache_slot();
+            auto object_index = INVALID_INDEX;
+
+            if (slot < MAX_THREAD_CACHES) {
+                auto& cache = thread_caches[slot];
+                lock_cache(cache);
 
+                if (cache.size == 0)
+                    refill_thread_cache(cache);
+
+                // the pool is exhausted. take objects freed for other threads.
+                if (cache.size == 0)
+                    steal_remote_frees(slot, cache);
+
+                if (cache.size)
+                    object_index = cache.indexes[--cache.size];
+                unlock_cache(cache);
+            }
+            else
+                object_index = claim_free_object_index();
+
+            // return objects cached by other threads to the pool, so that max_capacity objects can be allocated.
+            if (object_index == INVALID_INDEX) {
+                drain_thread_caches(slot);
+                object_index = claim_free_object_index();
+            }
+
+            if (object_index != INVALID_INDEX)
+                object_owners[object_index].store(slot < MAX_THREAD_CACHES ? std::uint8_t(slot) : SHARED_OWNER, std::memory_order_relaxed);
+            return object_index;
+        }
+
+        bool release_to_cache(index_type object_index)
+        {
+            // only the thread freeing the object accesses its owner, so no read-modify-write is needed.
+            auto owner = object_owners[object_index].load(std::memory_order_relaxed);
+            if (owner == NO_OWNER)
+                return false; // already freed.
+
+            object_owners[object_index].store(NO_OWNER, std::memory_order_relaxed);
+
+            if (owner == SHARED_OWNER)
+                return release_to_shared(object_index);
+
+            auto slot = current_thread_cache_slot();
+            if (owner != slot) {
+                push_remote_free(thread_caches[owner], object_index);
+                return true;
+            }
+
+            auto& cache = thread_caches[slot];
+            lock_cache(cache);
+
+            if (cache.size == MAGAZINE_SIZE) {
+                // drain a batch to the pool.
+                for (size_type i = 0; i < MAGAZINE_BATCH_SIZE; i++)
+                    release_to_shared(cache.indexes[--cache.size]);
+            }
+
+            cache.indexes[cache.size++] = object_index;
+            unlock_cache(cache);
+            return true;
+        }
+
+        void refill_thread_cache(ThreadCache& cache)
+        {
+            reclaim_remote_frees(cache, cache);
+
+            while (cache.size < MAGAZINE_BATCH_SIZE) {
+                auto object_index = claim_free_object_index();
+                if (object_index == INVALID_INDEX)
+                    break;
+                cache.indexes[cache.size++] = object_index;
+            }
+        }
+
+        // move the remote-free list of the source cache to the magazine of the current thread.
+        void reclaim_remote_frees(ThreadCache& source, ThreadCache& cache)
+        {
+            auto object_index = source.remote_free_head.exchange(INVALID_INDEX, std::memory_order_acquire);
+
+            for (; object_index != INVALID_INDEX; object_index = next_free_indexes[object_index]) {
+                if (cache.size < MAGAZINE_SIZE)
+                    cache.indexes[cache.size++] = object_index;
+                else
+                    release_to_shared(object_index);
+            }
+        }
+
+        void steal_remote_frees(size_type slot, ThreadCache& cache)
+        {
+            for (size_type i = 0; i < MAX_THREAD_CACHES && cache.size == 0; i++) {
+                if (i != slot && thread_caches[i].remote_free_head.load(std::memory_order_relaxed) != INVALID_INDEX)
+                    reclaim_remote_frees(thread_caches[i], cache);
+            }
+        }
+
+        // the own cache must not be locked, not to deadlock with another thread draining.
+        void drain_thread_caches(size_type slot)
+        {
+            for (size_type i = 0; i < MAX_THREAD_CACHES; i++) {
+                if (i == slot)
+                    continue;
+
+                auto& cache = thread_caches[i];
+                lock_cache(cache);
+                while (cache.size)
+                    release_to_shared(cache.indexes[--cache.size]);
+                unlock_cache(cache);
+            }
+        }
+
+        void lock_cache(ThreadCache& cache)
+        {
+            while (cache.is_locked.exchange(true, std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+
+        void unlock_cache(ThreadCache& cache)
+        {
+            cache.is_locked.store(false, std::memory_order_release);
+        }
+
+        void push_remote_free(ThreadCache& cache, index_type object_index)
+        {
+            auto head = cache.remote_free_head.load(std::memory_order_relaxed);
+            do {
+                next_free_indexes[object_index] = head;
+            } while (not cache.remote_free_head.compare_exchange_weak(head, object_index,
+                std::memory_order_release, std::memory_order_relaxed));
+        }
+
+    private:
         std::byte *_storage;
-        size_type _capacity;
+        const win::VirtualMemoryOptions _memory_options;
+        std::atomic<size_type> _capacity;
         const size_type _max_capacity;
+        std::mutex capacity_lock;
         
         const size_type _bitmap_size;
-        std::unique_ptr<size_type[]> free_storage_bitmaps;
+        const size_type _summary_size;
+        std::unique_ptr<bitmap_type[]> free_storage_bitmaps;
+        std::unique_ptr<bitmap_type[]> summary_bitmaps;
+
+        std::unique_ptr<ThreadCache[]> thread_caches;
+        std::unique_ptr<std::atomic<std::uint8_t>[]> object_owners;
+        std::unique_ptr<index_type[]> next_free_indexes;
     };
 
     template <typename T, std::size_t OBJECT_SIZE = sizeof(T)>
@@ -300,8 +593,9 @@ namespace win
 
         ObjectGlobalPool() = delete;
 
-        ObjectGlobalPool(super_type::size_type max_capacity)
-            : super_type{ max_capacity }
+        ObjectGlobalPool(super_type::size_type max_capacity, bool use_thread_cache = false,
+                         const win::VirtualMemoryOptions& memory_options = win::default_memory_options())
+            : super_type{ max_capacity, use_thread_cache, memory_options }
             , _pool_index{ num_of_free_object_pool.fetch_sub(1) }
         {
             if (not _pool_index)
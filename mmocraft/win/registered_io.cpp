@@ -2,6 +2,7 @@
 #include "registered_io.h"
 
 #include "net/socket.h"
+#include "win/virtual_memory.h"
 
 namespace win
 {
@@ -39,9 +40,13 @@ namespace win
         , _buffer_size{ buffer_size }
 
         , is_buffer_allocated{ true }
-        , _buffer{ ::VirtualAlloc(0, buffer_size * pool_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE) }
-        , _buffer_id{ create_buffer(_buffer, buffer_size * pool_size) }
-    { }
+        , _buffer{ win::reserve_virtual_memory(buffer_size * pool_size) }
+        , _buffer_id{ RIO_INVALID_BUFFERID }
+    {
+        // buffers are placed on the numa node of event threads.
+        if (_buffer && win::commit_virtual_memory(_buffer, buffer_size * pool_size))
+            _buffer_id = create_buffer(_buffer, buffer_size * pool_size);
+    }
 
     RioBufferPool::RioBufferPool(void* buf, std::size_t buf_size)
         : _pool_size{ 1 }
@@ -56,7 +61,7 @@ namespace win
             net::rio_api().RIODeregisterBuffer(id());
 
         if (is_buffer_allocated && _buffer != nullptr)
-            ::VirtualFree(_buffer, 0, MEM_RELEASE);
+            win::release_virtual_memory(_buffer, _buffer_size * _pool_size);
     }
 
     RIO_BUFFERID RioBufferPool::create_buffer(void* buffer, std::size_t buffer_size)
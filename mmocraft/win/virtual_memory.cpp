@@ -0,0 +1,68 @@
+#include "pch.h"
+#include "virtual_memory.h"
+
+#include "logging/logger.h"
+
+namespace
+{
+    win::VirtualMemoryOptions g_default_memory_options;
+}
+
+namespace win
+{
+    const VirtualMemoryOptions& default_memory_options()
+    {
+        return g_default_memory_options;
+    }
+
+    void set_default_memory_options(const VirtualMemoryOptions& options)
+    {
+        g_default_memory_options = options;
+    }
+
+#ifdef _WIN32
+    void* reserve_virtual_memory(std::size_t size)
+    {
+        return ::VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_READWRITE);
+    }
+
+    bool commit_virtual_memory(void* address, std::size_t size, const VirtualMemoryOptions& options)
+    {
+        // Note: large pages must be reserved and committed at once on Windows,
+        //       so huge_pages is ignored for incrementally committed memory.
+        if (options.numa_node != any_numa_node)
+            return ::VirtualAllocExNuma(::GetCurrentProcess(), address, size, MEM_COMMIT, PAGE_READWRITE, DWORD(options.numa_node)) != NULL;
+
+        return ::VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+    }
+
+    bool release_virtual_memory(void* address, std::size_t)
+    {
+        if (not ::VirtualFree(address, 0, MEM_RELEASE)) {
+            LOG(error) << "VirtualFree() failed with " << ::GetLastError();
+            return false;
+        }
+        return true;
+    }
+
+    int current_numa_node()
+    {
+        PROCESSOR_NUMBER processor;
+        ::GetCurrentProcessorNumberEx(&processor);
+
+        USHORT numa_node = 0;
+        return ::GetNumaProcessorNodeEx(&processor, &numa_node) ? int(numa_node) : any_numa_node;
+    }
+
+    bool bind_current_thread_to_numa_node(int numa_node)
+    {
+        GROUP_AFFINITY affinity;
+        if (not ::GetNumaNodeProcessorMaskEx(USHORT(numa_node), &affinity)) {
+            CONSOLE_LOG(error) << "Unable to get processors of the numa node " << numa_node;
+            return false;
+        }
+
+        return ::SetThreadGroupAffinity(::GetCurrentThread(), &affinity, NULL);
+    }
+#endif
+}
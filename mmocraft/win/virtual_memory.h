@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+namespace win
+{
+    constexpr int any_numa_node = -1;
+
+    struct VirtualMemoryOptions
+    {
+        // back committed pages with transparent huge pages. (POSIX only)
+        bool huge_pages = false;
+
+        // prefer physical pages of the node. (any_numa_node: no binding)
+        int numa_node = any_numa_node;
+    };
+
+    // options used by pools unless specified. (set at the system initialization)
+    const VirtualMemoryOptions& default_memory_options();
+
+    void set_default_memory_options(const VirtualMemoryOptions&);
+
+    // reserve address space without physical pages. returns nullptr on failure.
+    void* reserve_virtual_memory(std::size_t size);
+
+    // commit the range of the reserved address space. committing already committed pages is allowed.
+    bool commit_virtual_memory(void* address, std::size_t size, const VirtualMemoryOptions& = default_memory_options());
+
+    // release the whole reservation.
+    bool release_virtual_memory(void* address, std::size_t reserved_size);
+
+    int current_numa_node();
+
+    // run the calling thread only on the processors of the node.
+    bool bind_current_thread_to_numa_node(int numa_node);
+}
@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "virtual_memory.h"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "logging/logger.h"
+
+namespace
+{
+    // from <numaif.h>, to avoid the libnuma dependency.
+    constexpr int MPOL_PREFERRED = 1;
+
+    constexpr int max_numa_nodes = 64;
+}
+
+namespace win
+{
+    void* reserve_virtual_memory(std::size_t size)
+    {
+        auto address = ::mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        return address == MAP_FAILED ? nullptr : address;
+    }
+
+    bool commit_virtual_memory(void* address, std::size_t size, const VirtualMemoryOptions& options)
+    {
+        if (::mprotect(address, size, PROT_READ | PROT_WRITE) != 0) {
+            LOG(error) << "mprotect() failed with " << std::strerror(errno);
+            return false;
+        }
+
+#ifdef MADV_HUGEPAGE
+        if (options.huge_pages)
+            ::madvise(address, size, MADV_HUGEPAGE);
+#endif
+
+#ifdef SYS_mbind
+        // pages are placed on the node at the first touch.
+        if (options.numa_node != any_numa_node && options.numa_node < max_numa_nodes) {
+            unsigned long node_mask = 1UL << options.numa_node;
+            if (::syscall(SYS_mbind, address, size, MPOL_PREFERRED, &node_mask, max_numa_nodes + 1, 0) != 0)
+                LOG(warn) << "mbind() failed with " << std::strerror(errno);
+        }
+#endif
+
+        return true;
+    }
+
+    bool release_virtual_memory(void* address, std::size_t reserved_size)
+    {
+        if (::munmap(address, reserved_size) != 0) {
+            LOG(error) << "munmap() failed with " << std::strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    int current_numa_node()
+    {
+        unsigned cpu = 0, numa_node = 0;
+        return ::syscall(SYS_getcpu, &cpu, &numa_node, nullptr) == 0 ? int(numa_node) : any_numa_node;
+    }
+
+    bool bind_current_thread_to_numa_node(int numa_node)
+    {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+
+        // processors of the node are listed in sysfs.
+        auto cpulist_path = "/sys/devices/system/node/node" + std::to_string(numa_node) + "/cpulist";
+        std::ifstream cpulist(cpulist_path);
+        if (not cpulist) {
+            CONSOLE_LOG(error) << "Unable to get processors of the numa node " << numa_node;
+            return false;
+        }
+
+        // format: "0-3,8-11"
+        std::string range;
+        while (std::getline(cpulist, range, ',')) {
+            int first = 0, last = 0;
+            auto num_of_fields = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+            if (num_of_fields < 1)
+                continue;
+            if (num_of_fields == 1)
+                last = first;
+
+            for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+                CPU_SET(cpu, &cpu_set);
+        }
+
+        return ::sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+    }
+}
+
+#endif